@@ -1,34 +1,164 @@
 #include "acl.h"
 #if OPTION_ACL
-#include "dram.h"
+#include "pmt.h"
+#include "mem_util.h"
 
-#define vp2idx(vp)			(PAGES_PER_BANK * (vp).bank + \
-						(vp).vpn)
-#define ACL_TABLE_ENTRY(vp)		(ACL_TABLE_ADDR + vp2idx(vp) * \
-						sizeof(user_id_t))
+/* ==========================================================================
+ * Session Table
+ * ========================================================================*/
 
-void acl_init()
+/* The session table is an open-addressing hash table with linear probing.
+ * Each slot is 8 bytes: session key (0 means empty) and user id. */
+#define NULL_SKEY		0
+#define SLOT_ADDR(i)		(SESSION_TABLE_ADDR + (i) * 2 * sizeof(UINT32))
+#define slot_skey(i)		read_dram_32(SLOT_ADDR(i))
+#define slot_uid(i)		((user_id_t)read_dram_32(SLOT_ADDR(i) + \
+							 sizeof(UINT32)))
+#define set_slot(i, skey, uid)	do {\
+					write_dram_32(SLOT_ADDR(i), (skey));\
+					write_dram_32(SLOT_ADDR(i) + \
+						      sizeof(UINT32), (uid));\
+				} while(0)
+#define next_slot(i)		(((i) + 1) & (SESSION_TABLE_SLOTS - 1))
+
+/* Fibonacci hashing */
+#define home_slot(skey)		(((UINT32)(skey) * 2654435761u) >> \
+				 (32 - SESSION_TABLE_BITS))
+
+#define USER_EPOCH_ADDR(uid)	(USER_EPOCH_TABLE_ADDR + (uid) * sizeof(UINT8))
+#define user_epoch(uid)		read_dram_8(USER_EPOCH_ADDR(uid))
+#define tag_uid(uid)		((user_id_t)((uid) | \
+					     (user_epoch(uid) << ACL_UID_BITS)))
+
+static UINT32		num_sessions;
+/* most commands in a row come from the same session */
+static UINT32		last_skey;
+static user_id_t	last_uid;
+
+/* Return the slot that holds *skey*, or the empty slot where *skey* would
+ * be inserted */
+static UINT32 find_slot(UINT32 const skey)
+{
+	UINT32 i = home_slot(skey);
+	while (1) {
+		UINT32 i_skey = slot_skey(i);
+		if (i_skey == skey || i_skey == NULL_SKEY) return i;
+		i = next_slot(i);
+	}
+}
+
+/* Is slot *k* out of the cyclic range (*i*, *j*]? */
+#define is_out_of_range(k, i, j)	((i) <= (j) ? \
+					 ((k) <= (i) || (k) > (j)) : \
+					 ((k) <= (i) && (k) > (j)))
+
+/* Backward-shift deletion, so that no tombstone is needed */
+static void remove_slot(UINT32 i)
+{
+	UINT32 j = i;
+	while (1) {
+		j = next_slot(j);
+		UINT32 j_skey = slot_skey(j);
+		if (j_skey == NULL_SKEY) break;
+
+		if (is_out_of_range(home_slot(j_skey), i, j)) {
+			set_slot(i, j_skey, slot_uid(j));
+			i = j;
+		}
+	}
+	set_slot(i, NULL_SKEY, DEFAULT_USER_ID);
+}
+
+/* ==========================================================================
+ * Public Functions
+ * ========================================================================*/
+
+void acl_init(void)
+{
+	mem_set_dram(SESSION_TABLE_ADDR, 0, SESSION_TABLE_BYTES);
+	num_sessions = 0;
+
+	mem_set_dram(USER_EPOCH_TABLE_ADDR, 0, USER_EPOCH_TABLE_BYTES);
+
+	last_skey = NULL_SKEY;
+	last_uid  = DEFAULT_USER_ID;
+}
+
+BOOL8 acl_open_session(UINT32 const skey, user_id_t const uid)
 {
-	ASSERT(DEFAULT_USER_ID == 0);
-	mem_set_dram(ACL_TABLE_ADDR, 0, ACL_TABLE_BYTES);
+	if (skey == NULL_SKEY || uid >= ACL_MAX_USERS) return FALSE;
+
+	UINT32 i = find_slot(skey);
+	if (slot_skey(i) == NULL_SKEY) {
+		if (num_sessions == ACL_MAX_SESSIONS) return FALSE;
+		num_sessions++;
+	}
+	set_slot(i, skey, uid);
+
+	if (skey == last_skey) last_uid = tag_uid(uid);
+	return TRUE;
+}
+
+void acl_close_session(UINT32 const skey)
+{
+	if (skey == NULL_SKEY) return;
+
+	UINT32 i = find_slot(skey);
+	if (slot_skey(i) == NULL_SKEY) return;
+
+	remove_slot(i);
+	num_sessions--;
+
+	if (skey == last_skey) last_uid = tag_uid(DEFAULT_USER_ID);
 }
 
 user_id_t acl_skey2uid(UINT32 const skey)
 {
-	return (user_id_t)skey;
+	if (skey == last_skey) return last_uid;
+
+	UINT32 i = find_slot(skey);
+	last_skey = skey;
+	last_uid  = tag_uid(slot_skey(i) == NULL_SKEY ?
+				DEFAULT_USER_ID : slot_uid(i));
+	return last_uid;
+}
+
+BOOL8 acl_revoke_user(user_id_t const uid)
+{
+	if (uid >= ACL_MAX_USERS) return FALSE;
+
+	UINT8 epoch = user_epoch(uid);
+	if (epoch == (1 << ACL_EPOCH_BITS) - 1) return FALSE;
+	write_dram_8(USER_EPOCH_ADDR(uid), epoch + 1);
+
+	/* the cached user id may be tagged with the old epoch */
+	last_skey = NULL_SKEY;
+	last_uid  = tag_uid(DEFAULT_USER_ID);
+	return TRUE;
 }
 
-BOOL8 acl_authenticate(user_id_t const uid, vp_t const vp)
+BOOL8 acl_is_revoked(user_id_t const tagged_uid)
+{
+	return tagged_uid != tag_uid(acl_untag_uid(tagged_uid));
+}
+
+/* ==========================================================================
+ * Access Control
+ * ========================================================================*/
+
+BOOL8 acl_authenticate(user_id_t const uid, UINT32 const lpn, UINT8 const sp_i)
 {
+	/* sub-page that is never written can be read by anyone */
+	vp_t vp;
+	pmt_get_vp(lpn, sp_i, &vp);
 	if (vp.vpn == 0) return TRUE;
 
-	user_id_t expected_uid = (user_id_t) read_dram_16(ACL_TABLE_ENTRY(vp));
+	user_id_t expected_uid = pmt_get_uid(lpn, sp_i);
 	return expected_uid == uid;
 }
 
-void acl_authorize(user_id_t const uid, vp_t const vp)
+void acl_authorize(user_id_t const uid, UINT32 const lpn, UINT8 const sp_i)
 {
-	ASSERT(vp.vpn != 0);
-	write_dram_16(ACL_TABLE_ENTRY(vp), uid);
+	pmt_update_uid(lpn, sp_i, uid);
 }
 #endif
@@ -3,11 +3,73 @@
 
 #include "jasmine.h"
 #if OPTION_ACL
+#include "dram.h"
 
+/*
+ * ACL = access control layer
+ *
+ * The owner of a logical sub-page is the user who writes it last. Owners are
+ * kept in PMT (see pmt.h), so the PMT entry of a page must be loaded before
+ * authentication or authorization.
+ * */
+
+/*
+ * Sessions
+ *
+ * Every command carries a session key given by the host. The user of the
+ * command is the one who opens the session (see ata_tssd_session() in
+ * sata_cmd.c). Commands whose session key is 0 or is not opened are issued
+ * by DEFAULT_USER_ID.
+ *
+ * Sessions are kept in a hash table in DRAM, so the number of concurrent
+ * sessions is bounded by ACL_MAX_SESSIONS. Sessions are not persistent.
+ * */
+#define ACL_MAX_SESSIONS	(SESSION_TABLE_SLOTS / 2)
+
+/*
+ * Revocation
+ *
+ * A user is revoked in O(1) by bumping the epoch of the user. The user ids
+ * passed around in FTL, and thus kept as owners in PMT and write buffer, are
+ * tagged with the epoch of the user at the time the command is accepted (see
+ * acl_skey2uid()). After revocation, the sub-pages written before no longer
+ * pass authentication and are read as 0s, while the user can go on writing
+ * new data. With FDE, the key of a user is derived from the tagged user id,
+ * so the new data of the user is encrypted with a new key (see fde.h).
+ *
+ * Revocation is not a crypto-erase: revoked sub-pages stay in flash until GC
+ * reclaims their blocks, and their keys can still be derived from the master
+ * key. GC drops revoked sub-pages instead of relocating them and unmaps them,
+ * after which they are read as never written.
+ *
+ * Epochs never wrap around, as a sub-page that outlives 2^ACL_EPOCH_BITS
+ * revocations of its owner would become readable again; a user can be
+ * revoked at most 2^ACL_EPOCH_BITS - 1 times.
+ * */
+#define ACL_UID_BITS		USER_EPOCH_TABLE_BITS
+#define ACL_EPOCH_BITS		(sizeof(user_id_t) * 8 - ACL_UID_BITS)
+/* the last user id is reserved, so that no tagged user id is NULL_USER_ID */
+#define ACL_MAX_USERS		(USER_EPOCH_TABLE_ENTRIES - 1)
+
+#define acl_untag_uid(uid)	((user_id_t)((uid) & \
+					     (USER_EPOCH_TABLE_ENTRIES - 1)))
+
+void acl_init(void);
+
+/* Return FALSE if the session table is full or *uid* is invalid */
+BOOL8 acl_open_session(UINT32 const skey, user_id_t const uid);
+void acl_close_session(UINT32 const skey);
+
+/* Return the user id tagged with the current epoch of the user */
 user_id_t acl_skey2uid(UINT32 const skey);
 
-BOOL8 acl_authenticate(user_id_t const uid, vp_t const vp);
-void acl_authorize(user_id_t const uid, vp_t const vp);
+/* Return FALSE if *uid* is invalid or has run out of epochs */
+BOOL8 acl_revoke_user(user_id_t const uid);
+/* Whether the owner of a sub-page, i.e. a tagged user id, has been revoked */
+BOOL8 acl_is_revoked(user_id_t const tagged_uid);
+
+BOOL8 acl_authenticate(user_id_t const uid, UINT32 const lpn, UINT8 const sp_i);
+void acl_authorize(user_id_t const uid, UINT32 const lpn, UINT8 const sp_i);
 
 #endif
 #endif
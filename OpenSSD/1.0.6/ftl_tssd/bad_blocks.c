@@ -16,7 +16,7 @@ void bb_init()
 	INFO("bb>init", "bad block bitmap initialization");
 	
 	mem_set_dram(BAD_BLK_BMP_ADDR, 0, BAD_BLK_BMP_BYTES);
-	mem_set_sram(_bad_blcks_cnt, 0, NUM_BANKS);
+	mem_set_sram(_bad_blcks_cnt, 0, sizeof(_bad_blcks_cnt));
 
 	FOR_EACH_BANK(bank)	
 	{
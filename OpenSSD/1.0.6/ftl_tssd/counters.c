@@ -0,0 +1,58 @@
+#include "counters.h"
+#include "mem_util.h"
+
+counters_t g_counters;
+
+/* the log of counters is one sector */
+typedef UINT8 counters_fit_in_sector_t
+		[sizeof(counters_t) <= BYTES_PER_SECTOR ? 1 : -1];
+
+void counters_init()
+{
+	mem_set_sram(&g_counters, 0, sizeof(g_counters));
+	g_counters.magic	= COUNTERS_MAGIC;
+	g_counters.version	= COUNTERS_VERSION;
+	g_counters.num_counters	= NUM_COUNTERS;
+	g_counters.num_banks	= NUM_BANKS;
+}
+
+void counters_sample_threads(UINT8 const num_threads)
+{
+	counter_inc(COUNTER_THREAD_SAMPLES);
+	counter_add(COUNTER_THREAD_OCCUPANCY, num_threads);
+	if (num_threads > counter_get(COUNTER_THREAD_PEAK))
+		counter_get(COUNTER_THREAD_PEAK) = num_threads;
+}
+
+#define delta(id)	(counter_get(id) - (base ? base->counters[id] : 0))
+
+static UINT32 percent(UINT32 const num, UINT32 const den)
+{
+	return den ? (UINT32)((UINT64)num * 100 / den) : 0;
+}
+
+UINT32 counters_waf_percent(counters_t const *base)
+{
+	UINT32 sub_pages = delta(COUNTER_USER_PROGRAM_SUB_PAGES) +
+			   delta(COUNTER_PMT_PROGRAM_SUB_PAGES) +
+			   delta(COUNTER_META_PROGRAM_SUB_PAGES) +
+			   delta(COUNTER_GC_PROGRAM_SUB_PAGES);
+	return percent(sub_pages * SECTORS_PER_SUB_PAGE,
+		       delta(COUNTER_HOST_WRITE_SECTORS));
+}
+
+UINT32 counters_pmt_overhead_percent(counters_t const *base)
+{
+	return percent(delta(COUNTER_PMT_PROGRAM_SUB_PAGES),
+		       delta(COUNTER_USER_PROGRAM_SUB_PAGES));
+}
+
+void counters_export(UINT32 const buf)
+{
+	counter_get(COUNTER_WAF_PERCENT) = counters_waf_percent(NULL);
+	counter_get(COUNTER_PMT_OVERHEAD_PERCENT) =
+		counters_pmt_overhead_percent(NULL);
+
+	mem_set_dram(buf, 0, BYTES_PER_SECTOR);
+	mem_copy(buf, &g_counters, sizeof(g_counters));
+}
@@ -0,0 +1,90 @@
+#ifndef __COUNTERS_H
+#define __COUNTERS_H
+
+/*
+ * Counters -- performance counters of FTL
+ *
+ * All counters live in one structure, which is also the layout of the vendor
+ * specific SMART log TSSD_LOG_COUNTERS (see ata_smart()), so that hosts can
+ * scrape them from production drives (see examples/counters.c). Counters are
+ * 32-bit and wrap around; hosts are expected to take the difference of two
+ * readings.
+ * */
+
+#include "jasmine.h"
+
+#define COUNTERS_MAGIC		0x43505354	/* "TSPC" */
+#define COUNTERS_VERSION	2
+
+typedef enum {
+	/* sectors requested by host */
+	COUNTER_HOST_READ_SECTORS,
+	COUNTER_HOST_WRITE_SECTORS,
+	/* sectors transferred between DRAM and flash */
+	COUNTER_FLASH_READ_SECTORS,
+	COUNTER_FLASH_WRITE_SECTORS,
+	COUNTER_FLASH_COPYBACKS,
+	/* a PMT miss is a load of PMT sub-page from flash; hits are lookups
+	 * minus misses */
+	COUNTER_PMT_LOOKUPS,
+	COUNTER_PMT_MISSES,
+	COUNTER_PMT_FLUSHES,
+	/* sectors of reads that are served by write buffer */
+	COUNTER_WRITE_BUFFER_HIT_SECTORS,
+	COUNTER_WRITE_BUFFER_FLUSHES,
+	COUNTER_WRITE_BUFFER_FLUSH_SECTORS,
+	/* requests of page locks that cannot be granted */
+	COUNTER_LOCK_WAITS,
+	/* threads in use, sampled every round of scheduling */
+	COUNTER_THREAD_SAMPLES,
+	COUNTER_THREAD_OCCUPANCY,
+	COUNTER_THREAD_PEAK,
+	/* sub-pages programmed on behalf of each source (see fla.h), including
+	 * the whole pages of copybacks */
+	COUNTER_USER_PROGRAM_SUB_PAGES,
+	COUNTER_PMT_PROGRAM_SUB_PAGES,
+	COUNTER_META_PROGRAM_SUB_PAGES,
+	COUNTER_GC_PROGRAM_SUB_PAGES,
+	/* derived from other counters when exported, in percent */
+	COUNTER_WAF_PERCENT,
+	COUNTER_PMT_OVERHEAD_PERCENT,
+	NUM_COUNTERS
+} counter_id_t;
+
+/* flash commands of each bank, including the ones for metadata; a copyback
+ * is both a read and a program */
+typedef enum {
+	BANK_COUNTER_FLASH_READS,
+	BANK_COUNTER_FLASH_PROGRAMS,
+	BANK_COUNTER_FLASH_ERASES,
+	NUM_BANK_COUNTERS
+} bank_counter_id_t;
+
+typedef struct {
+	UINT32	magic;
+	UINT32	version;
+	UINT32	num_counters;
+	UINT32	num_banks;
+	UINT32	counters[NUM_COUNTERS];
+	UINT32	bank_counters[NUM_BANK_COUNTERS][NUM_BANKS];
+} counters_t;
+
+extern counters_t g_counters;
+
+#define counter_add(id, n)		(g_counters.counters[id] += (n))
+#define counter_inc(id)			counter_add(id, 1)
+#define counter_get(id)			(g_counters.counters[id])
+#define bank_counter_inc(id, bank)	(g_counters.bank_counters[id][bank]++)
+#define bank_counter_get(id, bank)	(g_counters.bank_counters[id][bank])
+
+void counters_init();
+void counters_sample_threads(UINT8 const num_threads);
+/* Write amplification, i.e. sectors programmed over sectors written by host,
+ * and PMT overhead, i.e. PMT sub-pages programmed over user sub-pages
+ * programmed, in percent, since *base* was taken (or since boot if NULL) */
+UINT32 counters_waf_percent(counters_t const *base);
+UINT32 counters_pmt_overhead_percent(counters_t const *base);
+/* Write counters as one sector into DRAM buffer */
+void counters_export(UINT32 const buf);
+
+#endif
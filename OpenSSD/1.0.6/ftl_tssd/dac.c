@@ -0,0 +1,78 @@
+#include "dac.h"
+#include "dram.h"
+#include "mem_util.h"
+
+/* ==========================================================================
+ * Macros and Data Structure
+ * ========================================================================*/
+
+/* Each entry of DAC table is 32-bit: the high 24 bits are the epoch when the
+ * entry is last updated and the low byte is the update count of the region.
+ * The count is decayed lazily when the entry is accessed. An entry that is not
+ * updated for long must never look recent again, so when the epoch wraps
+ * around (after 2^24 epochs), the whole table is reset. */
+#define DAC_TABLE_ENTRY(lpn)	(DAC_TABLE_ADDR + \
+				 ((lpn) / DAC_PAGES_PER_REGION) * sizeof(UINT32))
+#define DAC_EPOCH_MASK		0x00FFFFFF
+#define entry_epoch(entry)	((entry) >> 8)
+#define entry_count(entry)	((UINT8)(entry))
+#define make_entry(epoch, count)	(((epoch) << 8) | (count))
+
+#define DAC_EPOCH_WRITES	(16 * 1024)
+#define DAC_MAX_COUNT		0xFF
+
+static UINT32	current_epoch;
+static UINT32	num_writes_in_epoch;
+
+/* ==========================================================================
+ * Private Functions
+ * ========================================================================*/
+
+static UINT8 get_decayed_count(UINT32 const entry)
+{
+	UINT32 elapsed_epochs = current_epoch - entry_epoch(entry);
+	if (elapsed_epochs >= 8) return 0;
+	return entry_count(entry) >> elapsed_epochs;
+}
+
+/* ==========================================================================
+ * Public Functions
+ * ========================================================================*/
+
+void dac_init(void)
+{
+	current_epoch	    = 0;
+	num_writes_in_epoch = 0;
+	mem_set_dram(DAC_TABLE_ADDR, 0, DAC_TABLE_BYTES);
+}
+
+void dac_record_write(UINT32 const lpn)
+{
+	ASSERT(lpn < PMT_ENTRIES);
+
+	UINT32 entry_addr = DAC_TABLE_ENTRY(lpn);
+	UINT8  count = get_decayed_count(read_dram_32(entry_addr));
+	if (count < DAC_MAX_COUNT) count++;
+	write_dram_32(entry_addr, make_entry(current_epoch, count));
+
+	if (++num_writes_in_epoch == DAC_EPOCH_WRITES) {
+		num_writes_in_epoch = 0;
+		current_epoch = (current_epoch + 1) & DAC_EPOCH_MASK;
+		if (current_epoch == 0)
+			mem_set_dram(DAC_TABLE_ADDR, 0, DAC_TABLE_BYTES);
+	}
+}
+
+UINT8 dac_get_temperature(UINT32 const lpn)
+{
+	ASSERT(lpn < PMT_ENTRIES);
+
+	/* count 0-1 --> 0, 2-3 --> 1, 4-7 --> 2, ... */
+	UINT8 count = get_decayed_count(read_dram_32(DAC_TABLE_ENTRY(lpn)));
+	UINT8 temp  = 0;
+	while (count > 1 && temp < DAC_NUM_TEMPERATURES - 1) {
+		count >>= 1;
+		temp++;
+	}
+	return temp;
+}
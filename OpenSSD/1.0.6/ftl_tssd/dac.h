@@ -0,0 +1,29 @@
+#ifndef __DAC_H
+#define __DAC_H
+
+#include "jasmine.h"
+#include "gc.h"
+
+/* *
+ * DAC = dynamic data clustering
+ *
+ * DAC estimates the temperature of logical pages, i.e. how frequently they
+ * are updated, so that hot and cold data are written to different allocation
+ * streams (see gc.h) and blocks tend to hold data that die together.
+ *
+ * In the spirit of ftl_dac, temperature is tracked per LPN region instead of
+ * per page. Each region has an update counter, which is halved every epoch
+ * (a fixed number of page writes) so that regions that are no longer updated
+ * cool down. The hotter the region, the higher the temperature.
+ * */
+
+#define DAC_NUM_TEMPERATURES	GC_NUM_TEMPERATURES
+
+void  dac_init(void);
+
+/* Called for every program of a logical page with data of host writes */
+void  dac_record_write(UINT32 const lpn);
+/* Return a temperature in [0, DAC_NUM_TEMPERATURES); 0 is the coldest */
+UINT8 dac_get_temperature(UINT32 const lpn);
+
+#endif /* __DAC_H */
@@ -14,7 +14,14 @@
 #define PC_END			(PC_ADDR + PC_BYTES)
 #define MIN_NUM_PC_BUFFERS	MAX_NUM_THREADS
 /* #define NUM_PC_BUFFERS		MIN_NUM_PC_BUFFERS */
+#ifndef NUM_PC_BUFFERS
+#if OPTION_ACL
+/* PMT entries are larger as they keep owners (see pmt.h) */
+#define NUM_PC_BUFFERS		96
+#else
 #define NUM_PC_BUFFERS		64
+#endif
+#endif
 #define NUM_PC_SUB_PAGES	(NUM_PC_BUFFERS * SUB_PAGES_PER_PAGE)
 #define PC_BYTES		(NUM_PC_BUFFERS * BYTES_PER_PAGE)
 #define PC_SUB_PAGE(i)		(PC_ADDR + BYTES_PER_SUB_PAGE * (i))
@@ -63,7 +70,9 @@
  * ========================================================================= */
 
 #define NUM_READ_BUFFERS	2
+#ifndef NUM_WRITE_BUFFERS
 #define NUM_WRITE_BUFFERS	8
+#endif
 
 #define READ_BUF_ADDR		GTD_END
 #define READ_BUF_BYTES		(NUM_READ_BUFFERS * BYTES_PER_PAGE)
@@ -76,30 +85,120 @@
 /* Write buffer use managed buffer */
 
 /* ========================================================================= *
- * ACL Table
+ * DAC Table
+ * ========================================================================= */
+
+/* update statistics of each LPN region (see dac.h) */
+#define DAC_PAGES_PER_REGION	16
+#define DAC_TABLE_ADDR		READ_BUF_END
+#define DAC_TABLE_ENTRIES	COUNT_BUCKETS(PMT_ENTRIES, DAC_PAGES_PER_REGION)
+#define DAC_TABLE_NUM_PAGES	COUNT_BUCKETS(DAC_TABLE_ENTRIES * sizeof(UINT32),\
+					BYTES_PER_PAGE)
+#define DAC_TABLE_BYTES		(DAC_TABLE_NUM_PAGES * BYTES_PER_PAGE)
+#define DAC_TABLE_END		(DAC_TABLE_ADDR + DAC_TABLE_BYTES)
+
+/* ========================================================================= *
+ * Session Table
  * ========================================================================= */
 
+/* hash table that maps session keys to user ids (see acl.h) */
 #if OPTION_ACL
-#define ACL_TABLE_ADDR		READ_BUF_END
-#define ACL_TABLE_ENTRIES	(NUM_BANKS * PAGES_PER_BANK)
-#define ACL_TABLE_ENTRIES_PER_PAGE	\
-				(BYTES_PER_PAGE / sizeof(user_id_t))
-#define ACL_TABLE_NUM_PAGES	COUNT_BUCKETS(ACL_TABLE_ENTRIES,\
-					ACL_TABLE_ENTRIES_PER_PAGE)
-#define ACL_TABLE_BYTES		(ACL_TABLE_NUM_PAGES * BYTES_PER_PAGE)
-#define ACL_TABLE_END		(ACL_TABLE_ADDR + ACL_TABLE_BYTES)
-
-#define NON_BUFFER_AREA_END	ACL_TABLE_END
+#define SESSION_TABLE_BITS	13
+#define SESSION_TABLE_SLOTS	(1 << SESSION_TABLE_BITS)
+#define SESSION_TABLE_NUM_PAGES	COUNT_BUCKETS(SESSION_TABLE_SLOTS * 2 * \
+					      sizeof(UINT32), BYTES_PER_PAGE)
+#define SESSION_TABLE_BYTES	(SESSION_TABLE_NUM_PAGES * BYTES_PER_PAGE)
+#else
+#define SESSION_TABLE_BYTES	0
+#endif
+#define SESSION_TABLE_ADDR	DAC_TABLE_END
+#define SESSION_TABLE_END	(SESSION_TABLE_ADDR + SESSION_TABLE_BYTES)
+
+/* ========================================================================= *
+ * User Epoch Table
+ * ========================================================================= */
+
+/* the current epoch of each user, which is bumped to revoke the user (see
+ * acl.h) */
+#if OPTION_ACL
+#define USER_EPOCH_TABLE_BITS	10
+#define USER_EPOCH_TABLE_ENTRIES	(1 << USER_EPOCH_TABLE_BITS)
+#define USER_EPOCH_TABLE_NUM_PAGES	COUNT_BUCKETS(USER_EPOCH_TABLE_ENTRIES *\
+						      sizeof(UINT8),\
+						      BYTES_PER_PAGE)
+#define USER_EPOCH_TABLE_BYTES	(USER_EPOCH_TABLE_NUM_PAGES * BYTES_PER_PAGE)
+#else
+#define USER_EPOCH_TABLE_BYTES	0
+#endif
+#define USER_EPOCH_TABLE_ADDR	SESSION_TABLE_END
+#define USER_EPOCH_TABLE_END	(USER_EPOCH_TABLE_ADDR + USER_EPOCH_TABLE_BYTES)
+
+/* ========================================================================= *
+ * Block Info
+ * ========================================================================= */
+
+/* per-block tables of UINT16 indexed by vblk (see gc.c); the table of a bank
+ * occupies whole sectors so that it can be written to flash */
+#define NUM_BLK_TABLES		7
+#define BLK_TABLE_BYTES_PER_BANK	(COUNT_BUCKETS(VBLKS_PER_BANK * \
+						       sizeof(UINT16), \
+						       BYTES_PER_SECTOR) * \
+					 BYTES_PER_SECTOR)
+#define BLK_TABLE_BYTES		(BLK_TABLE_BYTES_PER_BANK * NUM_BANKS)
+#define BLK_TABLE_ADDR(i)	(BLK_INFO_ADDR + (i) * BLK_TABLE_BYTES)
+#define BLK_INFO_NUM_PAGES	COUNT_BUCKETS(NUM_BLK_TABLES * BLK_TABLE_BYTES,\
+					      BYTES_PER_PAGE)
+#define BLK_INFO_BYTES		(BLK_INFO_NUM_PAGES * BYTES_PER_PAGE)
+#define BLK_INFO_ADDR		USER_EPOCH_TABLE_END
+#define BLK_INFO_END		(BLK_INFO_ADDR + BLK_INFO_BYTES)
+
+/* ========================================================================= *
+ * Block Summary Buffers
+ * ========================================================================= */
+
+/* summaries of active blocks and full blocks whose summaries are not written
+ * yet (see gc.h) */
+#include "gc.h"
+#define NUM_SUMMARY_BUFFERS_PER_BANK	(GC_NUM_STREAMS + \
+					 GC_MAX_PENDING_SUMMARIES)
+#define NUM_SUMMARY_BUFFERS	(NUM_SUMMARY_BUFFERS_PER_BANK * NUM_BANKS)
+#define SUMMARY_BUF_NUM_PAGES	COUNT_BUCKETS(NUM_SUMMARY_BUFFERS * \
+					      GC_SUMMARY_BYTES, BYTES_PER_PAGE)
+#define SUMMARY_BUF_BYTES	(SUMMARY_BUF_NUM_PAGES * BYTES_PER_PAGE)
+#define SUMMARY_BUF_ADDR	BLK_INFO_END
+#define SUMMARY_BUF_END		(SUMMARY_BUF_ADDR + SUMMARY_BUF_BYTES)
+#define SUMMARY_BUF(bank, i)	(SUMMARY_BUF_ADDR + GC_SUMMARY_BYTES * \
+				 ((bank) * NUM_SUMMARY_BUFFERS_PER_BANK + (i)))
+
+/* ========================================================================= *
+ * Flash Trace
+ * ========================================================================= */
+
+/* ring buffer of flash commands (see fla.h) */
+#if OPTION_FLA_TRACE
+#define FLA_TRACE_NUM_PAGES	4
 #else
-#define NON_BUFFER_AREA_END	READ_BUF_END
+#define FLA_TRACE_NUM_PAGES	0
 #endif
+#define FLA_TRACE_BYTES		(FLA_TRACE_NUM_PAGES * BYTES_PER_PAGE)
+#define FLA_TRACE_ADDR		SUMMARY_BUF_END
+#define FLA_TRACE_END		(FLA_TRACE_ADDR + FLA_TRACE_BYTES)
+
+#define NON_BUFFER_AREA_END	FLA_TRACE_END
 
 /* ========================================================================= *
  * Other Non-SATA Buffers
  * ========================================================================= */
 
 #define NUM_COPY_BUFFERS	NUM_BANKS_MAX
-#define NUM_MANAGED_BUFFERS	(2 * NUM_BANKS + NUM_WRITE_BUFFERS)
+/* GC uses two managed buffers: one for block summary, one for data */
+#define NUM_GC_BUFFERS		2
+/* A page flushed from write buffer keeps its managed buffer until it is
+ * programmed, and every thread may be programming one; flash reads and PMT
+ * flushes take the rest, at most two per bank */
+#define NUM_FLUSH_BUFFERS	MAX_NUM_THREADS
+#define NUM_MANAGED_BUFFERS	(2 * NUM_BANKS + NUM_WRITE_BUFFERS + \
+				 NUM_FLUSH_BUFFERS + NUM_GC_BUFFERS)
 #define NUM_HIL_BUFFERS		1
 #define NUM_TEMP_BUFFERS	1
 #define NUM_THREAD_SWAP_BUFFERS	1
@@ -133,14 +232,12 @@
 				 NUM_THREAD_SWAP_BUFFERS + \
 				 NUM_READ_BUFFERS)
 #define NON_SATA_BUF_BYTES	(NUM_NON_SATA_BUFFERS * BYTES_PER_PAGE)
-#define _DRAM_BYTES_OTHER	(NON_SATA_BUF_BYTES + \
+#define DRAM_BYTES_OTHER	(NON_SATA_BUF_BYTES + \
 				 PC_BYTES + PL_BYTES + \
-				 BAD_BLK_BMP_BYTES + GTD_BYTES)
-#if OPTION_ACL
-#define DRAM_BYTES_OTHER	(_DRAM_BYTES_OTHER + ACL_TABLE_BYTES)
-#else
-#define DRAM_BYTES_OTHER	_DRAM_BYTES_OTHER
-#endif
+				 BAD_BLK_BMP_BYTES + GTD_BYTES + \
+				 DAC_TABLE_BYTES + SESSION_TABLE_BYTES + \
+				 USER_EPOCH_TABLE_BYTES + BLK_INFO_BYTES + \
+				 SUMMARY_BUF_BYTES + FLA_TRACE_BYTES)
 
 #define NUM_SATA_RW_BUFFERS	((DRAM_SIZE - DRAM_BYTES_OTHER) / BYTES_PER_PAGE - 1)
 #define NUM_SATA_RD_BUFFERS	(COUNT_BUCKETS(NUM_SATA_RW_BUFFERS / 8, NUM_BANKS) * NUM_BANKS)
@@ -0,0 +1,99 @@
+#include "thread_handler_util.h"
+#include "erase_thread.h"
+#include "gc.h"
+#include "fla.h"
+#include "signal.h"
+#include "sata_manager.h"
+
+/* the first vblk of a bank is never erased */
+#define NULL_VBLK		0
+
+static thread_t *singleton_thread = NULL;
+
+void erase_thread_wakeup(void)
+{
+	/* erase thread may not be started yet */
+	if (singleton_thread == NULL) return;
+
+	if (singleton_thread->state == THREAD_SLEEPING)
+		singleton_thread->state = THREAD_RUNNABLE;
+}
+
+/*
+ * Handler
+ * */
+
+begin_thread_variables
+	UINT32	erasing_vblks[NUM_BANKS];
+end_thread_variables
+
+begin_thread_handler
+/* Erase thread is designed as a event loop */
+phase(ONE_PHASE) {
+	signals_t interesting_signals = 0;
+
+	/* Check whether issued erase cmds are complete */
+	for_each_bank(bank_i) {
+		UINT32 vblk = var(erasing_vblks)[bank_i];
+		if (vblk == NULL_VBLK) continue;
+
+		if (!fla_is_bank_complete(bank_i)) {
+			signals_set(interesting_signals, SIG_BANK(bank_i));
+			continue;
+		}
+
+		var(erasing_vblks)[bank_i] = NULL_VBLK;
+		gc_erase_done(bank_i, vblk);
+	}
+
+	/* Erase dirty blocks on idle banks */
+	BOOL8 host_idle = sata_manager_are_all_tasks_finished();
+	for_each_bank(bank_i) {
+		if (var(erasing_vblks)[bank_i] != NULL_VBLK) continue;
+		if (!gc_needs_erase(bank_i, host_idle)) continue;
+		/* nobody else wakes us up when the bank becomes idle, and host
+		 * writes may be waiting for the erased block */
+		if (!fla_is_bank_idle(bank_i)) {
+			signals_set(interesting_signals, SIG_BANK(bank_i));
+			continue;
+		}
+
+		UINT32 vblk;
+		if (!gc_pick_block_to_erase(bank_i, host_idle, &vblk)) continue;
+
+		flash_owner(FLA_SRC_GC, NULL_LPN);
+		fla_erase_block(bank_i, vblk);
+		var(erasing_vblks)[bank_i] = vblk;
+		signals_set(interesting_signals, SIG_BANK(bank_i));
+	}
+
+	if (interesting_signals)
+		sleep(interesting_signals);
+	else
+		/* need to be waken up */
+		sleep(0);
+}
+end_thread_handler
+
+/*
+ * Initialiazation
+ * */
+
+static thread_handler_id_t registered_handler_id = NULL_THREAD_HANDLER_ID;
+
+void erase_thread_init(thread_t *t)
+{
+	/* erase thread is a singleton; thus init can be only called once */
+	ASSERT(registered_handler_id == NULL_THREAD_HANDLER_ID);
+	registered_handler_id = thread_handler_register(get_thread_handler());
+
+	singleton_thread = t;
+
+	t->handler_id = registered_handler_id;
+
+	for_each_bank(bank_i) {
+		var(erasing_vblks)[bank_i] = NULL_VBLK;
+	}
+
+	init_thread_variables(thread_id(t));
+}
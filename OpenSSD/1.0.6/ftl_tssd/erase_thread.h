@@ -0,0 +1,20 @@
+#ifndef __ERASE_THREAD_H
+#define __ERASE_THREAD_H
+
+#include "thread.h"
+
+/*
+ * Erase thread -- erase dirty blocks in background to refill the pools of
+ * erased blocks (see gc.h).
+ *
+ * The thread erases on idle banks only, at most one block per bank at a time,
+ * so that foreground reads and writes rarely wait for an erase. When host is
+ * idle, the pools are filled up to make room for the next burst of writes.
+ * */
+
+void erase_thread_init(thread_t *t);
+
+/* Wake up erase thread when a pool may need more erased blocks */
+void erase_thread_wakeup(void);
+
+#endif
@@ -0,0 +1,414 @@
+#include "fde.h"
+#if OPTION_FDE
+#include "mem_util.h"
+
+/* ==========================================================================
+ * Macros and Data Structure
+ * ========================================================================*/
+
+#define AES_BLOCK_WORDS		4
+#define AES_BLOCK_BYTES		(AES_BLOCK_WORDS * sizeof(UINT32))
+#define AES_KEY_BYTES		16
+#define AES_ROUNDS		10
+#define AES_RK_WORDS		(AES_BLOCK_WORDS * (AES_ROUNDS + 1))
+
+#define SECTOR_WORDS		(BYTES_PER_SECTOR / sizeof(UINT32))
+#define BLOCKS_PER_SECTOR	(BYTES_PER_SECTOR / AES_BLOCK_BYTES)
+
+/* Words are little-endian, i.e. byte 0 of a column of AES state is the least
+ * significant byte of its word, so the key and data bytes in memory are the
+ * bytes of AES and XTS as they are */
+#define byte_of(w, i)		((UINT8)((w) >> (8 * (i))))
+#define rotl(v, n)		(((v) << (n)) | ((v) >> (32 - (n))))
+
+/* User keys are derived by the block function of ChaCha20, a PRF keyed by
+ * the master key with the user id as the nonce */
+#define CHACHA_BLOCK_WORDS	16
+#define CHACHA_KEY_WORDS	8
+#define CHACHA_ROUNDS		20
+#define KDF_NONCE		0x4644454B	/* "KEDF" */
+
+#define quarter_round(a, b, c, d)	do {				\
+		a += b; d ^= a; d = rotl(d, 16);			\
+		c += d; b ^= c; b = rotl(b, 12);			\
+		a += b; d ^= a; d = rotl(d, 8);				\
+		c += d; b ^= c; b = rotl(b, 7);				\
+	} while(0)
+
+/* Derived user keys are cached, as deriving a key costs a ChaCha20 block */
+#define KEY_CACHE_SIZE		4
+
+/* S-boxes, and the T-tables that combine SubBytes and MixColumns (or their
+ * inverses) of row 0; other rows are rotations of them */
+static UINT8		sbox[256], inv_sbox[256];
+static UINT32		te[256], td[256];
+
+static fde_key_t	master_key;
+static user_id_t	cached_uids[KEY_CACHE_SIZE];
+static fde_key_t	cached_keys[KEY_CACHE_SIZE];
+static UINT8		next_cache_victim;
+
+static BOOL8		enabled;
+/* whether user data has been programmed, which freezes the master key */
+static BOOL8		has_data;
+
+/* Round keys of the data key and the tweak key of XTS; data is decrypted
+ * with the equivalent inverse cipher of FIPS-197, whose round keys differ */
+static UINT32		data_rk[AES_RK_WORDS];
+static UINT32		tweak_rk[AES_RK_WORDS];
+
+/* Sectors are copied to SRAM to be encrypted, since DRAM is not directly
+ * addressable (see mem_util.c) */
+static UINT32		sector_buf[SECTOR_WORDS];
+
+/* ==========================================================================
+ * Private Functions
+ * ========================================================================*/
+
+static UINT8 xtime(UINT8 const x)
+{
+	return (UINT8)((x << 1) ^ ((x & 0x80) ? 0x1B : 0));
+}
+
+static UINT8 rotl8(UINT8 const x, UINT8 const n)
+{
+	return (UINT8)((x << n) | (x >> (8 - n)));
+}
+
+static void aes_init_tables(void)
+{
+	/* p runs over all non-zero elements of GF(2^8) as powers of 3 and q
+	 * is the inverse of p */
+	UINT8 p = 1, q = 1;
+	do {
+		p = p ^ xtime(p);
+		q ^= q << 1;
+		q ^= q << 2;
+		q ^= q << 4;
+		if (q & 0x80) q ^= 0x09;
+
+		sbox[p] = q ^ rotl8(q, 1) ^ rotl8(q, 2) ^ rotl8(q, 3) ^
+			  rotl8(q, 4) ^ 0x63;
+	} while (p != 1);
+	sbox[0] = 0x63;
+
+	for (UINT32 i = 0; i < 256; i++) {
+		inv_sbox[sbox[i]] = (UINT8)i;
+
+		UINT8 s = sbox[i], s2 = xtime(s);
+		te[i] = s2 | (s << 8) | (s << 16) | ((UINT32)(s2 ^ s) << 24);
+	}
+	for (UINT32 i = 0; i < 256; i++) {
+		UINT8 s = inv_sbox[i], s2 = xtime(s), s4 = xtime(s2),
+		      s8 = xtime(s4);
+		UINT8 s9 = s8 ^ s, s11 = s9 ^ s2, s13 = s9 ^ s4,
+		      s14 = s8 ^ s4 ^ s2;
+		td[i] = s14 | (s9 << 8) | (s13 << 16) | ((UINT32)s11 << 24);
+	}
+}
+
+static UINT32 load_word(UINT8 const *b)
+{
+	return b[0] | (b[1] << 8) | (b[2] << 16) | ((UINT32)b[3] << 24);
+}
+
+static void aes_expand_key(UINT8 const key[AES_KEY_BYTES],
+			   UINT32 rk[AES_RK_WORDS])
+{
+	UINT8 rcon = 1;
+	for (UINT8 i = 0; i < AES_BLOCK_WORDS; i++)
+		rk[i] = load_word(&key[i * sizeof(UINT32)]);
+	for (UINT8 i = AES_BLOCK_WORDS; i < AES_RK_WORDS; i++) {
+		UINT32 t = rk[i - 1];
+		if (i % AES_BLOCK_WORDS == 0) {
+			/* SubWord(RotWord(t)) ^ Rcon */
+			t = rotl(t, 24);
+			t = sbox[byte_of(t, 0)] | (sbox[byte_of(t, 1)] << 8) |
+			    (sbox[byte_of(t, 2)] << 16) |
+			    ((UINT32)sbox[byte_of(t, 3)] << 24);
+			t ^= rcon;
+			rcon = xtime(rcon);
+		}
+		rk[i] = rk[i - AES_BLOCK_WORDS] ^ t;
+	}
+}
+
+/* Turn encryption round keys into those of the equivalent inverse cipher,
+ * i.e. reverse the rounds and apply InvMixColumns to the inner ones */
+static void aes_invert_key(UINT32 rk[AES_RK_WORDS])
+{
+	for (UINT8 i = 0, j = AES_RK_WORDS - AES_BLOCK_WORDS; i < j;
+	     i += AES_BLOCK_WORDS, j -= AES_BLOCK_WORDS) {
+		for (UINT8 k = 0; k < AES_BLOCK_WORDS; k++) {
+			UINT32 t = rk[i + k];
+			rk[i + k] = rk[j + k];
+			rk[j + k] = t;
+		}
+	}
+	for (UINT8 i = AES_BLOCK_WORDS; i < AES_RK_WORDS - AES_BLOCK_WORDS; i++) {
+		UINT32 w = rk[i];
+		rk[i] = td[sbox[byte_of(w, 0)]] ^
+			rotl(td[sbox[byte_of(w, 1)]], 8) ^
+			rotl(td[sbox[byte_of(w, 2)]], 16) ^
+			rotl(td[sbox[byte_of(w, 3)]], 24);
+	}
+}
+
+static void aes_encrypt_block(UINT32 const rk[AES_RK_WORDS],
+			      UINT32 s[AES_BLOCK_WORDS])
+{
+	UINT32 s0 = s[0] ^ rk[0], s1 = s[1] ^ rk[1],
+	       s2 = s[2] ^ rk[2], s3 = s[3] ^ rk[3];
+	UINT32 t0, t1, t2, t3;
+
+#define enc_column(a, b, c, d, k)					\
+		(te[byte_of(a, 0)] ^ rotl(te[byte_of(b, 1)], 8) ^	\
+		 rotl(te[byte_of(c, 2)], 16) ^				\
+		 rotl(te[byte_of(d, 3)], 24) ^ rk[k])
+	for (UINT8 r = 1; r < AES_ROUNDS; r++) {
+		UINT8 k = r * AES_BLOCK_WORDS;
+		t0 = enc_column(s0, s1, s2, s3, k);
+		t1 = enc_column(s1, s2, s3, s0, k + 1);
+		t2 = enc_column(s2, s3, s0, s1, k + 2);
+		t3 = enc_column(s3, s0, s1, s2, k + 3);
+		s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+	}
+#undef enc_column
+
+#define enc_last_column(a, b, c, d, k)					\
+		((sbox[byte_of(a, 0)] | (sbox[byte_of(b, 1)] << 8) |	\
+		  (sbox[byte_of(c, 2)] << 16) |				\
+		  ((UINT32)sbox[byte_of(d, 3)] << 24)) ^ rk[k])
+	UINT8 k = AES_ROUNDS * AES_BLOCK_WORDS;
+	s[0] = enc_last_column(s0, s1, s2, s3, k);
+	s[1] = enc_last_column(s1, s2, s3, s0, k + 1);
+	s[2] = enc_last_column(s2, s3, s0, s1, k + 2);
+	s[3] = enc_last_column(s3, s0, s1, s2, k + 3);
+#undef enc_last_column
+}
+
+static void aes_decrypt_block(UINT32 const rk[AES_RK_WORDS],
+			      UINT32 s[AES_BLOCK_WORDS])
+{
+	UINT32 s0 = s[0] ^ rk[0], s1 = s[1] ^ rk[1],
+	       s2 = s[2] ^ rk[2], s3 = s[3] ^ rk[3];
+	UINT32 t0, t1, t2, t3;
+
+#define dec_column(a, b, c, d, k)					\
+		(td[byte_of(a, 0)] ^ rotl(td[byte_of(b, 1)], 8) ^	\
+		 rotl(td[byte_of(c, 2)], 16) ^				\
+		 rotl(td[byte_of(d, 3)], 24) ^ rk[k])
+	for (UINT8 r = 1; r < AES_ROUNDS; r++) {
+		UINT8 k = r * AES_BLOCK_WORDS;
+		t0 = dec_column(s0, s3, s2, s1, k);
+		t1 = dec_column(s1, s0, s3, s2, k + 1);
+		t2 = dec_column(s2, s1, s0, s3, k + 2);
+		t3 = dec_column(s3, s2, s1, s0, k + 3);
+		s0 = t0; s1 = t1; s2 = t2; s3 = t3;
+	}
+#undef dec_column
+
+#define dec_last_column(a, b, c, d, k)					\
+		((inv_sbox[byte_of(a, 0)] | (inv_sbox[byte_of(b, 1)] << 8) | \
+		  (inv_sbox[byte_of(c, 2)] << 16) |			\
+		  ((UINT32)inv_sbox[byte_of(d, 3)] << 24)) ^ rk[k])
+	UINT8 k = AES_ROUNDS * AES_BLOCK_WORDS;
+	s[0] = dec_last_column(s0, s3, s2, s1, k);
+	s[1] = dec_last_column(s1, s0, s3, s2, k + 1);
+	s[2] = dec_last_column(s2, s1, s0, s3, k + 2);
+	s[3] = dec_last_column(s3, s2, s1, s0, k + 3);
+#undef dec_last_column
+}
+
+/* Load the round keys of *key*, whose first half is the data key and second
+ * half is the tweak key */
+static void xts_load_key(fde_key_t const *key, BOOL8 const decrypt)
+{
+	aes_expand_key(&key->key[0], data_rk);
+	if (decrypt) aes_invert_key(data_rk);
+	aes_expand_key(&key->key[AES_KEY_BYTES], tweak_rk);
+}
+
+static void xts_crypt_sector(UINT32 const sector_addr, UINT32 const lsn,
+			     BOOL8 const decrypt)
+{
+	/* the tweak of the first block is the encrypted LSN, as a 128-bit
+	 * little-endian number */
+	UINT32 tweak[AES_BLOCK_WORDS] = {lsn, 0, 0, 0};
+	aes_encrypt_block(tweak_rk, tweak);
+
+	mem_copy(sector_buf, sector_addr, BYTES_PER_SECTOR);
+	for (UINT8 block_i = 0; block_i < BLOCKS_PER_SECTOR; block_i++) {
+		UINT32 *block = &sector_buf[block_i * AES_BLOCK_WORDS];
+		for (UINT8 i = 0; i < AES_BLOCK_WORDS; i++)
+			block[i] ^= tweak[i];
+		if (decrypt)
+			aes_decrypt_block(data_rk, block);
+		else
+			aes_encrypt_block(data_rk, block);
+		for (UINT8 i = 0; i < AES_BLOCK_WORDS; i++)
+			block[i] ^= tweak[i];
+
+		/* the tweak of the next block is this one times x in
+		 * GF(2^128) */
+		UINT32 carry = tweak[3] >> 31;
+		tweak[3] = (tweak[3] << 1) | (tweak[2] >> 31);
+		tweak[2] = (tweak[2] << 1) | (tweak[1] >> 31);
+		tweak[1] = (tweak[1] << 1) | (tweak[0] >> 31);
+		tweak[0] = (tweak[0] << 1) ^ (carry ? 0x87 : 0);
+	}
+	mem_copy(sector_addr, sector_buf, BYTES_PER_SECTOR);
+}
+
+static void xts_crypt_page(UINT32 const buf, UINT32 const lpn,
+			   sectors_mask_t const sectors, user_id_t const uid,
+			   BOOL8 const decrypt)
+{
+	xts_load_key(fde_get_user_key(uid), decrypt);
+
+	UINT32 const first_lsn = lpn * SECTORS_PER_PAGE;
+	UINT8 begin_i = begin_sector(sectors), end_i = end_sector(sectors);
+	for (UINT8 sect_i = begin_i; sect_i < end_i; sect_i++) {
+		if (((sectors >> sect_i) & 1) == 0) continue;
+		xts_crypt_sector(buf + sect_i * BYTES_PER_SECTOR,
+				 first_lsn + sect_i, decrypt);
+	}
+}
+
+static void xts_crypt_sectors(UINT32 const buf, UINT8 const num_sectors,
+			      fde_key_t const *key, BOOL8 const decrypt)
+{
+	xts_load_key(key, decrypt);
+	for (UINT8 i = 0; i < num_sectors; i++)
+		xts_crypt_sector(buf + i * BYTES_PER_SECTOR, i, decrypt);
+}
+
+static void chacha20_block(UINT32 const key_words[CHACHA_KEY_WORDS],
+			   UINT32 const counter,
+			   UINT32 const nonce0, UINT32 const nonce1,
+			   UINT32 out[CHACHA_BLOCK_WORDS])
+{
+	/* "expand 32-byte k" */
+	UINT32 x0  = 0x61707865, x1  = 0x3320646e,
+	       x2  = 0x79622d32, x3  = 0x6b206574,
+	       x4  = key_words[0], x5  = key_words[1],
+	       x6  = key_words[2], x7  = key_words[3],
+	       x8  = key_words[4], x9  = key_words[5],
+	       x10 = key_words[6], x11 = key_words[7],
+	       x12 = counter, x13 = nonce0, x14 = nonce1, x15 = 0;
+
+	for (UINT8 i = 0; i < CHACHA_ROUNDS; i += 2) {
+		quarter_round(x0, x4, x8,  x12);
+		quarter_round(x1, x5, x9,  x13);
+		quarter_round(x2, x6, x10, x14);
+		quarter_round(x3, x7, x11, x15);
+		quarter_round(x0, x5, x10, x15);
+		quarter_round(x1, x6, x11, x12);
+		quarter_round(x2, x7, x8,  x13);
+		quarter_round(x3, x4, x9,  x14);
+	}
+
+	out[0]  = x0  + 0x61707865;	out[1]  = x1  + 0x3320646e;
+	out[2]  = x2  + 0x79622d32;	out[3]  = x3  + 0x6b206574;
+	out[4]  = x4  + key_words[0];	out[5]  = x5  + key_words[1];
+	out[6]  = x6  + key_words[2];	out[7]  = x7  + key_words[3];
+	out[8]  = x8  + key_words[4];	out[9]  = x9  + key_words[5];
+	out[10] = x10 + key_words[6];	out[11] = x11 + key_words[7];
+	out[12] = x12 + counter;	out[13] = x13 + nonce0;
+	out[14] = x14 + nonce1;		out[15] = x15;
+}
+
+static BOOL8 is_same_key(fde_key_t const *a, fde_key_t const *b)
+{
+	for (UINT8 i = 0; i < sizeof(a->key); i++)
+		if (a->key[i] != b->key[i]) return FALSE;
+	return TRUE;
+}
+
+/* ==========================================================================
+ * Public Functions
+ * ========================================================================*/
+
+void fde_init(void)
+{
+	BUG_ON("a sector must consist of whole AES blocks",
+		BYTES_PER_SECTOR % AES_BLOCK_BYTES != 0);
+
+	aes_init_tables();
+
+	mem_set_sram(&master_key, 0, sizeof(fde_key_t));
+	for (UINT8 i = 0; i < KEY_CACHE_SIZE; i++)
+		cached_uids[i] = NULL_USER_ID;
+	next_cache_victim = 0;
+
+	/* off until host gives the master key */
+	enabled  = FALSE;
+	has_data = FALSE;
+}
+
+BOOL8 fde_set_master_key(fde_key_t const *new_master_key)
+{
+	if (has_data)
+		return enabled && is_same_key(&master_key, new_master_key);
+
+	master_key = *new_master_key;
+	for (UINT8 i = 0; i < KEY_CACHE_SIZE; i++)
+		cached_uids[i] = NULL_USER_ID;
+	enabled = TRUE;
+	return TRUE;
+}
+
+BOOL8 fde_is_enabled(void)
+{
+	return enabled;
+}
+
+fde_key_t const *fde_get_user_key(user_id_t const uid)
+{
+	for (UINT8 i = 0; i < KEY_CACHE_SIZE; i++)
+		if (cached_uids[i] == uid) return &cached_keys[i];
+
+	UINT8 cache_i = next_cache_victim;
+	next_cache_victim = (next_cache_victim + 1) % KEY_CACHE_SIZE;
+
+	/* user key = the first half of the ChaCha20 block of uid */
+	UINT32 key_words[CHACHA_KEY_WORDS], block[CHACHA_BLOCK_WORDS];
+	for (UINT8 i = 0; i < CHACHA_KEY_WORDS; i++)
+		key_words[i] = load_word(&master_key.key[i * sizeof(UINT32)]);
+	chacha20_block(key_words, 0, uid, KDF_NONCE, block);
+
+	fde_key_t *key = &cached_keys[cache_i];
+	for (UINT8 i = 0; i < sizeof(key->key); i++)
+		key->key[i] = byte_of(block[i / sizeof(UINT32)],
+				      i % sizeof(UINT32));
+	cached_uids[cache_i] = uid;
+	return key;
+}
+
+void fde_encrypt_page(UINT32 const buf, UINT32 const lpn,
+		      sectors_mask_t const sectors, user_id_t const uid)
+{
+	has_data = TRUE;
+	if (!enabled || sectors == 0) return;
+	xts_crypt_page(buf, lpn, sectors, uid, FALSE);
+}
+
+void fde_decrypt_page(UINT32 const buf, UINT32 const lpn,
+		      sectors_mask_t const sectors, user_id_t const uid)
+{
+	if (!enabled || sectors == 0) return;
+	xts_crypt_page(buf, lpn, sectors, uid, TRUE);
+}
+
+void fde_encrypt(UINT32 const buf, UINT8 const num_sectors,
+		 fde_key_t const key)
+{
+	xts_crypt_sectors(buf, num_sectors, &key, FALSE);
+}
+
+void fde_decrypt(UINT32 const buf, UINT8 const num_sectors,
+		 fde_key_t const key)
+{
+	xts_crypt_sectors(buf, num_sectors, &key, TRUE);
+}
+#endif
@@ -0,0 +1,62 @@
+#ifndef __FDE_H
+#define __FDE_H
+
+#include "jasmine.h"
+#if OPTION_FDE
+
+/* *
+ * FDE = full disk encryption
+ *
+ * User data is encrypted right before it is programmed into flash and is
+ * decrypted right after it is read from flash; data in write buffer, PMT and
+ * other metadata are kept in plaintext.
+ *
+ * The cipher is XTS-AES-128 (IEEE P1619) with the logical sector number (LSN)
+ * as the tweak of a sector. Every 16-byte block of a sector is encrypted with
+ * a tweak of its own, so an overwrite of a sector reveals no more than which
+ * blocks have changed, and a flipped bit of ciphertext garbles its whole block
+ * instead of flipping the same bit of plaintext. The ciphertext of a sector
+ * depends only on the key and the LSN, so data can be relocated (e.g. by GC)
+ * without being re-encrypted. AES is table-driven; the tables are computed
+ * by fde_init() and take 2.5KB of SRAM.
+ *
+ * Every user has its own key, i.e. a data key and a tweak key, which is
+ * derived from a master key. The master key is given by host (see
+ * ata_tssd_session() in sata_cmd.c) and is never stored in flash. FDE is off
+ * until the master key is given, and the master key can no longer be given or
+ * changed once user data has been programmed into flash, with or without FDE,
+ * as the data would become unreadable.
+ * */
+
+typedef struct {
+	UINT8	key[32];
+} fde_key_t;
+
+void fde_init(void);
+
+/* Return FALSE if user data has been programmed with another master key or
+ * without FDE */
+BOOL8 fde_set_master_key(fde_key_t const *master_key);
+BOOL8 fde_is_enabled(void);
+
+/* The returned key is valid until the next call of this function */
+fde_key_t const *fde_get_user_key(user_id_t const uid);
+
+/* Encrypt the sectors in *sectors* of a page buffer that holds logical page
+ * *lpn* of user *uid*, if FDE is on. Every program of user data must go
+ * through this, even if FDE is off, to freeze the master key. */
+void fde_encrypt_page(UINT32 const buf, UINT32 const lpn,
+		      sectors_mask_t const sectors, user_id_t const uid);
+/* Decrypt the sectors in *sectors* that are read from flash, if FDE is on */
+void fde_decrypt_page(UINT32 const buf, UINT32 const lpn,
+		      sectors_mask_t const sectors, user_id_t const uid);
+
+/* Encrypt or decrypt *num_sectors* sectors in *buf*, as if they are the first
+ * sectors of the disk, regardless of whether FDE is on */
+void fde_encrypt(UINT32 const buf, UINT8 const num_sectors,
+		 fde_key_t const key);
+void fde_decrypt(UINT32 const buf, UINT8 const num_sectors,
+		 fde_key_t const key);
+
+#endif
+#endif /* __FDE_H */
@@ -2,6 +2,8 @@
 #include "bad_blocks.h"
 #include "mem_util.h"
 #include "signal.h"
+#include "counters.h"
+#include "dram.h"
 
 typedef UINT16 banks_mask_t;
 /* 1 - idle; 0 - used */
@@ -30,6 +32,62 @@ static void use_bank(UINT8 const bank_i) {
 	update_scheduler_signals();
 }
 
+/* owner of the next command */
+static UINT8		owner_tid    = FLA_NO_THREAD;
+static fla_source_t	owner_source = FLA_SRC_NONE;
+static UINT32		owner_lpn    = NULL_LPN;
+
+#if OPTION_FLA_TRACE
+static void trace_issue(UINT8 const bank, fla_trace_op_t const op,
+			UINT32 const vpn, UINT8 const num_sectors);
+static void trace_complete(banks_mask_t const banks);
+#else
+#define trace_issue(bank, op, vpn, num_sectors)
+#define trace_complete(banks)
+#endif
+
+static void issue(UINT8 const bank, fla_trace_op_t const op,
+		  UINT32 const vpn, UINT8 const num_sectors)
+{
+	use_bank(bank);
+	trace_issue(bank, op, vpn, num_sectors);
+	fla_set_owner(FLA_NO_THREAD, FLA_SRC_NONE, NULL_LPN);
+}
+
+/* programs without owners are taken as metadata */
+static counter_id_t const program_counters[NUM_FLA_SOURCES] = {
+	COUNTER_META_PROGRAM_SUB_PAGES,
+	COUNTER_USER_PROGRAM_SUB_PAGES,
+	COUNTER_PMT_PROGRAM_SUB_PAGES,
+	COUNTER_META_PROGRAM_SUB_PAGES,
+	COUNTER_GC_PROGRAM_SUB_PAGES
+};
+
+static void count_program(UINT8 const bank, UINT8 const sect_offset,
+			  UINT8 const num_sectors)
+{
+	UINT8 num_sub_pages = COUNT_BUCKETS(sect_offset + num_sectors,
+					    SECTORS_PER_SUB_PAGE)
+			      - sect_offset / SECTORS_PER_SUB_PAGE;
+	bank_counter_inc(BANK_COUNTER_FLASH_PROGRAMS, bank);
+	counter_add(program_counters[owner_source], num_sub_pages);
+}
+
+/* a copyback reads and programs a whole page inside the bank */
+static void count_copyback(UINT8 const bank) {
+	counter_inc(COUNTER_FLASH_COPYBACKS);
+	bank_counter_inc(BANK_COUNTER_FLASH_READS, bank);
+	count_program(bank, 0, SECTORS_PER_PAGE);
+}
+
+void fla_set_owner(UINT8 const tid, fla_source_t const source,
+		   UINT32 const lpn)
+{
+	owner_tid    = tid;
+	owner_source = source;
+	owner_lpn    = lpn;
+}
+
 void fla_format_all(UINT32 const from_vblk)
 {
 	for (UINT32 vblk = from_vblk; vblk < VBLKS_PER_BANK; vblk++)
@@ -58,6 +116,7 @@ void fla_update_bank_state()
 	}
 	/* update complete banks */
 	complete_banks = used_banks & idle_banks;
+	trace_complete(complete_banks);
 
 	update_scheduler_signals();
 }
@@ -78,6 +137,11 @@ BOOL8 fla_is_bank_complete(UINT8 const bank)
 	return (complete_banks >> bank) & 1;
 }
 
+UINT8 fla_get_num_idle_banks()
+{
+	return __builtin_popcount(idle_banks & ((1 << num_banks) - 1));
+}
+
 UINT8 fla_get_idle_bank()
 {
 	static UINT8 bank_i = num_banks - 1;
@@ -107,7 +171,9 @@ void fla_read_page(vp_t const vp, UINT8 const sect_offset,
 			 num_sectors,
 			 rd_buf,
 			 RETURN_ON_ISSUE);
-	use_bank(vp.bank);
+	bank_counter_inc(BANK_COUNTER_FLASH_READS, vp.bank);
+	counter_add(COUNTER_FLASH_READ_SECTORS, num_sectors);
+	issue(vp.bank, FLA_TRACE_READ, vp.vpn, num_sectors);
 }
 
 void fla_write_page(vp_t const vp, UINT8 const sect_offset,
@@ -120,7 +186,50 @@ void fla_write_page(vp_t const vp, UINT8 const sect_offset,
 			    sect_offset,
 			    num_sectors,
 			    wr_buf);
-	use_bank(vp.bank);
+	count_program(vp.bank, sect_offset, num_sectors);
+	counter_add(COUNTER_FLASH_WRITE_SECTORS, num_sectors);
+	issue(vp.bank, FLA_TRACE_PROGRAM, vp.vpn, num_sectors);
+}
+
+void fla_erase_block(UINT8 const bank, UINT32 const vblk)
+{
+	ASSERT(fla_is_bank_idle(bank));
+	nand_block_erase(bank, vblk);
+	bank_counter_inc(BANK_COUNTER_FLASH_ERASES, bank);
+	issue(bank, FLA_TRACE_ERASE, vblk * PAGES_PER_VBLK, 0);
+}
+
+void fla_copyback_page(vp_t const src_vp, vp_t const dst_vp)
+{
+	ASSERT(src_vp.bank == dst_vp.bank);
+	ASSERT(fla_is_bank_idle(src_vp.bank));
+	nand_page_copyback(src_vp.bank,
+			   src_vp.vpn / PAGES_PER_VBLK,
+			   src_vp.vpn % PAGES_PER_VBLK,
+			   dst_vp.vpn / PAGES_PER_VBLK,
+			   dst_vp.vpn % PAGES_PER_VBLK);
+	count_copyback(src_vp.bank);
+	issue(src_vp.bank, FLA_TRACE_COPYBACK, dst_vp.vpn, 0);
+}
+
+void fla_modified_copyback_page(vp_t const src_vp, vp_t const dst_vp,
+				UINT8 const sect_offset, UINT8 const num_sectors,
+				UINT32 const wr_buf)
+{
+	ASSERT(src_vp.bank == dst_vp.bank);
+	ASSERT(fla_is_bank_idle(src_vp.bank));
+	/* flash wrapper takes the address of the first sector to write */
+	nand_page_modified_copyback(src_vp.bank,
+				    src_vp.vpn / PAGES_PER_VBLK,
+				    src_vp.vpn % PAGES_PER_VBLK,
+				    dst_vp.vpn / PAGES_PER_VBLK,
+				    dst_vp.vpn % PAGES_PER_VBLK,
+				    sect_offset,
+				    wr_buf + sect_offset * BYTES_PER_SECTOR,
+				    num_sectors * BYTES_PER_SECTOR);
+	count_copyback(src_vp.bank);
+	counter_add(COUNTER_FLASH_WRITE_SECTORS, num_sectors);
+	issue(src_vp.bank, FLA_TRACE_COPYBACK, dst_vp.vpn, num_sectors);
 }
 
 void fla_copy_buffer(UINT32 const target_buf, UINT32 const src_buf,
@@ -144,3 +253,118 @@ void fla_copy_buffer(UINT32 const target_buf, UINT32 const src_buf,
 			 (end_sector - begin_sector) * BYTES_PER_SECTOR);
 	}
 }
+
+/* ===========================================================================
+ * Flash tracer
+ * =========================================================================*/
+#if OPTION_FLA_TRACE
+
+#define TRACE_TIMER		TIMER_CH3
+#define TRACE_PRESCALE		TIMER_PRESCALE_1
+/* PRESCALE_TO_DIV takes the prescale before shifted */
+#define TRACE_TICKS_PER_SEC	(CLOCK_SPEED / 2 / \
+				 PRESCALE_TO_DIV(TRACE_PRESCALE >> 2))
+
+#define NUM_TRACE_EVENTS	(FLA_TRACE_BYTES / FLA_TRACE_EVENT_BYTES)
+#define TRACE_EVENT_ADDR(seq)	(FLA_TRACE_ADDR + FLA_TRACE_EVENT_BYTES * \
+				 ((seq) % NUM_TRACE_EVENTS))
+
+/* events in [tail, head) are not drained yet */
+static UINT32 trace_head, trace_tail, trace_num_dropped;
+
+/* the last command issued to each bank, to trace its completion */
+static UINT32 bank_info[NUM_BANKS], bank_lpn[NUM_BANKS], bank_vpn[NUM_BANKS];
+
+#define event_info(bank, op, info)	((bank) | (op) << 8 | (info))
+#define owner_info()			(owner_tid << 16 | owner_source << 24)
+
+static void trace_event(UINT32 const info, UINT32 const lpn, UINT32 const vpn)
+{
+	UINT32 addr = TRACE_EVENT_ADDR(trace_head);
+	write_dram_32(addr, 0xFFFFFFFF - GET_TIMER_VALUE(TRACE_TIMER));
+	write_dram_32(addr + sizeof(UINT32), info);
+	write_dram_32(addr + 2 * sizeof(UINT32), lpn);
+	write_dram_32(addr + 3 * sizeof(UINT32), vpn);
+	trace_head++;
+}
+
+static void trace_issue(UINT8 const bank, fla_trace_op_t const op,
+			UINT32 const vpn, UINT8 const num_sectors)
+{
+	bank_info[bank] = owner_info();
+	bank_lpn[bank]	= owner_lpn;
+	bank_vpn[bank]	= vpn | num_sectors << 24;
+	trace_event(event_info(bank, op, bank_info[bank]), owner_lpn,
+		    bank_vpn[bank]);
+}
+
+static void trace_complete(banks_mask_t const banks)
+{
+	if (banks == 0) return;
+	for_each_bank(bank) {
+		if (((banks >> bank) & 1) == 0) continue;
+		trace_event(event_info(bank, FLA_TRACE_COMPLETE,
+				       bank_info[bank]),
+			    bank_lpn[bank], bank_vpn[bank]);
+	}
+}
+
+/* Forget the events that are overwritten by newer ones */
+static void trace_drop_overwritten()
+{
+	if (trace_head - trace_tail <= NUM_TRACE_EVENTS) return;
+	trace_num_dropped += trace_head - trace_tail - NUM_TRACE_EVENTS;
+	trace_tail = trace_head - NUM_TRACE_EVENTS;
+}
+
+void fla_trace_init()
+{
+	/* the timer is also the clock of profiler when profiling */
+	start_interval_measurement(TRACE_TIMER, TRACE_PRESCALE);
+	trace_head = trace_tail = trace_num_dropped = 0;
+}
+
+UINT32 fla_trace_export(UINT32 const buf)
+{
+	trace_drop_overwritten();
+
+	UINT32 num_events = MIN(trace_head - trace_tail,
+				FLA_TRACE_EVENTS_PER_SECTOR);
+	fla_trace_header_t header = {
+		.magic		= FLA_TRACE_MAGIC,
+		.version	= FLA_TRACE_VERSION,
+		.num_events	= num_events,
+		.num_dropped	= trace_num_dropped,
+		.ticks_per_sec	= TRACE_TICKS_PER_SEC
+	};
+	mem_set_dram(buf, 0, BYTES_PER_SECTOR);
+	mem_copy(buf, &header, sizeof(header));
+
+	UINT32 event_buf = buf + sizeof(header);
+	for (UINT32 i = 0; i < num_events; i++) {
+		mem_copy(event_buf, TRACE_EVENT_ADDR(trace_tail),
+			 FLA_TRACE_EVENT_BYTES);
+		event_buf += FLA_TRACE_EVENT_BYTES;
+		trace_tail++;
+	}
+	trace_num_dropped = 0;
+	return num_events;
+}
+
+void fla_trace_dump()
+{
+	trace_drop_overwritten();
+
+	uart_print("fla_trace ticks_per_sec %u dropped %u",
+		   TRACE_TICKS_PER_SEC, trace_num_dropped);
+	for (; trace_tail != trace_head; trace_tail++) {
+		UINT32 addr = TRACE_EVENT_ADDR(trace_tail);
+		uart_print("fla_trace %x %x %x %x",
+			   read_dram_32(addr),
+			   read_dram_32(addr + sizeof(UINT32)),
+			   read_dram_32(addr + 2 * sizeof(UINT32)),
+			   read_dram_32(addr + 3 * sizeof(UINT32)));
+	}
+	trace_num_dropped = 0;
+}
+#endif
@@ -14,12 +14,101 @@ void fla_update_bank_state();
 BOOL8 fla_is_bank_idle(UINT8 const bank);
 BOOL8 fla_is_bank_complete(UINT8 const bank);
 UINT8 fla_get_idle_bank();
+UINT8 fla_get_num_idle_banks();
 
 void fla_read_page(vp_t const vp, UINT8 const sect_offset,
 			UINT8 const num_sectors, UINT32 const rd_buf);
 void fla_write_page(vp_t const vp, UINT8 const sect_offset,
 			UINT8 const num_sectors, UINT32 const wr_buf);
+void fla_erase_block(UINT8 const bank, UINT32 const vblk);
+/* Copy a page to another page in the same bank without DRAM round-trip;
+ * modified copyback replaces some sectors with the ones in *wr_buf* */
+void fla_copyback_page(vp_t const src_vp, vp_t const dst_vp);
+void fla_modified_copyback_page(vp_t const src_vp, vp_t const dst_vp,
+				UINT8 const sect_offset, UINT8 const num_sectors,
+				UINT32 const wr_buf);
 
 void fla_copy_buffer(UINT32 const target_buf, UINT32 const src_buf,
 		    sectors_mask_t const mask);
+
+/*
+ * Owner of flash commands
+ *
+ * The next flash command is issued on behalf of the owner given by the last
+ * call to fla_set_owner(), which is cleared after each command. Programs are
+ * accounted by source to measure write amplification (see counters.h), and
+ * all commands are traced with their owners. Commands without owners have
+ * source FLA_SRC_NONE, thread FLA_NO_THREAD and lpn NULL_LPN.
+ * */
+typedef enum {
+	FLA_SRC_NONE,
+	FLA_SRC_USER,		/* read and write of host */
+	FLA_SRC_PMT,		/* load and flush of PMT */
+	FLA_SRC_META,		/* block summaries and other metadata */
+	FLA_SRC_GC,		/* relocation and erase of victim blocks */
+	NUM_FLA_SOURCES
+} fla_source_t;
+
+#define FLA_NO_THREAD		0xFF
+
+void fla_set_owner(UINT8 const tid, fla_source_t const source,
+		   UINT32 const lpn);
+
+/*
+ * Flash tracer
+ *
+ * Every flash command issued by fla_* functions and its completion, as
+ * observed by fla_update_bank_state(), is recorded as an event into a ring
+ * buffer in DRAM, together with its owner.
+ *
+ * Events are drained from the ring buffer, one sector at a time, either by
+ * fla_trace_export() (see vendor SMART log TSSD_LOG_FLASH_TRACE) or by
+ * fla_trace_dump() over UART. If the ring buffer is full, the oldest events
+ * are dropped. Timestamps are in ticks of a free-running timer, which
+ * wraps around every ~785s.
+ *
+ * An event is four UINT32 words:
+ *
+ *	timestamp,
+ *	bank | op << 8 | thread id << 16 | source << 24,
+ *	lpn (or PMT index for FLA_SRC_PMT, or key in block summary for
+ *	     FLA_SRC_GC, see gc.h),
+ *	vpn | num_sectors << 24
+ *
+ * where an erase has the vpn of the first page of the block. A sector of
+ * the log starts with fla_trace_header_t, which is followed by events.
+ * */
+typedef enum {
+	FLA_TRACE_READ,
+	FLA_TRACE_PROGRAM,
+	FLA_TRACE_ERASE,
+	FLA_TRACE_COPYBACK,
+	FLA_TRACE_COMPLETE
+} fla_trace_op_t;
+
+#define FLA_TRACE_MAGIC		0x54465354	/* "TSFT" */
+#define FLA_TRACE_VERSION	1
+
+typedef struct {
+	UINT32	magic;
+	UINT32	version;
+	UINT32	num_events;	/* in this sector */
+	UINT32	num_dropped;	/* since the last drain */
+	UINT32	ticks_per_sec;
+	UINT32	reserved[3];
+} fla_trace_header_t;
+
+#define FLA_TRACE_EVENT_BYTES		(4 * sizeof(UINT32))
+#define FLA_TRACE_EVENTS_PER_SECTOR	((BYTES_PER_SECTOR - \
+					  sizeof(fla_trace_header_t)) / \
+					 FLA_TRACE_EVENT_BYTES)
+
+#if OPTION_FLA_TRACE
+void fla_trace_init();
+/* Drain events into one sector of DRAM buffer; return number of events */
+UINT32 fla_trace_export(UINT32 const buf);
+void fla_trace_dump();
+#else
+#define fla_trace_init()
+#endif
 #endif
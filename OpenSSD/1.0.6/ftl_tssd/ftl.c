@@ -9,10 +9,21 @@
 #include "scheduler.h"
 #include "ftl_thread.h"
 #include "pmt_thread.h"
+#include "gc_thread.h"
+#include "erase_thread.h"
 #include "sata_manager.h"
+#include "fla.h"
+#include "dac.h"
+#include "counters.h"
 #if OPTION_ACL
 	#include "acl.h"
 #endif
+#if OPTION_LAZY_MERGE
+	#include "psp.h"
+#endif
+#if OPTION_FDE
+	#include "fde.h"
+#endif
 
 /* ========================================================================= *
  * Macros, Data Structure and Gloal Variables
@@ -29,6 +40,28 @@
 		uart_print("Size of %s == %uMB", (name), (size) / _MB);\
 } while(0);
 
+/* Write buffer is drained by several threads in parallel, one buffer per idle
+ * bank, once the number of used buffers reaches the high watermark; it is
+ * drained until the low watermark is reached, or until empty when host has
+ * been idle for WRITE_BUFFER_IDLE_DRAIN_US. A ready staging page of a
+ * sequential stream is drained as soon as there is an idle bank, so that host
+ * writes never wait for its program. Staging pages that are still being
+ * filled are never drained, or the gaps between the commands of a sequential
+ * stream would program partial pages. */
+#define WRITE_BUFFER_HIGH_WATERMARK	(NUM_WRITE_BUFFERS * 3 / 4)
+#define WRITE_BUFFER_LOW_WATERMARK	(NUM_WRITE_BUFFERS / 4)
+#define WRITE_BUFFER_IDLE_DRAIN_US	1000
+
+/* Idle time of host is measured by a free-running timer; TIMER_CH2 and
+ * TIMER_CH3 are taken by tests and the flash tracer */
+#define IDLE_TIMER			TIMER_CH1
+#define IDLE_TIMER_PRESCALE		TIMER_PRESCALE_1
+/* PRESCALE_TO_DIV takes the prescale before shifted */
+#define IDLE_TIMER_TICKS(us)		((UINT32)((UINT64)(us) * \
+					 (CLOCK_SPEED / 2 / \
+					  PRESCALE_TO_DIV(IDLE_TIMER_PRESCALE >> 2)) \
+					 / 1000000))
+
 /* ========================================================================= *
  * Private Functions
  * ========================================================================= */
@@ -42,6 +75,53 @@ static void sanity_check(void)
 			COPY_BUF_ADDR % BYTES_PER_PAGE != 0);
 }
 
+static BOOL8  host_was_idle;
+static UINT32 host_idle_since;
+
+/* Return how long host has been idle, in ticks of IDLE_TIMER */
+static UINT32 host_idle_ticks(BOOL8 const host_idle)
+{
+	if (!host_idle) {
+		host_was_idle = FALSE;
+		return 0;
+	}
+
+	UINT32 now = GET_TIMER_VALUE(IDLE_TIMER);
+	if (!host_was_idle) {
+		host_was_idle	= TRUE;
+		host_idle_since	= now;
+	}
+	/* the timer counts down */
+	return host_idle_since - now;
+}
+
+static void drain_write_buffer(BOOL8 const long_idle)
+{
+	UINT8 num_used = write_buffer_num_used_buffers(),
+	      target_num_used;
+	if (num_used >= WRITE_BUFFER_HIGH_WATERMARK)
+		target_num_used = WRITE_BUFFER_LOW_WATERMARK;
+	else if (long_idle)
+		target_num_used = 0;
+	else if (write_buffer_has_ready_page())
+		target_num_used = num_used - 1;
+	else
+		return;
+
+	UINT8 num_drainable = write_buffer_num_drainable_buffers(),
+	      num_idle_banks = fla_get_num_idle_banks();
+	while (num_used > target_num_used && num_drainable > 0 &&
+	       num_idle_banks > 0 && thread_can_allocate()) {
+		thread_t *drain_thread = thread_allocate();
+		ftl_drain_thread_init(drain_thread);
+		enqueue(drain_thread);
+
+		num_used--;
+		num_drainable--;
+		num_idle_banks--;
+	}
+}
+
 static void print_info(void)
 {
 	uart_print("TrustedSSD FTL");
@@ -78,21 +158,49 @@ void ftl_open(void) {
 	disable_irq();
 	flash_clear_irq();
 
+	start_interval_measurement(IDLE_TIMER, IDLE_TIMER_PRESCALE);
+	host_was_idle = FALSE;
+
 	/* the initialization order indicates the dependencies between modules */
+	counters_init();
+	fla_trace_init();
 	gtd_init();
 
 	page_lock_init();
 	bb_init();
 	gc_init();
+	dac_init();
+#if OPTION_ACL
+	acl_init();
+#endif
+#if OPTION_FDE
+	fde_init();
+#endif
 
 	read_buffer_init();
 	write_buffer_init();
+#if OPTION_LAZY_MERGE
+	psp_init();
+#endif
 
 	/* Run PMT thread */
 	thread_t* pmt_thread = thread_allocate();
 	pmt_thread_init(pmt_thread);
 	enqueue(pmt_thread);
 
+	/* Run erase thread; it is scheduled before GC thread, so that a bank
+	 * that becomes idle is taken by an erase first: host writes may be
+	 * waiting for erased blocks, while GC would keep the bank busy until
+	 * it runs out of victims */
+	thread_t* erase_thread = thread_allocate();
+	erase_thread_init(erase_thread);
+	enqueue(erase_thread);
+
+	/* Run GC thread */
+	thread_t* gc_thread = thread_allocate();
+	gc_thread_init(gc_thread);
+	enqueue(gc_thread);
+
 	flash_clear_irq();
 	// This example FTL can handle runtime bad block interrupts and read fail (uncorrectable bit errors) interrupts
 	SETREG(INTR_MASK, FIRQ_DATA_CORRUPT | FIRQ_BADBLK_L | FIRQ_BADBLK_H);
@@ -202,6 +310,10 @@ BOOL8 ftl_main(void)
 			if (!sata_has_next_rw_cmd()) break;
 			sata_get_next_rw_cmd(&sata_cmd);
 			ASSERT(sata_cmd.sector_count > 0);
+			counter_add(sata_cmd.cmd_type == READ ?
+					COUNTER_HOST_READ_SECTORS :
+					COUNTER_HOST_WRITE_SECTORS,
+				    sata_cmd.sector_count);
 
 			/* uart_print("!!! %s cmd: lba = %u, sector_count = %u", */
 			/* 	    sata_cmd.cmd_type == READ ? "READ" : "WRITE", */
@@ -248,7 +360,23 @@ BOOL8 ftl_main(void)
 		sata_cmd.sector_count -= num_sectors;
 	}
 
+	BOOL8 host_idle = sata_manager_are_all_tasks_finished()
+				&& ftl_all_sata_cmd_accepted();
+	/* flush write buffer in background */
+	drain_write_buffer(host_idle_ticks(host_idle) >=
+			   IDLE_TIMER_TICKS(WRITE_BUFFER_IDLE_DRAIN_US));
+	/* reclaim blocks and fill up the pools of erased blocks while host is
+	 * idle */
+	if (host_idle) {
+		gc_thread_wakeup();
+		erase_thread_wakeup();
+	}
+
+	/* write the summaries of full blocks on idle banks */
+	gc_write_summaries();
+
 	/* scheduler runs all threads enqueud */
+	counters_sample_threads(thread_num_allocated());
 	schedule();
 
 	BOOL8 idle = sata_manager_are_all_tasks_finished()
@@ -258,6 +386,8 @@ BOOL8 ftl_main(void)
 
 void ftl_flush(void) {
 	INFO("ftl", "ftl_flush is called");
+
+	gc_flush();
 }
 
 void ftl_isr(void) {
@@ -8,9 +8,16 @@
 #include "signal.h"
 #include "page_lock.h"
 #include "dram.h"
+#include "counters.h"
 #if OPTION_ACL
 #include "acl.h"
 #endif
+#if OPTION_LAZY_MERGE
+#include "psp.h"
+#endif
+#if OPTION_FDE
+#include "fde.h"
+#endif
 
 #if OPTION_FTL_VERIFY
 void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
@@ -24,26 +31,40 @@ void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
  * virtual page
  * */
 typedef struct {
-	vp_t		vp;
 	sectors_mask_t	target_sectors;
+	vp_t		vp;
 	BOOL8		is_issued:1;
 	BOOL8		is_done:1;
 	BOOL8		has_holes:1;
-#if OPTION_ACL
-	BOOL8		is_authenticated:1;
+#if OPTION_FDE
+	BOOL8		is_decrypted:1;
 #endif
 	UINT8		managed_buf_id;
 } segment_t;
 
+#if OPTION_FDE
+#define segment_init_fde(seg)	((seg)->is_decrypted = FALSE)
+#else
+#define segment_init_fde(seg)
+#endif
+
 #define segment_init(seg, vp)	do {				\
 		(seg)->vp = (vp);				\
 		(seg)->target_sectors = 0;			\
 		(seg)->is_issued = FALSE;			\
 		(seg)->is_done = FALSE;				\
 		(seg)->has_holes = FALSE;			\
+		segment_init_fde(seg);				\
 		(seg)->managed_buf_id = NULL_BUF_ID;		\
 	} while(0)
 
+/* A partial sub-page (see psp.h) is read from two virtual pages */
+#if OPTION_LAZY_MERGE
+#define MAX_NUM_SEGMENTS	(SUB_PAGES_PER_PAGE + PSP_MAX_ENTRIES_PER_LPN)
+#else
+#define MAX_NUM_SEGMENTS	SUB_PAGES_PER_PAGE
+#endif
+
 static BOOL8 check_segment_has_holes(segment_t *seg)
 {
 	sectors_mask_t sectors = seg->target_sectors;
@@ -66,9 +87,28 @@ begin_thread_variables
 	user_id_t	uid;
 #endif
 	UINT8		num_segments;
-	segment_t	segments[SUB_PAGES_PER_PAGE];
+	segment_t	segments[MAX_NUM_SEGMENTS];
 end_thread_variables
 
+static void add_segment_sectors(vp_t const vp, sectors_mask_t const sectors)
+{
+	if (sectors == 0) return;
+
+	segment_t *segments = var(segments);
+	segment_t *seg; UINT8 seg_i;
+	for (seg_i = 0; seg_i < var(num_segments); seg_i++) {
+		seg = &segments[seg_i];
+		if (vp_equal(seg->vp, vp)) break;
+	}
+	if (seg_i == var(num_segments)) {
+		ASSERT(seg_i < MAX_NUM_SEGMENTS);
+		seg = &segments[seg_i];
+		segment_init(seg, vp);
+		var(num_segments)++;
+	}
+	seg->target_sectors |= sectors;
+}
+
 begin_thread_handler
 /* Try write buffer first */
 phase(BUFFER_PHASE) {
@@ -81,6 +121,8 @@ phase(BUFFER_PHASE) {
 #endif
 				sata_rd_buf);
 	if (buffered_sectors) {
+		counter_add(COUNTER_WRITE_BUFFER_HIT_SECTORS,
+			    count_sectors(buffered_sectors));
 		var(target_sectors) &= ~buffered_sectors;
 		if (var(target_sectors) == 0) goto_phase(SATA_PHASE);
 	}
@@ -99,8 +141,7 @@ phase(PMT_LOAD_PHASE) {
 	}
 
 	/* Iterate each sub-page to make segments */
-	UINT8	num_segments = 0;
-	segment_t *segments  = var(segments);
+	var(num_segments) = 0;
 	UINT8	begin_sp  = begin_subpage(var(target_sectors)),
 		end_sp	  = end_subpage(var(target_sectors));
 	for (UINT8 sp_i = begin_sp; sp_i < end_sp; sp_i++) {
@@ -110,30 +151,32 @@ phase(PMT_LOAD_PHASE) {
 		sectors_mask_t sp_target_sectors = var(target_sectors) & sp_sectors;
 		if (sp_target_sectors == 0) continue;
 
+#if OPTION_ACL
+		/* fill the sub-page with 0s if authentication fails */
+		if (!acl_authenticate(var(uid), var(lpn), sp_i)) {
+			fla_copy_buffer(sata_rd_buf, ALL_ZERO_BUF,
+					sp_target_sectors);
+			continue;
+		}
+#endif
+
 		vp_t	vp;
 		pmt_get_vp(var(lpn), sp_i, &vp);
 
-		segment_t *seg; UINT8 seg_i;
-		for (seg_i = 0; seg_i < num_segments; seg_i++) {
-			seg = &segments[seg_i];
-			if (vp_equal(seg->vp, vp)) break;
+#if OPTION_LAZY_MERGE
+		/* merge partial sub-page */
+		vp_t	base_vp;
+		UINT8	sp_mask;
+		if (psp_get(var(lpn), sp_i, &base_vp, &sp_mask)) {
+			sectors_mask_t vp_sectors = ((sectors_mask_t)sp_mask)
+						<< (sp_i * SECTORS_PER_SUB_PAGE);
+			add_segment_sectors(base_vp,
+					sp_target_sectors & ~vp_sectors);
+			sp_target_sectors &= vp_sectors;
 		}
-		if (seg_i == num_segments) {
-			seg = &segments[num_segments];
-			segment_init(seg, vp);
-#if OPTION_ACL
-			seg->is_authenticated = acl_authenticate(var(uid), vp);
 #endif
-			num_segments++;
-		}
-		seg->target_sectors |= sp_target_sectors;
+		add_segment_sectors(vp, sp_target_sectors);
 	}
-
-	var(num_segments) = num_segments;
-
-	/* we can safely unlock the page to read as soon as we know where to
-	 * find the pages */
-	unlock_page(var(lpn));
 }
 /* Do flash read */
 phase(FLASH_READ_PHASE) {
@@ -168,16 +211,6 @@ phase(FLASH_READ_PHASE) {
 			continue;
 		}
 
-#if OPTION_ACL
-		/* fill the segment with 0s if authentication fails */
-		if (!seg->is_authenticated) {
-			fla_copy_buffer(sata_rd_buf, ALL_ZERO_BUF,
-					seg->target_sectors);
-			seg->is_done = TRUE;
-			continue;
-		}
-#endif
-
 		/* try to reader buffer */
 		UINT32 read_buf = NULL;
 		read_buffer_get(seg->vp, &read_buf);
@@ -209,10 +242,45 @@ phase(FLASH_READ_PHASE) {
 		UINT8 sect_offset = begin_sector(seg->target_sectors),
 		      num_sectors = end_sector(seg->target_sectors)
 					- sect_offset;
+		flash_owner(FLA_SRC_USER, var(lpn));
 		fla_read_page(seg->vp, sect_offset, num_sectors, rd_buf);
 		seg->is_issued = TRUE;
 	}
 
+	/* we can safely unlock the page to read as soon as all flash read cmds
+	 * are issued; until then, GC must not erase the blocks to read */
+	BOOL8 all_issued = TRUE;
+	for (seg_i = 0; seg_i < var(num_segments); seg_i++) {
+		seg = & var(segments)[seg_i];
+		if (!seg->is_issued && !seg->is_done) all_issued = FALSE;
+	}
+	if (all_issued) unlock_page(var(lpn));
+
+#if OPTION_FDE
+	/* Decrypt the segments that have been read from flash. Decryption is
+	 * CPU-bound, so only one segment is decrypted each time the thread is
+	 * run, which lets other threads issue flash commands in between. */
+	BOOL8 decrypted = FALSE;
+	for (seg_i = 0; seg_i < var(num_segments); seg_i++) {
+		seg = & var(segments)[seg_i];
+		if (!seg->is_done || seg->is_decrypted) continue;
+
+		/* sectors that are never written are not encrypted */
+		if (seg->vp.vpn != 0 && fde_is_enabled()) {
+			if (decrypted) run_later();
+#if OPTION_ACL
+			user_id_t uid = var(uid);
+#else
+			user_id_t uid = DEFAULT_USER_ID;
+#endif
+			fde_decrypt_page(sata_rd_buf, var(lpn),
+					 seg->target_sectors, uid);
+			decrypted = TRUE;
+		}
+		seg->is_decrypted = TRUE;
+	}
+#endif
+
 	if (interesting_signals) sleep(interesting_signals);
 }
 /* Update SATA buffer pointers */
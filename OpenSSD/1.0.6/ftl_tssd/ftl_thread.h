@@ -15,5 +15,8 @@ typedef struct {
 
 void ftl_read_thread_init(thread_t *t, const ftl_cmd_t *cmd);
 void ftl_write_thread_init(thread_t *t, const ftl_cmd_t *cmd);
+/* A drain thread is a write thread that has no SATA request to serve; it
+ * only flushes a victim buffer of write buffer to flash */
+void ftl_drain_thread_init(thread_t *t);
 
 #endif
@@ -9,9 +9,16 @@
 #include "page_lock.h"
 #include "dram.h"
 #include "gc.h"
+#include "dac.h"
 #if OPTION_ACL
 #include "acl.h"
 #endif
+#if OPTION_LAZY_MERGE
+#include "psp.h"
+#endif
+#if OPTION_FDE
+#include "fde.h"
+#endif
 
 #define sata_wr_buf	(SATA_WR_BUF_PTR(var(seq_id) % NUM_SATA_WR_BUFFERS))
 
@@ -38,8 +45,18 @@ begin_thread_variables
 	UINT32		buf;
 	sectors_mask_t	valid_sectors;
 	UINT32		sp_lpn[SUB_PAGES_PER_PAGE];
+#if OPTION_ACL
+	user_id_t	sp_uid[SUB_PAGES_PER_PAGE];
+#endif
 	vp_t		sp_old_vp[SUB_PAGES_PER_PAGE];
 	UINT8		sp_rd_buf_id[SUB_PAGES_PER_PAGE];
+#if OPTION_LAZY_MERGE
+	UINT8		sp_merge_decided;
+#endif
+#if OPTION_FDE
+	sectors_mask_t	plain_sectors;
+	UINT8		sp_encrypted;
+#endif
 end_thread_variables
 
 static void copy_subpage_missing_sectors(UINT32 const target_buf,
@@ -53,37 +70,98 @@ static void copy_subpage_missing_sectors(UINT32 const target_buf,
 	fla_copy_buffer(target_buf, src_buf, sp_missing_sectors);
 }
 
+#if OPTION_FDE
+/* The missing sectors of a sub-page are filled with plaintext instead of the
+ * ciphertext in flash, so they are encrypted along with the new data */
+#define set_plain_subpage(sp_i)	(var(plain_sectors) |= init_mask(	\
+					(sp_i) * SECTORS_PER_SUB_PAGE,	\
+					SECTORS_PER_SUB_PAGE))
+#else
+#define set_plain_subpage(sp_i)
+#endif
+
+#if OPTION_LAZY_MERGE
+/* The missing sectors of a sub-page in old vp are read into the new page, so
+ * the base vp of old vp, if any, is only needed for the sectors in neither */
+static void merge_subpage_eagerly(UINT32 const lpn, UINT8 const sp_i,
+				  UINT8 const sp_mask)
+{
+	vp_t base_vp; UINT8 old_mask;
+	if (!psp_get(lpn, sp_i, &base_vp, &old_mask)) return;
+
+	if ((sp_mask | old_mask) == 0xFF) {
+		gc_invalidate(base_vp.bank, base_vp.vpn);
+		psp_remove(lpn, sp_i);
+		return;
+	}
+	psp_set(lpn, sp_i, base_vp, sp_mask | old_mask);
+}
+
+/* Return TRUE if the missing sectors of a partial sub-page need not be read
+ * from flash; they are left where they are and merged lazily by readers */
+static BOOL8 merge_subpage_lazily(UINT32 const lpn, UINT8 const sp_i,
+				  UINT8 const sp_mask, vp_t const old_vp)
+{
+	vp_t base_vp; UINT8 old_mask;
+	if (!psp_get(lpn, sp_i, &base_vp, &old_mask))
+		return psp_set(lpn, sp_i, old_vp, sp_mask);
+
+	/* the missing sectors are all in old vp */
+	if ((sp_mask | old_mask) == 0xFF) {
+		gc_invalidate(base_vp.bank, base_vp.vpn);
+		return psp_set(lpn, sp_i, old_vp, sp_mask);
+	}
+	/* the missing sectors are all in base vp */
+	if ((sp_mask & old_mask) == old_mask)
+		return psp_set(lpn, sp_i, base_vp, sp_mask);
+	/* otherwise, read the sectors in old vp and keep the rest in base vp */
+	merge_subpage_eagerly(lpn, sp_i, sp_mask);
+	return FALSE;
+}
+
+static BOOL8 is_base_vp(UINT32 const lpn, UINT8 const sp_i, vp_t const vp)
+{
+	vp_t base_vp; UINT8 sp_mask;
+	return psp_get(lpn, sp_i, &base_vp, &sp_mask) && vp_equal(base_vp, vp);
+}
+#endif
+
+static void flush_write_buffer()
+{
+	UINT8 managed_buf_id = NULL_BUF_ID;
+	write_buffer_flush(&managed_buf_id,
+			&var(valid_sectors),
+			var(sp_lpn)
+#if OPTION_ACL
+			,var(sp_uid)
+#endif
+			);
+	ASSERT(managed_buf_id < NUM_MANAGED_BUFFERS);
+	ASSERT(var(valid_sectors) != 0);
+
+	var(buf) = MANAGED_BUF(managed_buf_id);
+}
+
 begin_thread_handler
 /* Write buffer if possible */
 phase(BUFFER_PHASE) {
 	var(buf) = NULL;
 
+	/* drain thread flushes write buffer only */
+	if (var(num_sectors) == 0) {
+		if (write_buffer_num_drainable_buffers() == 0) end();
+		flush_write_buffer();
+	}
 	/* put partial page to write buffer */
-	if (var(num_sectors) < SECTORS_PER_PAGE) {
-#if OPTION_ACL
-		user_id_t push_buf_uid = var(uid);
-#endif
+	else if (var(num_sectors) < SECTORS_PER_PAGE) {
 		/* flush write buffer if it is full*/
-		if (write_buffer_is_full()) {
-			UINT8 managed_buf_id = NULL_BUF_ID;
-			write_buffer_flush(&managed_buf_id,
-					&var(valid_sectors),
-#if OPTION_ACL
-					&var(uid),
-#endif
-					var(sp_lpn));
-			ASSERT(managed_buf_id < NUM_MANAGED_BUFFERS);
-			ASSERT(var(valid_sectors) != 0);
-
-			var(buf) = MANAGED_BUF(managed_buf_id);
-		}
+		if (write_buffer_is_full()) flush_write_buffer();
 
 		write_buffer_push(var(lpn), var(sect_offset), var(num_sectors),
 #if OPTION_ACL
-				push_buf_uid,
+				var(uid),
 #endif
 				sata_wr_buf);
-
 		if (var(buf) == NULL) goto_phase(SATA_PHASE);
 	}
 	/* write whole page to flash directly */
@@ -91,8 +169,12 @@ phase(BUFFER_PHASE) {
 		var(buf) = sata_wr_buf;
 		var(valid_sectors) = FULL_MASK;
 
-		for (UINT8 sp_i = 0; sp_i < SUB_PAGES_PER_PAGE; sp_i++)
+		for (UINT8 sp_i = 0; sp_i < SUB_PAGES_PER_PAGE; sp_i++) {
 			var(sp_lpn)[sp_i] = var(lpn);
+#if OPTION_ACL
+			var(sp_uid)[sp_i] = var(uid);
+#endif
+		}
 
 		write_buffer_drop(var(lpn));
 	}
@@ -116,6 +198,10 @@ phase(LOCK_PHASE) {
 
 	/* prepare for next phase */
 	var(pmt_done) = 0;
+#if OPTION_FDE
+	var(plain_sectors) = var(valid_sectors);
+	var(sp_encrypted) = 0;
+#endif
 }
 phase(PMT_LOAD_PHASE) {
 	signals_t interesting_signals = 0;
@@ -149,6 +235,9 @@ phase(PMT_LOAD_PHASE) {
 	/* prepare for next phase */
 	var(cmd_done) = 0;
 	var(cmd_issued) = 0;
+#if OPTION_LAZY_MERGE
+	var(sp_merge_decided) = 0;
+#endif
 }
 /* Make sure every sub-page has no missing sectors in write buffer */
 phase(FLASH_READ_PHASE) {
@@ -164,6 +253,9 @@ phase(FLASH_READ_PHASE) {
 
 		/* if the whole sub-page is valid */
 		if (sp_mask == 0xFF) {
+#if OPTION_LAZY_MERGE
+			merge_subpage_eagerly(var(sp_lpn)[sp_i], sp_i, sp_mask);
+#endif
 			mask_set(var(cmd_done), sp_i);
 			continue;
 		}
@@ -201,10 +293,29 @@ phase(FLASH_READ_PHASE) {
 		if (rd_buf) {
 			copy_subpage_missing_sectors(var(buf), rd_buf, sp_i,
 							var(valid_sectors));
+#if OPTION_LAZY_MERGE
+			merge_subpage_eagerly(var(sp_lpn)[sp_i], sp_i, sp_mask);
+#endif
+			set_plain_subpage(sp_i);
 			mask_set(var(cmd_done), sp_i);
 			continue;
 		}
 
+#if OPTION_LAZY_MERGE
+		if (!mask_is_set(var(sp_merge_decided), sp_i)) {
+			mask_set(var(sp_merge_decided), sp_i);
+			if (merge_subpage_lazily(var(sp_lpn)[sp_i], sp_i,
+						 sp_mask, old_vp)) {
+				copy_subpage_missing_sectors(var(buf),
+						ALL_ONE_BUF, sp_i,
+						var(valid_sectors));
+				set_plain_subpage(sp_i);
+				mask_set(var(cmd_done), sp_i);
+				continue;
+			}
+		}
+#endif
+
 		/* we have to issue flash read cmd */
 		signals_set(interesting_signals, SIG_BANK(old_vp.bank));
 
@@ -212,6 +323,7 @@ phase(FLASH_READ_PHASE) {
 
 		UINT8 buf_id = var(sp_rd_buf_id)[sp_i] = buffer_allocate();
 		rd_buf = MANAGED_BUF(buf_id);
+		flash_owner(FLA_SRC_USER, var(lpn));
 		fla_read_page(old_vp, sp_i * SECTORS_PER_SUB_PAGE,
 				SECTORS_PER_SUB_PAGE, rd_buf);
 		mask_set(var(cmd_issued), sp_i);
@@ -219,16 +331,84 @@ phase(FLASH_READ_PHASE) {
 
 	if (interesting_signals) sleep(interesting_signals);
 }
+#if OPTION_FDE
+/* Encrypt the plaintext in the page, once its missing sectors are filled.
+ *
+ * Encryption is CPU-bound, so only one sub-page is encrypted each time the
+ * thread is run; between them, other threads get the chance to issue flash
+ * commands and thus encryption overlaps flash operations. */
+phase(ENCRYPT_PHASE) {
+	BOOL8 encrypted = FALSE;
+	for_each_subpage(sp_i) {
+		if (mask_is_set(var(sp_encrypted), sp_i)) continue;
+
+		/* sub-pages of no LPN are never read */
+		UINT32 lpn = var(sp_lpn)[sp_i];
+		sectors_mask_t sp_plain_sectors = var(plain_sectors) &
+			init_mask(sp_i * SECTORS_PER_SUB_PAGE,
+				  SECTORS_PER_SUB_PAGE);
+		if (lpn != NULL_LPN && sp_plain_sectors) {
+			if (encrypted) run_later();
+#if OPTION_ACL
+			user_id_t uid = var(sp_uid)[sp_i];
+#else
+			user_id_t uid = DEFAULT_USER_ID;
+#endif
+			fde_encrypt_page(var(buf), lpn, sp_plain_sectors, uid);
+			encrypted = fde_is_enabled();
+		}
+		mask_set(var(sp_encrypted), sp_i);
+	}
+}
+#endif
 phase(BANK_PHASE) {
-	UINT8 idle_bank  = fla_get_idle_bank();
+	/* a page is not free until all its sub-pages are dead, so the coldest
+	 * sub-page decides the stream of the page */
+	UINT8 temp = DAC_NUM_TEMPERATURES - 1;
+	UINT32 last_lpn = NULL_LPN;
+	for_each_subpage(sp_i) {
+		UINT32 lpn = var(sp_lpn)[sp_i];
+		if (last_lpn == lpn || lpn == NULL_LPN) continue;
+		temp = MIN(temp, dac_get_temperature(lpn));
+		last_lpn = lpn;
+	}
+#if OPTION_ACL
+	/* sub-pages of a page may have different owners; write buffer prefers
+	 * to pack owners of the same uid group, and the group that owns most
+	 * of them decides the stream of the page */
+	UINT8 group_num_sps[GC_NUM_UID_GROUPS] = {0}, max_num_sps = 0;
+	user_id_t stream_uid = DEFAULT_USER_ID;
+	for_each_subpage(sp_i) {
+		user_id_t sp_uid = var(sp_uid)[sp_i];
+		if (sp_uid == NULL_USER_ID) continue;
+
+		UINT8 num_sps = ++group_num_sps[GC_UID_GROUP(sp_uid)];
+		if (num_sps > max_num_sps) {
+			max_num_sps = num_sps;
+			stream_uid  = sp_uid;
+		}
+	}
+	UINT8 stream = GC_USER_STREAM(stream_uid, temp);
+#else
+	UINT8 stream = GC_USER_STREAM(DEFAULT_USER_ID, temp);
+#endif
+
+	UINT8 idle_bank  = gc_get_idle_bank(stream);
 	if (idle_bank >= NUM_BANKS) sleep(SIG_ALL_BANKS);
 
+	/* the LPNs of sub-pages are their keys in block summary */
 	var(vp).bank	= idle_bank;
-	var(vp).vpn	= gc_allocate_new_vpn(idle_bank, FALSE);
+	var(vp).vpn	= gc_allocate_new_vpn(idle_bank, stream, var(sp_lpn));
 
-#if OPTION_ACL
-	acl_authorize(var(uid), var(vp));
-#endif
+	/* a logical page is updated once per program, however many host
+	 * writes are merged into it */
+	last_lpn = NULL_LPN;
+	for_each_subpage(sp_i) {
+		UINT32 lpn = var(sp_lpn)[sp_i];
+		if (last_lpn == lpn || lpn == NULL_LPN) continue;
+		dac_record_write(lpn);
+		last_lpn = lpn;
+	}
 }
 phase(PMT_UPDATE_PHASE) {
 	for_each_subpage(sp_i) {
@@ -237,7 +417,16 @@ phase(PMT_UPDATE_PHASE) {
 		if (lpn == NULL_LPN) continue;
 
 		ASSERT(pmt_is_loaded(lpn));
+		vp_t old_vp = var(sp_old_vp)[sp_i];
+#if OPTION_LAZY_MERGE
+		/* old vp keeps the missing sectors of a partial sub-page */
+		if (is_base_vp(lpn, sp_i, old_vp)) old_vp.vpn = 0;
+#endif
+		if (old_vp.vpn != 0) gc_invalidate(old_vp.bank, old_vp.vpn);
 		pmt_update_vp(lpn, sp_i, var(vp));
+#if OPTION_ACL
+		acl_authorize(var(sp_uid)[sp_i], lpn, sp_i);
+#endif
 		pmt_unfix(lpn);
 	}
 
@@ -256,6 +445,7 @@ phase(FLASH_WRITE_PHASE) {
 					* SECTORS_PER_SUB_PAGE,
 				sect_offset = begin_i,
 				num_sectors = end_i - begin_i;
+			flash_owner(FLA_SRC_USER, var(lpn));
 			fla_write_page(var(vp), sect_offset,
 					num_sectors, var(buf));
 			var(cmd_issued) = TRUE;
@@ -280,7 +470,7 @@ phase(FLASH_WRITE_PHASE) {
 	if (buf_id != NULL_BUF_ID) buffer_free(buf_id);
 }
 phase(SATA_PHASE) {
-	sata_manager_finish_write_task(var(seq_id));
+	if (var(num_sectors)) sata_manager_finish_write_task(var(seq_id));
 }
 end_thread_handler
 
@@ -308,3 +498,22 @@ void ftl_write_thread_init(thread_t *t, const ftl_cmd_t *cmd)
 #endif
 	init_thread_variables(thread_id(t));
 }
+
+void ftl_drain_thread_init(thread_t *t)
+{
+	if (registered_handler_id == NULL_THREAD_HANDLER_ID) {
+		registered_handler_id =
+			thread_handler_register(get_thread_handler());
+	}
+
+	t->handler_id = registered_handler_id;
+
+	var(seq_id) = 0;
+	var(lpn) = NULL_LPN;
+	var(sect_offset) = 0;
+	var(num_sectors) = 0;
+#if OPTION_ACL
+	var(uid) = NULL_USER_ID;
+#endif
+	init_thread_variables(thread_id(t));
+}
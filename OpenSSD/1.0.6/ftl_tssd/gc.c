@@ -1,34 +1,271 @@
 #include "gc.h"
+#include "gc_thread.h"
+#include "erase_thread.h"
 #include "fla.h"
 #include "bad_blocks.h"
+#include "dram.h"
+#include "mem_util.h"
+#include "counters.h"
 
 /* ==========================================================================
  * Macros and Data Structure
  * ========================================================================*/
 
+/* Block info tables (see dram.h)
+ *	EC		erase count of a block;
+ *	ERASED_EC	erase count of an erased block, NULL_EC otherwise;
+ *	ERASED_INV_EC	MAX_EC - erase count of an erased block, NULL_EC
+ *			otherwise;
+ *	FULL_EC		erase count of a full block, NULL_EC otherwise;
+ *	DIRTY_EC	erase count of a dirty block, NULL_EC otherwise;
+ *	VALID		number of valid sub-pages in a used block;
+ *	FULL_VALID	number of valid sub-pages in a full block, NULL_EC
+ *			otherwise.
+ * All but EC and VALID are searched by hardware for the block of the least
+ * (or greatest) value. */
+#define EC_TABLE		0
+#define ERASED_EC_TABLE		1
+#define ERASED_INV_EC_TABLE	2
+#define FULL_EC_TABLE		3
+#define DIRTY_EC_TABLE		4
+#define VALID_TABLE		5
+#define FULL_VALID_TABLE	6
+
+#define NULL_EC			0xFFFF
+#define MAX_EC			0xFFFE
+
+#define blk_table(table, bank)	(BLK_TABLE_ADDR(table) + \
+				 (bank) * BLK_TABLE_BYTES_PER_BANK)
+#define get_blk_info(table, bank, vblk)	\
+		read_dram_16(blk_table(table, bank) + (vblk) * sizeof(UINT16))
+#define set_blk_info(table, bank, vblk, val)	\
+		write_dram_16(blk_table(table, bank) + (vblk) * sizeof(UINT16),\
+			      (val))
+#define find_min_blk_info(table, bank)	\
+		mem_search_min_max(blk_table(table, bank), sizeof(UINT16),\
+				   VBLKS_PER_BANK, MU_CMD_SEARCH_MIN_DRAM)
+
+/* Erase counts are written to the misc block of a bank, one page per flush,
+ * until the block is full and erased. The first vblk of each bank is
+ * reserved, so the entry of vblk 0 in a persisted table is a signature. */
+#define EC_TABLE_SIGNATURE	0x5745	/* "WE" */
+#define EC_TABLE_SECTORS	(BLK_TABLE_BYTES_PER_BANK / BYTES_PER_SECTOR)
+
+#define NULL_VPN		0
+
 typedef struct
 {
-	/* one is for user data; the other is for sys data */
-	UINT32	next_vpn[2];
-	UINT32	next_free_block;
-	UINT32	num_free_blocks;
+	UINT32	next_vpn[GC_NUM_STREAMS];
+	UINT8	summary_buf_ids[GC_NUM_STREAMS];
+	/* bitmap of free summary buffers */
+	UINT32	free_summary_bufs;
+	/* FIFO of full blocks whose summaries are not written */
+	UINT32	pending_vblks[GC_MAX_PENDING_SUMMARIES];
+	UINT8	pending_buf_ids[GC_MAX_PENDING_SUMMARIES];
+	UINT8	pending_head;
+	UINT8	num_pending;
+	UINT32	num_erased_blocks;
+	UINT32	num_dirty_blocks;
+	UINT32	misc_vblk;
+	UINT32	misc_next_page;
+	UINT16	max_ec;
+	BOOL8	ec_dirty;
 } gc_metadata;
 
 static gc_metadata _metadata[NUM_BANKS];
 
+/* static wear leveling */
+static UINT32	wl_num_credits;
+static UINT32	wl_num_writes;
+static UINT8	wl_next_bank;
+
+/* flash time that GC can spend to reclaim blocks */
+static UINT32	gc_budget_us;
+
 /* ==========================================================================
  * Private Functions
  * ========================================================================*/
 
-static void find_next_good_vblk(UINT32 const bank, UINT32 *next_good_vblk)
+static UINT32 find_next_good_vblk(UINT32 const bank, UINT32 vblk)
+{
+	while (vblk < VBLKS_PER_BANK && bb_is_bad(bank, vblk)) vblk++;
+
+	BUG_ON("no good block for misc block", vblk == VBLKS_PER_BANK);
+	return vblk;
+}
+
+static BOOL8 is_data_vblk(UINT32 const bank, UINT32 const vblk)
+{
+	return vblk != 0 && vblk != _metadata[bank].misc_vblk &&
+		!bb_is_bad(bank, vblk);
+}
+
+static BOOL8 read_misc_page(UINT32 const bank, UINT32 const page,
+			    UINT32 const num_sectors, UINT32 const buf)
+{
+	nand_page_ptread(bank, _metadata[bank].misc_vblk, page, 0, num_sectors,
+			 buf, RETURN_WHEN_DONE);
+	bank_counter_inc(BANK_COUNTER_FLASH_READS, bank);
+
+	UINT32 intr_flags = BSP_INTR(bank);
+	CLR_BSP_INTR(bank, intr_flags);
+	return (intr_flags & (FIRQ_DATA_CORRUPT | FIRQ_ALL_FF)) == 0 &&
+		read_dram_16(buf) == EC_TABLE_SIGNATURE;
+}
+
+static void load_erase_counts(UINT32 const bank)
+{
+	gc_metadata *meta = &_metadata[bank];
+	UINT32 ec_table = blk_table(EC_TABLE, bank);
+
+	/* find the last page written to misc block */
+	UINT32 page = 0;
+	while (page < PAGES_PER_VBLK &&
+	       read_misc_page(bank, page, 1, TEMP_BUF_ADDR))
+		page++;
+	meta->misc_next_page = page;
+
+	if (page > 0 &&
+	    read_misc_page(bank, page - 1, EC_TABLE_SECTORS, ec_table))
+		return;
+
+	INFO("gc>init", "bank %u: no erase counts found", bank);
+	mem_set_dram(ec_table, 0, BLK_TABLE_BYTES_PER_BANK);
+	write_dram_16(ec_table, EC_TABLE_SIGNATURE);
+	/* the content of misc block is unknown */
+	meta->misc_next_page = PAGES_PER_VBLK;
+}
+
+static void set_dirty(UINT32 const bank, UINT32 const vblk)
 {
-	while (*next_good_vblk < VBLKS_PER_BANK && bb_is_bad(bank, *next_good_vblk))
-		(*next_good_vblk)++;
+	set_blk_info(DIRTY_EC_TABLE, bank, vblk,
+		     get_blk_info(EC_TABLE, bank, vblk));
+	_metadata[bank].num_dirty_blocks++;
+}
+
+/* Dynamic wear leveling */
+static UINT32 take_erased_block(UINT32 const bank, UINT8 const stream)
+{
+	gc_metadata *meta = &_metadata[bank];
+	BUG_ON("no erased blocks", meta->num_erased_blocks == 0);
+
+	UINT32 vblk = stream == GC_RELOC_STREAM ?
+			find_min_blk_info(ERASED_INV_EC_TABLE, bank) :
+			find_min_blk_info(ERASED_EC_TABLE, bank);
+	ASSERT(get_blk_info(ERASED_EC_TABLE, bank, vblk) != NULL_EC);
+
+	set_blk_info(ERASED_EC_TABLE, bank, vblk, NULL_EC);
+	set_blk_info(ERASED_INV_EC_TABLE, bank, vblk, NULL_EC);
+	set_blk_info(VALID_TABLE, bank, vblk, 0);
+	meta->num_erased_blocks--;
 
-	BUG_ON("no available blocks; need garbage collection",
-			*next_good_vblk == VBLKS_PER_BANK);
+	if (meta->num_erased_blocks < GC_ERASED_POOL_LOW)
+		erase_thread_wakeup();
+	if (gc_get_num_free_blocks(bank) < GC_FREE_BLOCKS_LOW)
+		gc_thread_wakeup();
+	return vblk;
 }
 
+static void set_full(UINT32 const bank, UINT32 const vblk)
+{
+	set_blk_info(FULL_EC_TABLE, bank, vblk,
+		     get_blk_info(EC_TABLE, bank, vblk));
+	set_blk_info(FULL_VALID_TABLE, bank, vblk,
+		     get_blk_info(VALID_TABLE, bank, vblk));
+	/* the block may need static wear leveling or be reclaimed */
+	gc_thread_wakeup();
+}
+
+static void clear_full(UINT32 const bank, UINT32 const vblk)
+{
+	set_blk_info(FULL_EC_TABLE, bank, vblk, NULL_EC);
+	set_blk_info(FULL_VALID_TABLE, bank, vblk, NULL_EC);
+}
+
+static UINT8 allocate_summary_buf(UINT32 const bank)
+{
+	gc_metadata *meta = &_metadata[bank];
+	ASSERT(meta->free_summary_bufs != 0);
+
+	UINT8 buf_id = __builtin_ctz(meta->free_summary_bufs);
+	meta->free_summary_bufs &= ~(1 << buf_id);
+	mem_set_dram(SUMMARY_BUF(bank, buf_id), GC_NULL_KEY, GC_SUMMARY_BYTES);
+	return buf_id;
+}
+
+static void pop_pending_summary(UINT32 const bank,
+				UINT32 *vblk, UINT32 *summary_buf)
+{
+	gc_metadata *meta = &_metadata[bank];
+	ASSERT(meta->num_pending > 0);
+
+	UINT8 head = meta->pending_head;
+	UINT8 buf_id = meta->pending_buf_ids[head];
+	*vblk = meta->pending_vblks[head];
+	*summary_buf = SUMMARY_BUF(bank, buf_id);
+
+	meta->pending_head = (head + 1) % GC_MAX_PENDING_SUMMARIES;
+	meta->num_pending--;
+	/* the buffer is not reused until the bank is idle again, when the
+	 * summary has been written */
+	meta->free_summary_bufs |= (1 << buf_id);
+}
+
+/* Write the oldest pending summary of a bank, which may be busy */
+static void write_summary_sync(UINT32 const bank)
+{
+	UINT32 vblk, summary_buf;
+	pop_pending_summary(bank, &vblk, &summary_buf);
+
+	nand_page_ptprogram(bank, vblk, GC_SUMMARY_PAGE, 0, GC_SUMMARY_SECTORS,
+			    summary_buf);
+	bank_counter_inc(BANK_COUNTER_FLASH_PROGRAMS, bank);
+	counter_add(COUNTER_META_PROGRAM_SUB_PAGES,
+		    COUNT_BUCKETS(GC_SUMMARY_SECTORS, SECTORS_PER_SUB_PAGE));
+	while (BSP_FSM(bank) != BANK_IDLE);
+	set_full(bank, vblk);
+}
+
+static void close_block(UINT32 const bank, UINT8 const stream)
+{
+	gc_metadata *meta = &_metadata[bank];
+	if (meta->num_pending == GC_MAX_PENDING_SUMMARIES)
+		write_summary_sync(bank);
+
+	UINT8 tail = (meta->pending_head + meta->num_pending)
+			% GC_MAX_PENDING_SUMMARIES;
+	meta->pending_vblks[tail] = meta->next_vpn[stream] / PAGES_PER_VBLK;
+	meta->pending_buf_ids[tail] = meta->summary_buf_ids[stream];
+	meta->num_pending++;
+
+	meta->next_vpn[stream] = NULL_VPN;
+}
+
+static void earn_wl_credit(void)
+{
+	if (++wl_num_writes < GC_WL_WRITES_PER_CREDIT) return;
+	wl_num_writes = 0;
+
+	if (wl_num_credits == GC_WL_MAX_CREDITS) return;
+	if (wl_num_credits++ == 0) gc_thread_wakeup();
+}
+
+static void earn_gc_budget(void)
+{
+	gc_budget_us = MIN(gc_budget_us + GC_LATENCY_BUDGET_US,
+			   GC_MAX_BUDGET_US);
+	/* the cost of a move may have dropped since GC went to sleep */
+	gc_thread_wakeup();
+}
+
+/* Moving a page costs less of the budget as free blocks of its bank drop
+ * below GC_FREE_BLOCKS_LOW, so relocation speeds up with the deficit */
+static UINT32 page_move_cost(UINT8 const bank)
+{
+	UINT32 num_free = gc_get_num_free_blocks(bank);
+	if (num_free >= GC_FREE_BLOCKS_LOW) return GC_PAGE_MOVE_US;
+	return GC_PAGE_MOVE_US * num_free / GC_FREE_BLOCKS_LOW;
+}
 
 /* ==========================================================================
  * Public Functions
@@ -36,40 +273,308 @@ static void find_next_good_vblk(UINT32 const bank, UINT32 *next_good_vblk)
 
 void gc_init(void)
 {
-	/* first block of each bank is reserved */
-	UINT32 from_vblk = 1;
+	BUG_ON("summary buffers of a bank must fit in a bitmap",
+		NUM_SUMMARY_BUFFERS_PER_BANK > 32);
+	BUG_ON("summary must fit in a page",
+		GC_SUMMARY_SECTORS > SECTORS_PER_PAGE);
 
-	INFO("gc>init", "format flash");
-	fla_format_all(from_vblk);
+	for (UINT8 table = ERASED_EC_TABLE; table < NUM_BLK_TABLES; table++)
+		mem_set_dram(BLK_TABLE_ADDR(table), NULL_EC | (NULL_EC << 16),
+			     BLK_TABLE_BYTES);
 
 	UINT8 bank;
 	FOR_EACH_BANK(bank) {
-		_metadata[bank].next_vpn[0]  	= 0;
-		_metadata[bank].next_vpn[1] 	= 0;
-		_metadata[bank].num_free_blocks = VBLKS_PER_BANK
-					        - bb_get_num(bank)
-					        - 1;
-		_metadata[bank].next_free_block	= from_vblk;
+		gc_metadata *meta = &_metadata[bank];
+		/* first block of each bank is reserved */
+		meta->misc_vblk = find_next_good_vblk(bank, 1);
+		load_erase_counts(bank);
+	}
+
+	FOR_EACH_BANK(bank) {
+		gc_metadata *meta = &_metadata[bank];
+		for (UINT8 stream = 0; stream < GC_NUM_STREAMS; stream++)
+			meta->next_vpn[stream] = NULL_VPN;
+		meta->free_summary_bufs = (1 << NUM_SUMMARY_BUFFERS_PER_BANK) - 1;
+		meta->pending_head = 0;
+		meta->num_pending = 0;
+
+		/* blocks are erased lazily by erase thread */
+		meta->num_erased_blocks = 0;
+		meta->num_dirty_blocks = 0;
+		meta->max_ec = 0;
+		for (UINT32 vblk = 1; vblk < VBLKS_PER_BANK; vblk++) {
+			if (!is_data_vblk(bank, vblk)) continue;
+
+			set_dirty(bank, vblk);
+
+			UINT16 ec = get_blk_info(EC_TABLE, bank, vblk);
+			if (ec > meta->max_ec) meta->max_ec = ec;
+		}
+		meta->ec_dirty = FALSE;
 	}
+
+	wl_num_credits = 0;
+	wl_num_writes = 0;
+	wl_next_bank = 0;
+
+	gc_budget_us = 0;
 }
 
+void gc_flush(void)
+{
+	flash_finish();
+
+	UINT8 bank;
+	FOR_EACH_BANK(bank) {
+		gc_metadata *meta = &_metadata[bank];
+		while (meta->num_pending > 0) write_summary_sync(bank);
+
+		if (!meta->ec_dirty) continue;
 
-UINT32 gc_allocate_new_vpn(UINT32 const bank, BOOL8 const is_sys)
+		if (meta->misc_next_page == PAGES_PER_VBLK) {
+			nand_block_erase(bank, meta->misc_vblk);
+			bank_counter_inc(BANK_COUNTER_FLASH_ERASES, bank);
+			meta->misc_next_page = 0;
+
+			UINT16 ec = get_blk_info(EC_TABLE, bank, meta->misc_vblk);
+			if (ec < MAX_EC)
+				set_blk_info(EC_TABLE, bank, meta->misc_vblk,
+					     ec + 1);
+		}
+		nand_page_ptprogram(bank, meta->misc_vblk, meta->misc_next_page,
+				    0, EC_TABLE_SECTORS, blk_table(EC_TABLE, bank));
+		bank_counter_inc(BANK_COUNTER_FLASH_PROGRAMS, bank);
+		counter_add(COUNTER_META_PROGRAM_SUB_PAGES,
+			    COUNT_BUCKETS(EC_TABLE_SECTORS,
+					  SECTORS_PER_SUB_PAGE));
+		meta->misc_next_page++;
+		meta->ec_dirty = FALSE;
+	}
+
+	flash_finish();
+}
+
+BOOL8 gc_can_allocate_new_vpn(UINT8 const bank, UINT8 const stream)
 {
-	BUG_ON("no more free blocks", gc_get_num_free_blocks(bank) == 0);
+	if (_metadata[bank].next_vpn[stream] != NULL_VPN) return TRUE;
+	/* host cannot take the blocks reserved for GC */
+	return _metadata[bank].num_erased_blocks >
+		(stream < GC_NUM_USER_STREAMS ? GC_RESERVED_BLOCKS : 0);
+}
+
+UINT8 gc_get_idle_bank(UINT8 const stream)
+{
+	UINT8 num_idle_banks = fla_get_num_idle_banks();
+	while (num_idle_banks--) {
+		UINT8 bank = fla_get_idle_bank();
+		if (gc_can_allocate_new_vpn(bank, stream)) return bank;
+	}
+	return NUM_BANKS;
+}
+
+UINT32 gc_allocate_new_vpn(UINT32 const bank, UINT8 const stream,
+			   UINT32 const sp_keys[SUB_PAGES_PER_PAGE])
+{
+	ASSERT(stream < GC_NUM_STREAMS);
 
 	gc_metadata* meta = &_metadata[bank];
 	/* if need to find a new block */
-	if (meta->next_vpn[is_sys] % PAGES_PER_VBLK == 0) {
-		find_next_good_vblk(bank, &meta->next_free_block);
-		meta->next_vpn[is_sys] = meta->next_free_block * PAGES_PER_VBLK;
-		meta->next_free_block++;
-		meta->num_free_blocks--;
+	if (meta->next_vpn[stream] == NULL_VPN) {
+		UINT32 vblk = take_erased_block(bank, stream);
+		meta->next_vpn[stream] = vblk * PAGES_PER_VBLK;
+		meta->summary_buf_ids[stream] = allocate_summary_buf(bank);
+	}
+	UINT32 vpn = meta->next_vpn[stream]++;
+
+	/* record the keys in summary and count the valid sub-pages */
+	if (sp_keys) {
+		UINT32 summary_buf = SUMMARY_BUF(bank,
+						 meta->summary_buf_ids[stream]);
+		UINT32 key_addr = summary_buf + sizeof(UINT32) *
+				  (vpn % PAGES_PER_VBLK) * SUB_PAGES_PER_PAGE;
+		UINT16 num_valid = 0;
+		for_each_subpage(sp_i) {
+			write_dram_32(key_addr, sp_keys[sp_i]);
+			key_addr += sizeof(UINT32);
+			if (sp_keys[sp_i] != GC_NULL_KEY) num_valid++;
+		}
+
+		UINT32 vblk = vpn / PAGES_PER_VBLK;
+		set_blk_info(VALID_TABLE, bank, vblk,
+			     get_blk_info(VALID_TABLE, bank, vblk) + num_valid);
 	}
-	return meta->next_vpn[is_sys] ++;
+
+	if (vpn % PAGES_PER_VBLK == GC_DATA_PAGES_PER_VBLK - 1)
+		close_block(bank, stream);
+
+	if (stream < GC_NUM_USER_STREAMS) {
+		earn_wl_credit();
+		earn_gc_budget();
+	}
+	return vpn;
 }
 
 UINT32 gc_get_num_free_blocks(UINT8 const bank)
 {
-	return _metadata[bank].num_free_blocks;
+	return _metadata[bank].num_erased_blocks +
+		_metadata[bank].num_dirty_blocks;
+}
+
+UINT32 gc_get_erase_count(UINT8 const bank, UINT32 const vblk)
+{
+	return get_blk_info(EC_TABLE, bank, vblk);
+}
+
+void gc_write_summaries(void)
+{
+	for_each_bank(bank) {
+		if (_metadata[bank].num_pending == 0 || !fla_is_bank_idle(bank))
+			continue;
+
+		UINT32 vblk, summary_buf;
+		pop_pending_summary(bank, &vblk, &summary_buf);
+
+		vp_t vp = {
+			.bank = bank,
+			.vpn = vblk * PAGES_PER_VBLK + GC_SUMMARY_PAGE
+		};
+		fla_set_owner(FLA_NO_THREAD, FLA_SRC_META, NULL_LPN);
+		fla_write_page(vp, 0, GC_SUMMARY_SECTORS, summary_buf);
+		set_full(bank, vblk);
+	}
+}
+
+void gc_invalidate(UINT8 const bank, UINT32 const vpn)
+{
+	UINT32 vblk = vpn / PAGES_PER_VBLK;
+	UINT16 num_valid = get_blk_info(VALID_TABLE, bank, vblk);
+	ASSERT(num_valid > 0);
+	set_blk_info(VALID_TABLE, bank, vblk, num_valid - 1);
+
+	if (get_blk_info(FULL_VALID_TABLE, bank, vblk) != NULL_EC)
+		set_blk_info(FULL_VALID_TABLE, bank, vblk, num_valid - 1);
+}
+
+/* Greedy garbage collection */
+BOOL8 gc_pick_victim(BOOL8 const host_idle, UINT8 *bank, UINT32 *vblk)
+{
+	/* reclaim the bank of the fewest free blocks first */
+	UINT32 watermark = host_idle ? GC_FREE_BLOCKS_HIGH : GC_FREE_BLOCKS_LOW;
+	UINT8  victim_bank = NUM_BANKS;
+	UINT32 victim_vblk = 0;
+	for_each_bank(bank_i) {
+		UINT32 num_free = gc_get_num_free_blocks(bank_i);
+		if (num_free >= watermark) continue;
+
+		UINT32 vblk_i = find_min_blk_info(FULL_VALID_TABLE, bank_i);
+		UINT16 num_valid = get_blk_info(FULL_VALID_TABLE, bank_i, vblk_i);
+		/* nothing to gain from a block that is all valid */
+		if (num_valid >= GC_DATA_PAGES_PER_VBLK * SUB_PAGES_PER_PAGE)
+			continue;
+
+		watermark   = num_free;
+		victim_bank = bank_i;
+		victim_vblk = vblk_i;
+	}
+	if (victim_bank == NUM_BANKS) return FALSE;
+
+	clear_full(victim_bank, victim_vblk);
+	*bank = victim_bank;
+	*vblk = victim_vblk;
+	return TRUE;
+}
+
+BOOL8 gc_has_budget(UINT8 const bank, BOOL8 const host_idle)
+{
+	/* host writes earn nothing while they wait for erased blocks */
+	return host_idle || gc_budget_us >= page_move_cost(bank) ||
+		_metadata[bank].num_erased_blocks <= GC_RESERVED_BLOCKS;
+}
+
+void gc_use_budget(UINT8 const bank)
+{
+	UINT32 cost = page_move_cost(bank);
+	gc_budget_us = gc_budget_us > cost ? gc_budget_us - cost : 0;
+}
+
+/* Static wear leveling */
+BOOL8 gc_wl_pick_victim(UINT8 *bank, UINT32 *vblk)
+{
+	for (UINT8 i = 0; i < NUM_BANKS; i++) {
+		UINT8 bank_i = wl_next_bank;
+		wl_next_bank = (wl_next_bank + 1) % NUM_BANKS;
+
+		UINT32 vblk_i = find_min_blk_info(FULL_EC_TABLE, bank_i);
+		UINT16 ec = get_blk_info(FULL_EC_TABLE, bank_i, vblk_i);
+		if (ec == NULL_EC ||
+		    _metadata[bank_i].max_ec - ec < GC_WL_THRESHOLD)
+			continue;
+
+		clear_full(bank_i, vblk_i);
+		*bank = bank_i;
+		*vblk = vblk_i;
+		return TRUE;
+	}
+	return FALSE;
+}
+
+BOOL8 gc_wl_has_credit(void)
+{
+	return wl_num_credits > 0;
+}
+
+void gc_wl_use_credit(void)
+{
+	ASSERT(wl_num_credits > 0);
+	wl_num_credits--;
+}
+
+void gc_free_block(UINT8 const bank, UINT32 const vblk)
+{
+	ASSERT(is_data_vblk(bank, vblk));
+
+	set_dirty(bank, vblk);
+	erase_thread_wakeup();
+}
+
+BOOL8 gc_needs_erase(UINT8 const bank, BOOL8 const host_idle)
+{
+	gc_metadata *meta = &_metadata[bank];
+	return meta->num_dirty_blocks > 0 &&
+		meta->num_erased_blocks < (host_idle ? GC_ERASED_POOL_SIZE :
+						       GC_ERASED_POOL_LOW);
+}
+
+BOOL8 gc_pick_block_to_erase(UINT8 const bank, BOOL8 const host_idle,
+			     UINT32 *vblk)
+{
+	gc_metadata *meta = &_metadata[bank];
+	if (!gc_needs_erase(bank, host_idle)) return FALSE;
+
+	*vblk = find_min_blk_info(DIRTY_EC_TABLE, bank);
+	ASSERT(get_blk_info(DIRTY_EC_TABLE, bank, *vblk) != NULL_EC);
+
+	set_blk_info(DIRTY_EC_TABLE, bank, *vblk, NULL_EC);
+	meta->num_dirty_blocks--;
+	return TRUE;
+}
+
+void gc_erase_done(UINT8 const bank, UINT32 const vblk)
+{
+	ASSERT(is_data_vblk(bank, vblk));
+
+	gc_metadata *meta = &_metadata[bank];
+	UINT16 ec = get_blk_info(EC_TABLE, bank, vblk);
+	if (ec < MAX_EC) ec++;
+	set_blk_info(EC_TABLE, bank, vblk, ec);
+	set_blk_info(ERASED_EC_TABLE, bank, vblk, ec);
+	set_blk_info(ERASED_INV_EC_TABLE, bank, vblk, MAX_EC - ec);
+
+	meta->num_erased_blocks++;
+	meta->ec_dirty = TRUE;
+	if (ec > meta->max_ec) {
+		meta->max_ec = ec;
+		/* young blocks may need static wear leveling now */
+		gc_thread_wakeup();
+	}
 }
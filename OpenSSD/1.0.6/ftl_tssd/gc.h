@@ -3,10 +3,178 @@
 
 #include "jasmine.h"
 
+/* Pages are allocated from different streams, each of which writes to its
+ * own active block in a bank, so that data of different lifetime are not
+ * mixed in the same block. User data are split into streams by temperature
+ * (see dac.h) and, when ACL is enabled, by owner so that the pages of a user
+ * cluster in dedicated blocks; then comes the stream for system data (i.e. PMT
+ * pages) and the stream for data relocated by wear leveling, which is the
+ * coldest of all. */
+#define GC_NUM_TEMPERATURES	4
+#if OPTION_ACL
+/* users are hashed into groups to bound the number of active blocks */
+#define GC_NUM_UID_GROUPS	4
+#define GC_UID_GROUP(uid)	((uid) % GC_NUM_UID_GROUPS)
+#else
+#define GC_NUM_UID_GROUPS	1
+#define GC_UID_GROUP(uid)	0
+#endif
+#define GC_NUM_USER_STREAMS	(GC_NUM_UID_GROUPS * GC_NUM_TEMPERATURES)
+#define GC_USER_STREAM(uid, temp)	\
+		(GC_UID_GROUP(uid) * GC_NUM_TEMPERATURES + (temp))
+#define GC_SYS_STREAM		GC_NUM_USER_STREAMS
+#define GC_RELOC_STREAM		(GC_NUM_USER_STREAMS + 1)
+#define GC_NUM_STREAMS		(GC_NUM_USER_STREAMS + 2)
+
+/* *
+ * Block summary
+ *
+ * The last page of a block is not for data; it keeps the summary of the
+ * block, i.e. a key for every sub-page of the data pages, so that the data in
+ * a block can be found without scanning PMT. The key of a sub-page is
+ *	- the LPN, if the sub-page is the sub-page of the same index of the
+ *	  logical page;
+ *	- the PMT index with GC_PMT_KEY_FLAG set, if it is a PMT sub-page;
+ *	- GC_NULL_KEY, if it holds nothing.
+ * The summary is kept in DRAM while the block is active and written to the
+ * block right after its last data page is allocated.
+ * */
+#define GC_DATA_PAGES_PER_VBLK	(PAGES_PER_VBLK - 1)
+#define GC_SUMMARY_PAGE		GC_DATA_PAGES_PER_VBLK
+#define GC_SUMMARY_SECTORS	COUNT_BUCKETS(GC_DATA_PAGES_PER_VBLK * \
+					      SUB_PAGES_PER_PAGE * \
+					      sizeof(UINT32), BYTES_PER_SECTOR)
+#define GC_SUMMARY_BYTES	(GC_SUMMARY_SECTORS * BYTES_PER_SECTOR)
+/* summaries of full blocks wait in DRAM until their banks are idle */
+#define GC_MAX_PENDING_SUMMARIES	2
+
+#define GC_NULL_KEY		NULL_LPN
+#define GC_PMT_KEY_FLAG		0x80000000
+#define gc_pmt_key(pmt_idx)	(GC_PMT_KEY_FLAG | (pmt_idx))
+#define gc_key_is_pmt(key)	((key) != GC_NULL_KEY && \
+				 ((key) & GC_PMT_KEY_FLAG) != 0)
+#define gc_key_pmt_idx(key)	((key) & ~GC_PMT_KEY_FLAG)
+#define gc_summary_key(summary_buf, page, sp_i)				\
+		read_dram_32((summary_buf) + sizeof(UINT32) *		\
+			     ((page) * SUB_PAGES_PER_PAGE + (sp_i)))
+
+/* *
+ * Wear leveling
+ *
+ * Every block has an erase count, which is kept in DRAM and written to the
+ * misc block of its bank when FTL is flushed (see gc_flush()).
+ *
+ * Dynamic wear leveling: the dirty block of the least erase count is erased
+ * first, and a new block for a stream is the erased block of the least erase
+ * count, except that the relocation stream takes the erased block of the
+ * greatest erase count, as the data relocated are cold.
+ *
+ * Static wear leveling: cold data stay in young blocks forever unless they are
+ * moved. When the youngest full block of a bank is younger than the oldest
+ * block of the bank by GC_WL_THRESHOLD erases, its valid data is relocated
+ * (see gc_thread.h) and the block is freed. The relocation is rate
+ * limited: a page can be relocated only after GC_WL_WRITES_PER_CREDIT user
+ * pages are written, which bounds the cost of static wear leveling to a few
+ * percent of foreground writes.
+ * */
+#define GC_WL_THRESHOLD		64
+#define GC_WL_WRITES_PER_CREDIT	32
+#define GC_WL_MAX_CREDITS	GC_DATA_PAGES_PER_VBLK
+
+/* *
+ * Free blocks
+ *
+ * A block that is freed is dirty; it is erased in background by erase thread
+ * (see erase_thread.h) and then put into the pool of erased blocks of its
+ * bank, where new blocks are allocated from. So allocation never waits for an
+ * erase, as long as there is an erased block in the bank (see
+ * gc_get_idle_bank()).
+ *
+ * Erase thread keeps at least GC_ERASED_POOL_LOW erased blocks in a bank, and
+ * fills the pool up to GC_ERASED_POOL_SIZE blocks when host is idle. As
+ * nothing is persistent but erase counts, all blocks are dirty at boot.
+ * */
+#define GC_ERASED_POOL_LOW	2
+#define GC_ERASED_POOL_SIZE	8
+
+/* *
+ * Garbage collection
+ *
+ * Every block has a count of valid sub-pages, which is increased when a page
+ * is allocated with keys and decreased by gc_invalidate() when a sub-page is
+ * no longer referred to by PMT, GTD or, as the base page of a partial
+ * sub-page, by PSP (see psp.h). Each sub-page is invalidated exactly once, so
+ * greedy GC can trust the counts to choose victims; GC thread still checks
+ * the mappings before moving any data.
+ *
+ * A bank is reclaimed when its free (i.e. erased or dirty) blocks drop below
+ * GC_FREE_BLOCKS_LOW, or below GC_FREE_BLOCKS_HIGH when host is idle. The
+ * victim is the full block of the fewest valid sub-pages. GC never runs in
+ * the path of a host write; it is paced by a latency budget instead: every
+ * page written by host allows GC to spend GC_LATENCY_BUDGET_US of flash time,
+ * and moving a page costs GC_PAGE_MOVE_US scaled by the free blocks of its
+ * bank over GC_FREE_BLOCKS_LOW. So the further a bank falls behind, the more
+ * pages GC moves for every host write, until host writes have to wait for the
+ * last GC_RESERVED_BLOCKS erased blocks, which are reserved for GC and PMT so
+ * that GC can always make progress.
+ * */
+#define GC_FREE_BLOCKS_LOW	32
+#define GC_FREE_BLOCKS_HIGH	64
+#define GC_RESERVED_BLOCKS	1
+/* a moved page is read and programmed once */
+#define GC_PAGE_MOVE_US		1500
+#define GC_LATENCY_BUDGET_US	1500
+/* bounds the burst of GC after a long run of writes */
+#define GC_MAX_BUDGET_US	(8 * GC_PAGE_MOVE_US)
+
 void gc_init(void);
+/* Persist erase counts and pending summaries; the caller must make sure that
+ * all flash commands have been issued */
+void gc_flush(void);
 
-UINT32 gc_allocate_new_vpn(UINT32 const bank, BOOL8 const is_sys);
+/* Can a new page of *stream* be allocated in *bank* right now? */
+BOOL8  gc_can_allocate_new_vpn(UINT8 const bank, UINT8 const stream);
+/* Return an idle bank where a new page of *stream* can be allocated
+ * right now, or NUM_BANKS if there is no such bank */
+UINT8  gc_get_idle_bank(UINT8 const stream);
+/* Allocate a new page in a stream of a bank.
+ *
+ *	Input *sp_keys* is the keys of the sub-pages to be written to the page
+ *	(see block summary above), or NULL if the page is unknown to GC.
+ * */
+UINT32 gc_allocate_new_vpn(UINT32 const bank, UINT8 const stream,
+			   UINT32 const sp_keys[SUB_PAGES_PER_PAGE]);
 
 UINT32 gc_get_num_free_blocks(UINT8 const bank);
+UINT32 gc_get_erase_count(UINT8 const bank, UINT32 const vblk);
+
+/* Write the summaries of full blocks on idle banks */
+void gc_write_summaries(void);
+
+/* A sub-page in a virtual page is no longer referred to */
+void  gc_invalidate(UINT8 const bank, UINT32 const vpn);
+
+/* Find a block to reclaim or a block that needs static wear leveling. The
+ * block is not full any more and the caller is responsible to relocate its
+ * valid data and then free it by gc_free_block(). */
+BOOL8 gc_pick_victim(BOOL8 const host_idle, UINT8 *bank, UINT32 *vblk);
+BOOL8 gc_has_budget(UINT8 const bank, BOOL8 const host_idle);
+void  gc_use_budget(UINT8 const bank);
+
+BOOL8 gc_wl_pick_victim(UINT8 *bank, UINT32 *vblk);
+BOOL8 gc_wl_has_credit(void);
+void  gc_wl_use_credit(void);
+
+/* Free a block whose data are all dead */
+void gc_free_block(UINT8 const bank, UINT32 const vblk);
+
+/* Does the erased pool of the bank need more blocks? */
+BOOL8 gc_needs_erase(UINT8 const bank, BOOL8 const host_idle);
+/* Pick a dirty block to be erased, if the erased pool of the bank needs
+ * more blocks. The block is put into the pool by gc_erase_done() after it is
+ * erased. */
+BOOL8 gc_pick_block_to_erase(UINT8 const bank, BOOL8 const host_idle,
+			     UINT32 *vblk);
+void  gc_erase_done(UINT8 const bank, UINT32 const vblk);
 
 #endif /* __GC__H */
@@ -0,0 +1,401 @@
+#include "thread_handler_util.h"
+#include "gc_thread.h"
+#include "gc.h"
+#include "fla.h"
+#include "pmt.h"
+#include "gtd.h"
+#include "buffer.h"
+#include "signal.h"
+#include "dram.h"
+#include "mem_util.h"
+#include "sata_manager.h"
+#if OPTION_LAZY_MERGE
+#include "psp.h"
+#endif
+#if OPTION_ACL
+#include "acl.h"
+#endif
+
+static thread_t *singleton_thread = NULL;
+
+void gc_thread_wakeup(void)
+{
+	/* GC thread may not be started yet */
+	if (singleton_thread == NULL) return;
+
+	/* only wake up the thread that has nothing to do; a thread waiting
+	 * for flash or locks wakes up by itself */
+	if (singleton_thread->state == THREAD_SLEEPING &&
+	    singleton_thread->wakeup_signals == 0)
+		singleton_thread->state = THREAD_RUNNABLE;
+}
+
+/*
+ * Handler
+ * */
+
+begin_thread_variables
+	/* victim block */
+	UINT8		bank;
+	UINT32		vblk;
+	BOOL8		for_wl;
+	UINT8		summary_buf_id;
+	/* victim page */
+	UINT8		page;
+	UINT8		pmt_done;
+	UINT8		valid_sps;
+	UINT8		copy_buf_id;
+	vp_t		new_vp;
+	BOOL8		cmd_issued;
+end_thread_variables
+
+#define victim_vp(page)		((vp_t){ .bank = var(bank),		\
+					 .vpn = var(vblk) * PAGES_PER_VBLK \
+						+ (page) })
+#define is_user_key(key)	((key) != GC_NULL_KEY && !gc_key_is_pmt(key))
+
+/* the range of sectors of the valid sub-pages in victim page */
+#define valid_sect_offset()	(__builtin_ctz(var(valid_sps)) *	\
+				 SECTORS_PER_SUB_PAGE)
+/* victim pages are traced by the key of the first valid sub-page */
+#define valid_key()		page_key(__builtin_ctz(var(valid_sps)))
+#define valid_num_sectors()	((32 - __builtin_clz(var(valid_sps))) *	\
+				 SECTORS_PER_SUB_PAGE - valid_sect_offset())
+
+static UINT32 page_key(UINT8 const sp_i)
+{
+	return gc_summary_key(MANAGED_BUF(var(summary_buf_id)), var(page), sp_i);
+}
+
+/* Is a sub-page in victim page still in use? For user data, PMT must be
+ * loaded and the logical page must be locked */
+static BOOL8 is_valid(UINT32 const key, UINT8 const sp_i, vp_t const old_vp)
+{
+	if (gc_key_is_pmt(key)) {
+		vsp_t vsp = gtd_get_vsp(gc_key_pmt_idx(key));
+		return vsp.bank == old_vp.bank &&
+			vsp.vspn == old_vp.vpn * SUB_PAGES_PER_PAGE + sp_i;
+	}
+
+	vp_t vp;
+	pmt_get_vp(key, sp_i, &vp);
+	if (vp_equal(vp, old_vp)) return TRUE;
+#if OPTION_LAZY_MERGE
+	/* the missing sectors of a partial sub-page */
+	vp_t base_vp; UINT8 sp_mask;
+	if (psp_get(key, sp_i, &base_vp, &sp_mask) &&
+	    vp_equal(base_vp, old_vp))
+		return TRUE;
+#endif
+	return FALSE;
+}
+
+#if OPTION_ACL
+/* Unmap a valid sub-page of user data if its owner has been revoked, so that
+ * it is dropped instead of relocated */
+static BOOL8 drop_revoked(UINT32 const key, UINT8 const sp_i,
+			  vp_t const old_vp)
+{
+	if (!acl_is_revoked(pmt_get_uid(key, sp_i))) return FALSE;
+
+	/* the sub-page may be partial, with either part in victim page */
+	vp_t vp;
+	pmt_get_vp(key, sp_i, &vp);
+	if (!vp_equal(vp, old_vp)) gc_invalidate(vp.bank, vp.vpn);
+#if OPTION_LAZY_MERGE
+	vp_t base_vp; UINT8 sp_mask;
+	if (psp_get(key, sp_i, &base_vp, &sp_mask)) {
+		if (!vp_equal(base_vp, old_vp))
+			gc_invalidate(base_vp.bank, base_vp.vpn);
+		psp_remove(key, sp_i);
+	}
+#endif
+	pmt_update_vp(key, sp_i, (vp_t){ .bank = 0, .vpn = 0 });
+	pmt_update_uid(key, sp_i, DEFAULT_USER_ID);
+	return TRUE;
+}
+#endif
+
+static void update_mapping(UINT32 const key, UINT8 const sp_i,
+			   vp_t const old_vp, vp_t const new_vp)
+{
+	if (gc_key_is_pmt(key)) {
+		/* PMT sub-page may be flushed again since we checked, and then
+		 * the copy is never used */
+		if (!is_valid(key, sp_i, old_vp)) {
+			gc_invalidate(new_vp.bank, new_vp.vpn);
+			return;
+		}
+
+		vsp_t new_vsp = {
+			.bank = new_vp.bank,
+			.vspn = new_vp.vpn * SUB_PAGES_PER_PAGE + sp_i
+		};
+		gtd_set_vsp(gc_key_pmt_idx(key), new_vsp);
+		return;
+	}
+
+	vp_t vp;
+	pmt_get_vp(key, sp_i, &vp);
+	if (vp_equal(vp, old_vp)) pmt_update_vp(key, sp_i, new_vp);
+#if OPTION_LAZY_MERGE
+	vp_t base_vp; UINT8 sp_mask;
+	if (psp_get(key, sp_i, &base_vp, &sp_mask) &&
+	    vp_equal(base_vp, old_vp))
+		psp_set(key, sp_i, new_vp, sp_mask);
+#endif
+}
+
+/* Unfix PMT and unlock the logical pages of victim page */
+static void release_victim_page(thread_id_t const tid)
+{
+	for_each_subpage(sp_i) {
+		UINT32 key = page_key(sp_i);
+		if (!is_user_key(key)) continue;
+
+		if (mask_is_set(var(pmt_done), sp_i)) pmt_unfix(key);
+		page_unlock(tid, key);
+	}
+}
+
+/* Allocate a page of relocation stream for the valid sub-pages */
+static void allocate_new_page(UINT8 const bank)
+{
+	UINT32 keys[SUB_PAGES_PER_PAGE];
+	for_each_subpage(sp_i) {
+		keys[sp_i] = mask_is_set(var(valid_sps), sp_i) ?
+				page_key(sp_i) : GC_NULL_KEY;
+	}
+	var(new_vp).bank = bank;
+	var(new_vp).vpn	 = gc_allocate_new_vpn(bank, GC_RELOC_STREAM, keys);
+
+	if (var(for_wl) && gc_wl_has_credit())
+		gc_wl_use_credit();
+	else
+		gc_use_budget(bank);
+}
+
+/* Map the valid sub-pages to the new page and release victim page; pages
+ * can be unlocked as soon as flash cmd is issued */
+static void move_victim_page(thread_id_t const tid)
+{
+	vp_t old_vp = victim_vp(var(page));
+	for_each_subpage(sp_i) {
+		if (mask_is_set(var(valid_sps), sp_i))
+			update_mapping(page_key(sp_i), sp_i,
+				       old_vp, var(new_vp));
+	}
+	release_victim_page(tid);
+}
+
+/* Relocation is paced so that host I/O is not delayed by too much. A block
+ * of static wear leveling holds up reclamation, and its credits are earned by
+ * host writes that may be waiting for free blocks, so it is finished on the
+ * budget of GC once the bank runs short of free blocks. */
+static BOOL8 can_move_page(void)
+{
+	if (var(for_wl)) {
+		if (gc_wl_has_credit()) return TRUE;
+		if (gc_get_num_free_blocks(var(bank)) >= GC_FREE_BLOCKS_LOW)
+			return FALSE;
+	}
+	return gc_has_budget(var(bank), sata_manager_are_all_tasks_finished());
+}
+
+begin_thread_handler
+/* Pick a victim block */
+phase(PICK_PHASE) {
+	var(for_wl) = FALSE;
+	if (!gc_pick_victim(sata_manager_are_all_tasks_finished(),
+			    &var(bank), &var(vblk))) {
+		if (!gc_wl_pick_victim(&var(bank), &var(vblk))) sleep(0);
+		var(for_wl) = TRUE;
+	}
+
+	var(cmd_issued) = FALSE;
+}
+/* Read the summary of victim block */
+phase(SUMMARY_PHASE) {
+	UINT8 bank = var(bank);
+	if (!var(cmd_issued)) {
+		if (!fla_is_bank_idle(bank)) sleep(SIG_BANK(bank));
+
+		var(summary_buf_id) = buffer_allocate();
+		flash_owner(FLA_SRC_META, NULL_LPN);
+		fla_read_page(victim_vp(GC_SUMMARY_PAGE), 0, GC_SUMMARY_SECTORS,
+			      MANAGED_BUF(var(summary_buf_id)));
+		var(cmd_issued) = TRUE;
+		sleep(SIG_BANK(bank));
+	}
+	if (!fla_is_bank_complete(bank)) sleep(SIG_BANK(bank));
+
+	var(page) = 0;
+}
+/* Lock the logical pages in victim page */
+phase(LOCK_PHASE) {
+	var(pmt_done) = 0;
+
+	/* skip pages that keep nothing */
+	while (var(page) < GC_DATA_PAGES_PER_VBLK) {
+		UINT8 sp_i = 0;
+		while (sp_i < SUB_PAGES_PER_PAGE &&
+		       page_key(sp_i) == GC_NULL_KEY) sp_i++;
+		if (sp_i < SUB_PAGES_PER_PAGE) break;
+		var(page)++;
+	}
+	if (var(page) == GC_DATA_PAGES_PER_VBLK) {
+		buffer_free(var(summary_buf_id));
+		/* victim block is erased later by erase thread */
+		gc_free_block(var(bank), var(vblk));
+		goto_phase(PICK_PHASE);
+	}
+
+	/* at most one page is moved in a round of scheduling, when the pace
+	 * allows */
+	if (!can_move_page()) sleep(0);
+
+	/* never hold some locks while waiting for others */
+	BOOL8 all_locked = TRUE;
+	for_each_subpage(sp_i) {
+		UINT32 key = page_key(sp_i);
+		if (!is_user_key(key)) continue;
+
+		if (lock_page(key, PAGE_LOCK_WRITE) != PAGE_LOCK_WRITE)
+			all_locked = FALSE;
+	}
+	if (!all_locked) {
+		release_victim_page(__tid);
+		sleep(SIG_LOCK_RELEASED);
+	}
+}
+/* Load PMT and find out the valid sub-pages */
+phase(PMT_LOAD_PHASE) {
+	BOOL8 loading = FALSE;
+	UINT32 last_load_lpn = NULL_LPN;
+	for_each_subpage(sp_i) {
+		if (mask_is_set(var(pmt_done), sp_i)) continue;
+
+		UINT32 key = page_key(sp_i);
+		if (!is_user_key(key)) {
+			mask_set(var(pmt_done), sp_i);
+			continue;
+		}
+
+		/* shortcut */
+		if (key == last_load_lpn) continue;
+
+		if (!pmt_is_loaded(key)) {
+			pmt_load(key);
+			last_load_lpn = key;
+			loading = TRUE;
+			continue;
+		}
+
+		pmt_fix(key);
+		mask_set(var(pmt_done), sp_i);
+	}
+	if (loading) sleep(SIG_PMT_LOADED);
+
+	vp_t old_vp = victim_vp(var(page));
+	var(valid_sps) = 0;
+	for_each_subpage(sp_i) {
+		UINT32 key = page_key(sp_i);
+		if (key == GC_NULL_KEY || !is_valid(key, sp_i, old_vp)) continue;
+#if OPTION_ACL
+		if (is_user_key(key) && drop_revoked(key, sp_i, old_vp))
+			continue;
+#endif
+		mask_set(var(valid_sps), sp_i);
+	}
+	if (var(valid_sps) == 0) {
+		release_victim_page(__tid);
+		var(page)++;
+		goto_phase(LOCK_PHASE);
+	}
+
+	var(cmd_issued) = FALSE;
+}
+/* Copy victim page inside its bank, if possible */
+phase(COPYBACK_PHASE) {
+	UINT8 bank = var(bank);
+	if (!var(cmd_issued)) {
+		/* go through DRAM to another bank if there is no erased block
+		 * in victim bank */
+		if (!gc_can_allocate_new_vpn(bank, GC_RELOC_STREAM))
+			goto_phase(FLASH_READ_PHASE);
+		if (!fla_is_bank_idle(bank)) sleep(SIG_BANK(bank));
+
+		allocate_new_page(bank);
+		flash_owner(FLA_SRC_GC, valid_key());
+		fla_copyback_page(victim_vp(var(page)), var(new_vp));
+		move_victim_page(__tid);
+
+		var(cmd_issued) = TRUE;
+		sleep(SIG_BANK(bank));
+	}
+	if (!fla_is_bank_complete(bank)) sleep(SIG_BANK(bank));
+
+	var(page)++;
+	goto_phase(LOCK_PHASE);
+}
+/* Read the valid sub-pages */
+phase(FLASH_READ_PHASE) {
+	UINT8 bank = var(bank);
+	if (!var(cmd_issued)) {
+		if (!fla_is_bank_idle(bank)) sleep(SIG_BANK(bank));
+
+		var(copy_buf_id) = buffer_allocate();
+		flash_owner(FLA_SRC_GC, valid_key());
+		fla_read_page(victim_vp(var(page)),
+			      valid_sect_offset(), valid_num_sectors(),
+			      MANAGED_BUF(var(copy_buf_id)));
+		var(cmd_issued) = TRUE;
+		sleep(SIG_BANK(bank));
+	}
+	if (!fla_is_bank_complete(bank)) sleep(SIG_BANK(bank));
+
+	var(cmd_issued) = FALSE;
+}
+/* Write the valid sub-pages to relocation stream */
+phase(FLASH_WRITE_PHASE) {
+	if (!var(cmd_issued)) {
+		UINT8 bank = gc_get_idle_bank(GC_RELOC_STREAM);
+		if (bank >= NUM_BANKS) sleep(SIG_ALL_BANKS);
+
+		allocate_new_page(bank);
+		flash_owner(FLA_SRC_GC, valid_key());
+		fla_write_page(var(new_vp),
+			       valid_sect_offset(), valid_num_sectors(),
+			       MANAGED_BUF(var(copy_buf_id)));
+		move_victim_page(__tid);
+
+		var(cmd_issued) = TRUE;
+		sleep(SIG_BANK(bank));
+	}
+	if (!fla_is_bank_complete(var(new_vp).bank))
+		sleep(SIG_BANK(var(new_vp).bank));
+
+	buffer_free(var(copy_buf_id));
+	var(page)++;
+	goto_phase(LOCK_PHASE);
+}
+end_thread_handler
+
+/*
+ * Initialiazation
+ * */
+
+static thread_handler_id_t registered_handler_id = NULL_THREAD_HANDLER_ID;
+
+void gc_thread_init(thread_t *t)
+{
+	/* GC thread is a singleton; thus init can be only called once */
+	ASSERT(registered_handler_id == NULL_THREAD_HANDLER_ID);
+	registered_handler_id = thread_handler_register(get_thread_handler());
+
+	singleton_thread = t;
+
+	t->handler_id = registered_handler_id;
+
+	init_thread_variables(thread_id(t));
+}
@@ -0,0 +1,35 @@
+#ifndef __GC_THREAD_H
+#define __GC_THREAD_H
+
+#include "thread.h"
+
+/*
+ * GC thread -- relocate the valid data of a block in background so that the
+ * block can be erased and reused.
+ *
+ * The thread picks a victim block to reclaim, or one for static wear leveling
+ * when no bank is short of free blocks (see gc.h), reads its summary and then
+ * relocates it page by page: the logical pages in a victim page are
+ * write-locked and their PMT entries are loaded, so that the sub-pages that
+ * are still mapped to the victim page can be told apart from the dead ones;
+ * the valid sub-pages are then moved to the relocation stream and their
+ * mappings are updated. Locks are never held while waiting for other locks,
+ * so the thread cannot deadlock with writers.
+ *
+ * A victim page is moved by copyback inside its bank when the bank has an
+ * erased block, which costs neither a DRAM buffer nor a bus transfer;
+ * otherwise it is read into DRAM and written to another bank.
+ *
+ * The thread is preemptible: it yields at every flash command and moves at
+ * most one page in a round of scheduling. Each page moved for wear leveling
+ * costs a credit of wear leveling, and each page moved to reclaim a block
+ * costs the latency budget of GC; the thread sleeps when it runs out of them,
+ * unless host is idle or a bank is about to run out of blocks.
+ * */
+
+void gc_thread_init(thread_t *t);
+
+/* Wake up GC thread when there may be more work for it */
+void gc_thread_wakeup(void);
+
+#endif
@@ -1,6 +1,7 @@
 #include "page_lock.h"
 #include "dram.h"
 #include "signal.h"
+#include "counters.h"
 
 #define MAX_NUM_LOCKS_PER_OWNER		SUB_PAGES_PER_PAGE
 #define MAX_NUM_LOCKS			(MAX_NUM_LOCKS_PER_OWNER * \
@@ -106,6 +107,7 @@ page_lock_type_t page_lock(page_lock_owner_id_t const owner_id,
 			get_highest_compatible_lock(highest_lock_except_owner);
 	page_lock_type_t final_lock = MIN(highest_compatible_lock,
 					MAX(new_lock, old_lock));
+	if (final_lock < new_lock) counter_inc(COUNTER_LOCK_WAITS);
 
 	/* lock granted and need to update DRAM */
 	if (final_lock != PAGE_LOCK_NULL && final_lock != old_lock) {
@@ -45,6 +45,9 @@ typedef enum {
 } page_lock_type_t;
 
 #define MAX_NUM_PAGE_LOCK_OWNERS	MAX_NUM_THREADS
+#if MAX_NUM_PAGE_LOCK_OWNERS > 16
+	#error owners info of a page lock has room for 16 owners only
+#endif
 typedef UINT8 page_lock_owner_id_t;
 
 void page_lock_init();
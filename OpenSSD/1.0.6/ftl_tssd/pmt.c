@@ -1,6 +1,7 @@
 #include "pmt.h"
 #include "pmt_cache.h"
 #include "pmt_thread.h"
+#include "counters.h"
 
 /* ========================================================================= *
  * Public API
@@ -33,6 +34,7 @@ void pmt_get_vp(UINT32 const lpn, UINT8 const sp_offset, vp_t *vp)
 	UINT32	pmt_idx  = pmt_get_index(lpn);
 	UINT32	pmt_buf = pmt_cache_get(pmt_idx);
 	ASSERT(pmt_buf != NULL);
+	counter_inc(COUNTER_PMT_LOOKUPS);
 
 	UINT32	pmt_offset = pmt_get_offset(lpn) * sizeof(pmt_entry_t)
 				+ (UINT32)(&((pmt_entry_t*)0)->vps[sp_offset]);
@@ -51,6 +53,32 @@ void pmt_update_vp(UINT32 const lpn, UINT8 const sp_offset, vp_t const vp)
 	write_dram_32(pmt_buf + pmt_offset, vp.as_uint);
 }
 
+#if OPTION_ACL
+void pmt_update_uid(UINT32 const lpn, UINT8 const sp_offset,
+		    user_id_t const uid)
+{
+	UINT32	pmt_idx  = pmt_get_index(lpn);
+	UINT32	pmt_buf = pmt_cache_get(pmt_idx);
+	ASSERT(pmt_buf != NULL);
+	pmt_cache_set_dirty(pmt_idx, TRUE);
+
+	UINT32	pmt_offset = pmt_get_offset(lpn) * sizeof(pmt_entry_t)
+				+ (UINT32)(&((pmt_entry_t*)0)->uids[sp_offset]);
+	write_dram_16(pmt_buf + pmt_offset, uid);
+}
+
+user_id_t pmt_get_uid(UINT32 const lpn, UINT8 const sp_offset)
+{
+	UINT32	pmt_idx  = pmt_get_index(lpn);
+	UINT32	pmt_buf = pmt_cache_get(pmt_idx);
+	ASSERT(pmt_buf != NULL);
+
+	UINT32	pmt_offset = pmt_get_offset(lpn) * sizeof(pmt_entry_t)
+				+ (UINT32)(&((pmt_entry_t*)0)->uids[sp_offset]);
+	return (user_id_t) read_dram_16(pmt_buf + pmt_offset);
+}
+#endif
+
 void	pmt_fix(UINT32 const lpn)
 {
 	UINT32	pmt_idx  = pmt_get_index(lpn);
@@ -7,8 +7,10 @@
  *
  * PMT maintains metadata for every logical page. The metadata includes:
  *	1) logical sub-page (LSP) --> virtual sub-page (VSP);
- *	2) ownership information for each sectors in the page when
- *	ACL (Access Control Layer) is enabled.
+ *	2) owner of each sub-page in the page when ACL (Access Control
+ *	Layer) is enabled. Keeping owners of logical sub-pages in PMT, rather
+ *	than a table of owners of all physical pages in DRAM, costs no more
+ *	DRAM than PMT cache and needs no update when a page is relocated.
  * */
 
 /* ===========================================================================
@@ -17,6 +19,9 @@
 
 typedef struct {
 	vp_t		vps[SUB_PAGES_PER_PAGE];
+#if OPTION_ACL
+	user_id_t	uids[SUB_PAGES_PER_PAGE];
+#endif
 } pmt_entry_t;
 
 #define PMT_BYTES_PER_ENTRY		sizeof(pmt_entry_t)
@@ -40,6 +45,12 @@ void	pmt_load(UINT32 const lpn);
 void 	pmt_update_vp(UINT32 const lpn, UINT8 const sp_offset, vp_t const vp);
 void 	pmt_get_vp(UINT32 const lpn,  UINT8 const sp_offset, vp_t* vp);
 
+#if OPTION_ACL
+void	pmt_update_uid(UINT32 const lpn, UINT8 const sp_offset,
+		       user_id_t const uid);
+user_id_t pmt_get_uid(UINT32 const lpn, UINT8 const sp_offset);
+#endif
+
 /* A fixed lpn will not be unloaded.
  *	Fix a lpn only after it is loaded. */
 void	pmt_fix(UINT32 const lpn);
@@ -8,14 +8,10 @@
 #include "scheduler.h"
 #include "gtd.h"
 #include "dram.h"
+#include "counters.h"
 
 #define NULL_PMT_IDX		0xFFFFFFFF
 
-#if OPTION_PERF_TUNING
-UINT32 g_pmt_cache_flush_count = 0;
-UINT32 g_pmt_cache_load_count = 0;
-#endif
-
 static thread_t *singleton_thread = NULL;
 
 /*
@@ -129,7 +125,7 @@ phase(ONE_PHASE) {
 			if (need_flush == FALSE) goto pmt_load;
 
 			/* try to find a idle bank to flush */
-			UINT8 flush_bank = fla_get_idle_bank();
+			UINT8 flush_bank = gc_get_idle_bank(GC_SYS_STREAM);
 			if (flush_bank >= NUM_BANKS) {
 				signals_set(interesting_signals,
 						SIG_ALL_BANKS);
@@ -145,15 +141,18 @@ phase(ONE_PHASE) {
 			pmt_cache_flush(flush_buf, flush_pmt_idxes);
 
 			/* issue flash write cmd */
-			UINT32 flush_vpn = gc_allocate_new_vpn(flush_bank, TRUE);
+			UINT32	flush_keys[SUB_PAGES_PER_PAGE];
+			for_each_subpage(sp_i)
+				flush_keys[sp_i] = gc_pmt_key(flush_pmt_idxes[sp_i]);
+			UINT32 flush_vpn = gc_allocate_new_vpn(flush_bank, GC_SYS_STREAM,
+							       flush_keys);
 			vp_t flush_vp = {
 				.bank = flush_bank,
 				.vpn = flush_vpn
 			};
+			flash_owner(FLA_SRC_PMT, flush_pmt_idxes[0]);
 			fla_write_page(flush_vp, 0, SECTORS_PER_PAGE, flush_buf);
-#if OPTION_PERF_TUNING
-			g_pmt_cache_flush_count++;
-#endif
+			counter_inc(COUNTER_PMT_FLUSHES);
 
 			/* update GTD */
 			vsp_t flush_vsp = {
@@ -162,6 +161,10 @@ phase(ONE_PHASE) {
 			};
 			for_each_subpage(sp_i) {
 				UINT32 pmt_idx = flush_pmt_idxes[sp_i];
+				vsp_t old_vsp = gtd_get_vsp(pmt_idx);
+				if (old_vsp.vspn != 0)
+					gc_invalidate(old_vsp.bank, old_vsp.vspn
+							/ SUB_PAGES_PER_PAGE);
 				gtd_set_vsp(pmt_idx, flush_vsp);
 				flush_vsp.vspn++;
 			}
@@ -195,11 +198,10 @@ pmt_load:;
 		vp_t	load_vp = {.bank = load_bank, .vpn = load_vpn};
 		UINT8	sp_offset = load_vsp.vspn % SUB_PAGES_PER_PAGE;
 		UINT8	sect_offset = sp_offset * SECTORS_PER_SUB_PAGE;
+		flash_owner(FLA_SRC_PMT, var(next_pmt_idx));
 		fla_read_page(load_vp, sect_offset, SECTORS_PER_SUB_PAGE,
 				load_buf);
-#if OPTION_PERF_TUNING
-		g_pmt_cache_load_count++;
-#endif
+		counter_inc(COUNTER_PMT_MISSES);
 
 		var(loading_pmt_idxes)[load_bank] = var(next_pmt_idx);
 		var(loading_pmt_vsps)[load_bank] = load_vsp;
@@ -0,0 +1,89 @@
+#include "psp.h"
+#if OPTION_LAZY_MERGE
+#include "mem_util.h"
+
+#define PSP_TABLE_SIZE		64
+#define NULL_PSP_KEY		0xFFFFFFFF
+
+#define psp_key(lpn, sp_i)	((lpn) * SUB_PAGES_PER_PAGE + (sp_i))
+#define psp_key2lpn(key)	((key) / SUB_PAGES_PER_PAGE)
+
+static UINT32	psp_keys[PSP_TABLE_SIZE];
+static vp_t	psp_base_vps[PSP_TABLE_SIZE];
+static UINT8	psp_masks[PSP_TABLE_SIZE];
+static UINT32	psp_num_entries;
+
+static UINT32 find_index_of(UINT32 const key)
+{
+	return mem_search_equ_sram(psp_keys, sizeof(UINT32),
+				   PSP_TABLE_SIZE, key);
+}
+
+static UINT8 count_entries_of_lpn(UINT32 const lpn)
+{
+	UINT8 count = 0;
+	for (UINT32 i = 0; i < PSP_TABLE_SIZE; i++)
+		if (psp_keys[i] != NULL_PSP_KEY &&
+		    psp_key2lpn(psp_keys[i]) == lpn) count++;
+	return count;
+}
+
+void psp_init()
+{
+	BUG_ON("PSP table size must be a multiple of 4",
+		PSP_TABLE_SIZE % 4 != 0);
+	BUG_ON("a sub-page mask is 8-bit", SECTORS_PER_SUB_PAGE != 8);
+
+	mem_set_sram(psp_keys, NULL_PSP_KEY, PSP_TABLE_SIZE * sizeof(UINT32));
+	mem_set_sram(psp_base_vps, 0, PSP_TABLE_SIZE * sizeof(vp_t));
+	for (UINT32 i = 0; i < PSP_TABLE_SIZE; i++) psp_masks[i] = 0;
+	psp_num_entries = 0;
+}
+
+BOOL8 psp_get(UINT32 const lpn, UINT8 const sp_i,
+	      vp_t *base_vp, UINT8 *mask)
+{
+	if (psp_num_entries == 0) return FALSE;
+
+	UINT32 idx = find_index_of(psp_key(lpn, sp_i));
+	if (idx >= PSP_TABLE_SIZE) return FALSE;
+
+	*base_vp = psp_base_vps[idx];
+	*mask	 = psp_masks[idx];
+	return TRUE;
+}
+
+BOOL8 psp_set(UINT32 const lpn, UINT8 const sp_i,
+	      vp_t const base_vp, UINT8 const mask)
+{
+	ASSERT(mask != 0 && mask != 0xFF);
+
+	UINT32 idx = find_index_of(psp_key(lpn, sp_i));
+	if (idx >= PSP_TABLE_SIZE) {
+		if (psp_num_entries == PSP_TABLE_SIZE) return FALSE;
+		if (count_entries_of_lpn(lpn) >= PSP_MAX_ENTRIES_PER_LPN)
+			return FALSE;
+
+		idx = find_index_of(NULL_PSP_KEY);
+		ASSERT(idx < PSP_TABLE_SIZE);
+		psp_keys[idx] = psp_key(lpn, sp_i);
+		psp_num_entries++;
+	}
+	psp_base_vps[idx] = base_vp;
+	psp_masks[idx]	  = mask;
+	return TRUE;
+}
+
+void psp_remove(UINT32 const lpn, UINT8 const sp_i)
+{
+	if (psp_num_entries == 0) return;
+
+	UINT32 idx = find_index_of(psp_key(lpn, sp_i));
+	if (idx >= PSP_TABLE_SIZE) return;
+
+	psp_keys[idx]	  = NULL_PSP_KEY;
+	psp_base_vps[idx].as_uint = 0;
+	psp_masks[idx]	  = 0;
+	psp_num_entries--;
+}
+#endif
@@ -0,0 +1,35 @@
+#ifndef __PSP_H
+#define __PSP_H
+
+#include "jasmine.h"
+#if OPTION_LAZY_MERGE
+
+/* *
+ * PSP = partial sub-page table
+ *
+ * A logical sub-page whose sectors are split between two virtual pages: the
+ * sectors in *mask* are stored in the virtual page that is mapped by PMT, and
+ * the rest of the sectors are stored in *base_vp*. Readers merge the two
+ * parts; writers update the entry when the sub-page is written again and
+ * remove it once the sub-page is completely overwritten.
+ *
+ * The table is small and kept in SRAM; when it is full (or when a logical
+ * page already has PSP_MAX_ENTRIES_PER_LPN entries), writers fall back to
+ * read-modify-write.
+ * */
+
+/* Each entry adds a segment to read for a logical page, which is bounded by
+ * the stack of a thread */
+#define PSP_MAX_ENTRIES_PER_LPN		(SUB_PAGES_PER_PAGE / 2)
+
+void psp_init();
+
+BOOL8 psp_get(UINT32 const lpn, UINT8 const sp_i,
+	      vp_t *base_vp, UINT8 *mask);
+/* Return FALSE if a new entry is needed but there is no room for it */
+BOOL8 psp_set(UINT32 const lpn, UINT8 const sp_i,
+	      vp_t const base_vp, UINT8 const mask);
+void  psp_remove(UINT32 const lpn, UINT8 const sp_i);
+
+#endif
+#endif
@@ -103,3 +103,13 @@ BOOL8 sata_manager_are_all_tasks_finished()
 	return (next_finish_rid == next_accept_rid)
 		&& (next_finish_wid == next_accept_wid);
 }
+
+UINT32 sata_manager_num_finished_read_tasks()
+{
+	return next_finish_rid;
+}
+
+UINT32 sata_manager_num_finished_write_tasks()
+{
+	return next_finish_wid;
+}
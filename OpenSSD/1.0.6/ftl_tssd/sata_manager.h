@@ -14,4 +14,9 @@ void sata_manager_finish_write_task(UINT32 const wid);
 
 BOOL8 sata_manager_are_all_tasks_finished();
 
+/* Tasks finish in the order they are accepted, so a SATA command is done when
+ * the number of finished tasks reaches its last task */
+UINT32 sata_manager_num_finished_read_tasks();
+UINT32 sata_manager_num_finished_write_tasks();
+
 #endif
@@ -42,6 +42,9 @@ void dump_all_threads()
 
 void schedule()
 {
+	/* a signal raised by a thread is missed by the threads that have had
+	 * their turns in the round, so it is kept for one more round */
+	signals_t last_signals = g_scheduler_signals;
 	g_scheduler_signals = 0;
 	/* fla module check the state of banks and notify any state
 	 * changes by signals (g_scheduler_signals) */
@@ -58,7 +61,8 @@ void schedule()
 
 		/* wake up sleep thread */
 		if (thread->state == THREAD_SLEEPING &&
-			(thread->wakeup_signals & g_scheduler_signals) != 0)
+			(thread->wakeup_signals &
+			 (g_scheduler_signals | last_signals)) != 0)
 			thread->state = THREAD_RUNNABLE;
 
 		if (thread->state != THREAD_RUNNABLE) {
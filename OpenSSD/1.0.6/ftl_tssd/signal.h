@@ -10,6 +10,9 @@ typedef UINT32 signals_t;
 
 #define SIG_BANK(i)		(1 << (i))
 #define SIG_ALL_BANKS		0x0000FFFF
+#if NUM_BANKS > 16
+	#error signals have room for 16 banks only
+#endif
 #define SIG_BANKS(banks)	(SIG_ALL_BANKS & (banks))
 #define SIG_PMT_LOADED		(1 << 16)
 #define SIG_LOCK_RELEASED	(1 << 17)
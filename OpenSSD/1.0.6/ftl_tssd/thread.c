@@ -17,6 +17,11 @@ BOOL8 thread_can_allocate()
 	return slab_thread_num_free > 0;
 }
 
+UINT8 thread_num_allocated()
+{
+	return MAX_NUM_THREADS - slab_thread_num_free;
+}
+
 thread_t* thread_allocate()
 {
 	thread_t* t = slab_allocate_thread();
@@ -47,7 +52,7 @@ void thread_set_next(thread_t *t, thread_t *n)
 	t->next_id = thread2id(n);
 }
 
-#define MAX_NUM_THREAD_HANDLERS	4
+#define MAX_NUM_THREAD_HANDLERS	8
 static thread_handler_t handlers[MAX_NUM_THREAD_HANDLERS] = {NULL};
 static UINT8 num_handlers = 0;
 
@@ -34,6 +34,7 @@ typedef struct {
 typedef void (*thread_handler_t)(thread_t *__t);
 
 BOOL8		thread_can_allocate();
+UINT8		thread_num_allocated();
 thread_t*	thread_allocate();
 void		thread_deallocate(thread_t *t);
 
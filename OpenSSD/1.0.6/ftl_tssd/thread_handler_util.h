@@ -16,6 +16,10 @@
 
 #include "thread.h"
 #include "page_lock.h"
+#include "fla.h"
+#if OPTION_PROFILING
+#include "profiler.h"
+#endif
 
 /*
  * Thread variables
@@ -38,6 +42,7 @@ UINT8 * const __thread_stack;
 		static void __thread_handler(thread_t *__t) {	\
 			thread_id_t __tid = thread_id(__t);	\
 			restore_thread_variables(__tid);	\
+			profile_resume();			\
 			jump_to_last_position(__t);
 
 			/* uart_print("last position = %u",	\ */
@@ -59,7 +64,8 @@ UINT8 * const __thread_stack;
  * */
 #define phase(name)						\
 		save_position(__t, name);			\
-	__##name:;
+	__##name:;						\
+		profile_phase(name);
 
 /* uart_print("enter phase at line %u", __LINE__);	\ */
 
@@ -83,14 +89,41 @@ UINT8 * const __thread_stack;
 
 #define end()		do {					\
 		__t->state = THREAD_STOPPED;			\
+		profile_switch(THREAD_STOPPED);			\
 		return;						\
 	} while(0)
 
 #define context_switch(new_state)	do {			\
 		__t->state = (new_state);			\
+		profile_switch(new_state);			\
 		save_thread_variables(__tid);			\
 		return;						\
 	} while(0)
+
+/*
+ * Profiling
+ *
+ * With profiling compiled in, the time threads spend in every phase is
+ * accounted by the profiler (see profiler.h). Phases are numbered in the
+ * order they appear in the handler.
+ * */
+#if OPTION_PROFILING
+#define profile_resume()					\
+		enum { __first_phase = __COUNTER__ + 1 };	\
+		profiler_thread_resume(__tid, __t->handler_id,	\
+				       __t->wakeup_signals,	\
+				       var(__handler_last_position) != NULL)
+#define profile_phase(name)					\
+		profiler_thread_phase(__tid, __t->handler_id,	\
+				      __COUNTER__ - __first_phase,\
+				      #name, __FILE__)
+#define profile_switch(new_state)				\
+		profiler_thread_switch(__tid, __t->handler_id, (new_state))
+#else
+#define profile_resume()
+#define profile_phase(name)
+#define profile_switch(new_state)
+#endif
 /*
  * Save and restore thread information
  * */
@@ -108,6 +141,12 @@ UINT8 * const __thread_stack;
 void restore_thread_variables(thread_id_t const tid);
 void save_thread_variables(thread_id_t const tid);
 
+/*
+ * Owner of the next flash command (see fla.h)
+ * */
+#define flash_owner(source, lpn)	\
+		fla_set_owner(__tid, (source), (lpn))
+
 /*
  * Page lock
  * */
@@ -3,6 +3,7 @@
 #include "gc.h"
 #include "mem_util.h"
 #include "fla.h"
+#include "counters.h"
 #include "buffer.h"
 #include "fla.h"
 
@@ -27,18 +28,63 @@ static UINT8		buf_managed_ids[NUM_WRITE_BUFFERS]; /* buf id -->
 							       managed buf id */
 static sectors_mask_t 	buf_masks[NUM_WRITE_BUFFERS]; /* 1 - occupied; 0 - available */
 static UINT8		buf_sizes[NUM_WRITE_BUFFERS];
+/* Bitmap of free sub-page slots in each buffer; 1 - free; 0 - occupied */
+typedef UINT8		sp_bitmap_t;
+#define ALL_SUB_PAGES	((sp_bitmap_t)((1 << SUB_PAGES_PER_PAGE) - 1))
+static sp_bitmap_t	buf_free_sps[NUM_WRITE_BUFFERS];
 #if OPTION_ACL
-static user_id_t	buf_uids[NUM_WRITE_BUFFERS];
+/* A page is programmed into the stream of one uid group (see gc.h), so
+ * buffers are preferably shared by the users of the group they were
+ * allocated for */
+static UINT8		buf_uid_groups[NUM_WRITE_BUFFERS];
 #endif
 
 #define next_buf_id(buf_id)		(((buf_id) + 1) % NUM_WRITE_BUFFERS)
+#define count_sub_pages(sp_bitmap)	__builtin_popcount(sp_bitmap)
 
 #define WRITE_BUF(buf_id)		MANAGED_BUF(buf_managed_ids[buf_id])
 
-void allocate_buf(buf_id_t const buf_id)
+/* Sequential stream coalescing
+ *
+ * A partial write that continues right where the last push ended is
+ * considered sequential. The LPN of such a write is given a dedicated
+ * staging buffer, which is never packed with other LPNs and which is not
+ * chosen as victim until it is full (and thus can be programmed as a full
+ * page without read-modify-write) or has not been appended to for
+ * STAGE_TIMEOUT pushes. */
+#define MAX_NUM_STAGING_BUFFERS		(NUM_WRITE_BUFFERS / 4)
+#define STAGE_TIMEOUT			(4 * NUM_WRITE_BUFFERS)
+static UINT32		buf_stage_lpns[NUM_WRITE_BUFFERS]; /* NULL_LPN if not
+								staging */
+static UINT32		buf_stage_times[NUM_WRITE_BUFFERS];
+static UINT32		num_staging_buffers;
+/* Readiness is kept up to date so that it is cheap to poll on every push: the
+ * number of full staging buffers is counted, and a lower bound of their stage
+ * times tells when one of them may have timed out. */
+static UINT32		num_full_staging_buffers;
+static UINT32		oldest_stage_time;
+static UINT32		push_clock;
+static UINT32		last_push_lpn;
+static UINT8		last_push_end;
+#if OPTION_ACL
+static user_id_t	last_push_uid;
+#endif
+
+#define is_staging(buf_id)		(buf_stage_lpns[buf_id] != NULL_LPN)
+#define is_stage_ready(buf_id)		(buf_sizes[buf_id] == SECTORS_PER_PAGE ||\
+			push_clock - buf_stage_times[buf_id] > STAGE_TIMEOUT)
+
+void allocate_buf(buf_id_t const buf_id
+#if OPTION_ACL
+		  ,user_id_t const uid
+#endif
+		  )
 {
 	ASSERT(buf_managed_ids[buf_id] == NULL_BUF_ID);
 	buf_managed_ids[buf_id] = buffer_allocate();
+#if OPTION_ACL
+	buf_uid_groups[buf_id]	= GC_UID_GROUP(uid);
+#endif
 	num_clean_buffers--;
 }
 
@@ -49,20 +95,29 @@ void free_buf(buf_id_t const buf_id)
 		buffer_free(buf_managed_id);
 		buf_managed_ids[buf_id] = NULL_BUF_ID;
 	}
-#if OPTION_ACL
-	buf_uids[buf_id] = NULL_USER_ID;
-#endif
+	if (is_staging(buf_id)) {
+		buf_stage_lpns[buf_id] = NULL_LPN;
+		num_staging_buffers--;
+	}
 	num_clean_buffers++;
 }
 
 /* For each logical page which has some part in write buffer, three fields are
- * maintained: lpn, valid sector mask and buffer id. */
+ * maintained: lpn, valid sector mask and buffer id.
+ *
+ * In ACL mode, the owner of each logical page is maintained too. A logical
+ * page written by several users has one entry for each of them. Entries of
+ * different users may share a buffer, since the owner of a sub-page is
+ * recorded per sub-page when the buffer is flushed (see write_buffer_flush). */
 #define MAX_NUM_LPNS			(SUB_PAGES_PER_PAGE * NUM_WRITE_BUFFERS)
 #define NULL_LPN			0xFFFFFFFF
 static UINT32		num_lpns;
 static UINT32		lpns[MAX_NUM_LPNS];
 static sectors_mask_t 	lp_masks[MAX_NUM_LPNS]; /* 1 - in buff; 0 - not in buff  */
 static buf_id_t		lp_buf_ids[MAX_NUM_LPNS];
+#if OPTION_ACL
+static user_id_t	lp_uids[MAX_NUM_LPNS];
+#endif
 
 /* ========================================================================= *
  * Private Functions
@@ -79,14 +134,35 @@ static void buf_mask_align_to_sp(sectors_mask_t *mask)
 	}
 }
 
+static sp_bitmap_t sp_bitmap_of(sectors_mask_t const mask)
+{
+	sp_bitmap_t sp_bitmap = 0;
+	for_each_subpage(sp_i) {
+		if ((UINT8)(mask >> (SECTORS_PER_SUB_PAGE * sp_i)))
+			sp_bitmap |= (1 << sp_i);
+	}
+	return sp_bitmap;
+}
+
+static void count_full_staging_buffer(UINT32 const buf_id,
+				      UINT8 const old_size)
+{
+	if (!is_staging(buf_id)) return;
+	if (old_size == SECTORS_PER_PAGE) num_full_staging_buffers--;
+	if (buf_sizes[buf_id] == SECTORS_PER_PAGE) num_full_staging_buffers++;
+}
+
 static void buf_mask_add(UINT32 const buf_id,
 			 sectors_mask_t const lp_mask)
 {
 	sectors_mask_t lp_mask_aligned = lp_mask;
 	buf_mask_align_to_sp(&lp_mask_aligned);
 
+	UINT8 old_size = buf_sizes[buf_id];
 	buf_masks[buf_id] |= lp_mask_aligned;
 	buf_sizes[buf_id] = count_sectors(buf_masks[buf_id]);
+	buf_free_sps[buf_id] &= ~sp_bitmap_of(lp_mask_aligned);
+	count_full_staging_buffer(buf_id, old_size);
 }
 
 static void buf_mask_remove(UINT32 const buf_id,
@@ -95,8 +171,11 @@ static void buf_mask_remove(UINT32 const buf_id,
 	sectors_mask_t lp_mask_aligned = lp_mask;
 	buf_mask_align_to_sp(&lp_mask_aligned);
 
+	UINT8 old_size = buf_sizes[buf_id];
 	buf_masks[buf_id] &= ~lp_mask_aligned;
 	buf_sizes[buf_id] = count_sectors(buf_masks[buf_id]);
+	buf_free_sps[buf_id] |= sp_bitmap_of(lp_mask_aligned);
+	count_full_staging_buffer(buf_id, old_size);
 
 	if (buf_sizes[buf_id] == 0) free_buf(buf_id);
 }
@@ -140,6 +219,9 @@ static void remove_lp_by_index(UINT32 const lp_idx)
 	lpns[lp_idx]  		= NULL_LPN;
 	lp_masks[lp_idx] 	= 0;
 	lp_buf_ids[lp_idx] 	= NULL_BID;
+#if OPTION_ACL
+	lp_uids[lp_idx]		= NULL_USER_ID;
+#endif
 
 	num_lpns--;
 
@@ -160,6 +242,46 @@ static buf_id_t find_fullest_buffer()
 	return max_buf_id;
 }
 
+/* A ready staging buffer goes first, then the fullest non-staging buffer.
+ * Staging buffers that are still being filled are only chosen if there is
+ * nothing else to flush. */
+static buf_id_t find_victim_buffer()
+{
+	if (num_staging_buffers == 0) return find_fullest_buffer();
+
+	buf_id_t victim_buf_id	 = NULL_BID;
+	UINT8	 victim_buf_size = 0;
+	buf_id_t buf_id = head_buf_id;
+	do {
+		if (is_staging(buf_id)) {
+			if (is_stage_ready(buf_id)) return buf_id;
+		}
+		else if (buf_sizes[buf_id] > victim_buf_size) {
+			victim_buf_id	= buf_id;
+			victim_buf_size	= buf_sizes[buf_id];
+		}
+		buf_id = next_buf_id(buf_id);
+	} while (buf_id != head_buf_id);
+
+	if (victim_buf_id == NULL_BID) return find_fullest_buffer();
+	return victim_buf_id;
+}
+
+static BOOL8 is_sequential_push(UINT32 const lpn,
+				UINT8 const sector_offset
+#if OPTION_ACL
+				,user_id_t const uid
+#endif
+				)
+{
+#if OPTION_ACL
+	if (uid != last_push_uid) return FALSE;
+#endif
+	if (lpn == last_push_lpn)
+		return sector_offset == last_push_end;
+	return lpn == last_push_lpn + 1 && sector_offset == 0 &&
+		last_push_end == SECTORS_PER_PAGE;
+}
 
 static void dump_state() __attribute__ ((unused));
 static void dump_state()
@@ -206,35 +328,100 @@ static void dump_state()
 	uart_print("");
 }
 
+/*
+ * Best-fit allocation of sub-page slots
+ *
+ * Among the buffers in use which have free slots for all sub-pages in the
+ * mask, pick the one with the least free slots left so that buffers get
+ * filled up and are flushed as full pages. A buffer of the same uid group is
+ * preferred, but a buffer of another group is still used before a clean one
+ * is taken, as half-empty pages cost more than sub-pages in the stream of
+ * another group. Staging buffers are not considered.
+ * */
 static UINT8 allocate_buffer_for(sectors_mask_t const mask
 #if OPTION_ACL
-				,user_id_t const uid
+				 ,user_id_t const uid
 #endif
-				)
+				 )
 {
-	buf_id_t new_buf_id = head_buf_id;
+	sp_bitmap_t const needed_sps = sp_bitmap_of(mask);
+	buf_id_t best_buf_id  = NULL_BID,
+		 clean_buf_id = NULL_BID;
+	UINT8	 best_num_free_sps = SUB_PAGES_PER_PAGE + 1;
+#if OPTION_ACL
+	buf_id_t other_buf_id = NULL_BID;
+	UINT8	 other_num_free_sps = SUB_PAGES_PER_PAGE + 1;
+#endif
+
+	buf_id_t buf_id = head_buf_id;
 	do {
+		if (buf_masks[buf_id] == 0) {
+			if (clean_buf_id == NULL_BID) clean_buf_id = buf_id;
+		}
+		else if (is_staging(buf_id)) {
+			/* staging buffers are reserved for their own LPN */
+		}
+		else if ((buf_free_sps[buf_id] & needed_sps) == needed_sps) {
+			UINT8 num_free_sps = count_sub_pages(buf_free_sps[buf_id]);
 #if OPTION_ACL
-		if (buf_masks[new_buf_id] == 0) {
-			ASSERT(buf_uids[new_buf_id] == NULL_USER_ID);
-			allocate_buf(new_buf_id);
-			buf_uids[new_buf_id] = uid;
-			return new_buf_id;
+			if (buf_uid_groups[buf_id] != GC_UID_GROUP(uid)) {
+				if (num_free_sps < other_num_free_sps) {
+					other_num_free_sps = num_free_sps;
+					other_buf_id	   = buf_id;
+				}
+			}
+			else
+#endif
+			if (num_free_sps < best_num_free_sps) {
+				best_num_free_sps = num_free_sps;
+				best_buf_id	  = buf_id;
+				/* a perfect fit */
+				if (num_free_sps == count_sub_pages(needed_sps))
+					break;
+			}
 		}
-		else if (buf_uids[new_buf_id] == uid &&
-				(buf_masks[new_buf_id] & mask) == 0)
-			return new_buf_id;
+		buf_id = next_buf_id(buf_id);
+	} while (buf_id != head_buf_id);
+
+	if (best_buf_id != NULL_BID) return best_buf_id;
+#if OPTION_ACL
+	if (other_buf_id != NULL_BID) return other_buf_id;
+#endif
+
+	ASSERT(clean_buf_id != NULL_BID);
+#if OPTION_ACL
+	allocate_buf(clean_buf_id, uid);
 #else
-		if ((buf_masks[new_buf_id] & mask) == 0) {
-			if (buf_masks[new_buf_id] == 0)
-				allocate_buf(new_buf_id);
-			return new_buf_id;
-		}
+	allocate_buf(clean_buf_id);
+#endif
+	return clean_buf_id;
+}
+
+/* Return NULL_BID if there are too many staging buffers or if it would take
+ * the last clean buffer */
+static UINT8 allocate_staging_buffer_for(UINT32 const lpn
+#if OPTION_ACL
+					 ,user_id_t const uid
+#endif
+					 )
+{
+	if (num_staging_buffers >= MAX_NUM_STAGING_BUFFERS ||
+	    num_clean_buffers <= 1)
+		return NULL_BID;
+
+	buf_id_t buf_id = head_buf_id;
+	while (buf_masks[buf_id] != 0) buf_id = next_buf_id(buf_id);
+
+#if OPTION_ACL
+	allocate_buf(buf_id, uid);
+#else
+	allocate_buf(buf_id);
 #endif
-		new_buf_id = next_buf_id(new_buf_id);
-	} while (new_buf_id != head_buf_id);
-	ASSERT(0);
-	return NULL_BID;
+	buf_stage_lpns[buf_id]	= lpn;
+	buf_stage_times[buf_id]	= push_clock;
+	if (num_staging_buffers == 0) oldest_stage_time = push_clock;
+	num_staging_buffers++;
+	return buf_id;
 }
 
 static UINT32 get_free_lp_index()
@@ -254,11 +441,22 @@ void write_buffer_init()
 	BUG_ON("# of LPN slots must be a multiple of 4", MAX_NUM_LPNS % 4 != 0);
 //	BUG_ON("# of write buffers must be a multiple of 4", NUM_WRITE_BUFFERS % 4 != 0);
 	BUG_ON("# of write buffers is too large", NUM_WRITE_BUFFERS > 255);
+	BUG_ON("# of sub-pages is too large", SUB_PAGES_PER_PAGE > 8);
 
 	num_lpns      = 0;
 	num_clean_buffers   = NUM_WRITE_BUFFERS;
 	head_buf_id   = 0;
 
+	num_staging_buffers = 0;
+	num_full_staging_buffers = 0;
+	oldest_stage_time   = 0;
+	push_clock	    = 0;
+	last_push_lpn	    = NULL_LPN;
+	last_push_end	    = 0;
+#if OPTION_ACL
+	last_push_uid	    = NULL_USER_ID;
+#endif
+
 	mem_set_sram(lpns, 	  NULL_LPN, 	MAX_NUM_LPNS * sizeof(UINT32));
 	mem_set_sram(lp_masks, 	  0, 		MAX_NUM_LPNS * sizeof(sectors_mask_t));
 //	mem_set_sram(lp_buf_ids,  	  0xFFFFFFFF, 	MAX_NUM_LPNS * sizeof(buf_id_t));
@@ -266,15 +464,21 @@ void write_buffer_init()
 	UINT8 i = 0;
 	for (i = 0; i < MAX_NUM_LPNS; i++) {
 		lp_buf_ids[i] = 0xFF;
+#if OPTION_ACL
+		lp_uids[i] = NULL_USER_ID;
+#endif
 	}
 
 	mem_set_sram(buf_masks,   0, 		NUM_WRITE_BUFFERS * sizeof(sectors_mask_t));
 //	mem_set_sram(buf_sizes,   0, 		NUM_WRITE_BUFFERS * sizeof(UINT8));
 	for (i = 0; i < NUM_WRITE_BUFFERS; i++) {
 		buf_sizes[i] = 0;
+		buf_free_sps[i] = ALL_SUB_PAGES;
 		buf_managed_ids[i] = NULL_BUF_ID;
+		buf_stage_lpns[i] = NULL_LPN;
+		buf_stage_times[i] = 0;
 #if OPTION_ACL
-		buf_uids[i] = NULL_USER_ID;
+		buf_uid_groups[i] = 0;
 #endif
 	}
 }
@@ -291,12 +495,12 @@ sectors_mask_t write_buffer_pull(UINT32 const lpn,
 	UINT32 lp_idx;
 	while (next_index_of_lpn(lpn, &lp_idx)) {
 		buf_id_t lp_buf_id	= lp_buf_ids[lp_idx];
-		user_id_t buf_uid	= buf_uids[lp_buf_id];
+		user_id_t lp_uid	= lp_uids[lp_idx];
 		sectors_mask_t lp_valid_sectors = lp_masks[lp_idx];
 
 		sectors_mask_t copied_sectors;
 		UINT32 from_buf;
-		if (buf_uid == uid) {
+		if (lp_uid == uid) {
 			copied_sectors = lp_valid_sectors & target_sectors;
 			from_buf = WRITE_BUF(lp_buf_id);
 		}
@@ -343,11 +547,10 @@ void write_buffer_push(UINT32 const lpn,
 	sectors_mask_t	lp_new_mask_align_to_sp = lp_new_mask;
 	buf_mask_align_to_sp(&lp_new_mask_align_to_sp);
 
-	/* remove common part of this page from other users' buffers */
+	/* remove common part of this page from other users' entries */
 	while (next_index_of_lpn(lpn, &lp_idx)) {
 		buf_id_t lp_buf_id = lp_buf_ids[lp_idx];
-		user_id_t buf_uid = buf_uids[lp_buf_id];
-		if (buf_uid == uid) {
+		if (lp_uids[lp_idx] == uid) {
 			lp_idx_of_this_uid = lp_idx;
 			continue;
 		}
@@ -368,6 +571,18 @@ void write_buffer_push(UINT32 const lpn,
 		}
 	}
 #endif
+	push_clock++;
+#if OPTION_ACL
+	BOOL8 is_seq = is_sequential_push(lpn, sector_offset, uid);
+#else
+	BOOL8 is_seq = is_sequential_push(lpn, sector_offset);
+#endif
+	last_push_lpn = lpn;
+	last_push_end = sector_offset + num_sectors;
+#if OPTION_ACL
+	last_push_uid = uid;
+#endif
+
 	// Try to merge with the same lpn in the buffer
 	buf_id_t	new_buf_id  = NULL_BID;
 #if OPTION_ACL
@@ -383,8 +598,16 @@ void write_buffer_push(UINT32 const lpn,
 		sectors_mask_t  rvs_common_mask = ~(lp_old_mask & lp_new_mask);
 		sectors_mask_t  new_useful_mask = lp_new_mask & rvs_common_mask;
 
+		// Gather a sequential stream into a staging buffer
+		if (is_seq && !is_staging(old_buf_id))
+#if OPTION_ACL
+			new_buf_id = allocate_staging_buffer_for(lpn, uid);
+#else
+			new_buf_id = allocate_staging_buffer_for(lpn);
+#endif
 		// Use old buffer if it has enough room
-		if ((old_buf_mask & new_useful_mask) == 0) {
+		if (new_buf_id == NULL_BID &&
+		    (old_buf_mask & new_useful_mask) == 0) {
 			new_buf_id = old_buf_id;
 		}
 		// Otherwise
@@ -392,10 +615,12 @@ void write_buffer_push(UINT32 const lpn,
 			// we need to find another buffer that fits both
 			// old & new data
 			sectors_mask_t merged_mask = lp_old_mask | lp_new_mask;
+			if (new_buf_id == NULL_BID)
 #if OPTION_ACL
-			new_buf_id = allocate_buffer_for(merged_mask, uid);
+				new_buf_id = allocate_buffer_for(merged_mask,
+								 uid);
 #else
-			new_buf_id = allocate_buffer_for(merged_mask);
+				new_buf_id = allocate_buffer_for(merged_mask);
 #endif
 
 			// move useful part of old data to new buffer
@@ -417,21 +642,60 @@ void write_buffer_push(UINT32 const lpn,
 	// New lpn
 	else {
 #if OPTION_ACL
-		new_buf_id 	   = allocate_buffer_for(lp_new_mask, uid);
+		if (is_seq)
+			new_buf_id = allocate_staging_buffer_for(lpn, uid);
+		if (new_buf_id == NULL_BID)
+			new_buf_id = allocate_buffer_for(lp_new_mask, uid);
 #else
-		new_buf_id 	   = allocate_buffer_for(lp_new_mask);
+		if (is_seq)
+			new_buf_id = allocate_staging_buffer_for(lpn);
+		if (new_buf_id == NULL_BID)
+			new_buf_id = allocate_buffer_for(lp_new_mask);
 #endif
 
 		lp_idx	   	   = get_free_lp_index();
 		lpns[lp_idx]	   = lpn;
 		lp_masks[lp_idx]   = lp_new_mask;
 		lp_buf_ids[lp_idx] = new_buf_id;
+#if OPTION_ACL
+		lp_uids[lp_idx]	   = uid;
+#endif
 
 		num_lpns++;
 	}
 	// Do insertion
 	fla_copy_buffer(WRITE_BUF(new_buf_id), from_buf, lp_new_mask);
 	buf_mask_add(new_buf_id, lp_new_mask);
+	if (is_staging(new_buf_id)) buf_stage_times[new_buf_id] = push_clock;
+}
+
+UINT8 write_buffer_num_used_buffers()
+{
+	return NUM_WRITE_BUFFERS - num_clean_buffers;
+}
+
+UINT8 write_buffer_num_drainable_buffers()
+{
+	/* a ready staging buffer is chosen as victim before all others */
+	return NUM_WRITE_BUFFERS - num_clean_buffers - num_staging_buffers +
+		(write_buffer_has_ready_page() ? 1 : 0);
+}
+
+BOOL8 write_buffer_has_ready_page()
+{
+	if (num_full_staging_buffers) return TRUE;
+	if (num_staging_buffers == 0 ||
+	    push_clock - oldest_stage_time <= STAGE_TIMEOUT) return FALSE;
+
+	/* the oldest staging buffer may have been appended to since; find the
+	 * real one, which is only done once per STAGE_TIMEOUT pushes */
+	UINT32 max_age = 0;
+	for (buf_id_t buf_id = 0; buf_id < NUM_WRITE_BUFFERS; buf_id++)
+		if (is_staging(buf_id))
+			max_age = MAX(max_age,
+				      push_clock - buf_stage_times[buf_id]);
+	oldest_stage_time = push_clock - max_age;
+	return max_age > STAGE_TIMEOUT;
 }
 
 BOOL8 write_buffer_is_full()
@@ -453,25 +717,26 @@ void write_buffer_drop(UINT32 const lpn)
 
 void write_buffer_flush(UINT8 *flushed_buf_id,
 			sectors_mask_t *valid_sectors,
+			UINT32 sp_lpn[SUB_PAGES_PER_PAGE]
 #if OPTION_ACL
-			user_id_t *uid,
+			,user_id_t sp_uid[SUB_PAGES_PER_PAGE]
 #endif
-			UINT32 sp_lpn[SUB_PAGES_PER_PAGE])
+			)
 {
 	/* find a vicitim buffer */
-	buf_id_t buf_id = find_fullest_buffer();
+	buf_id_t buf_id = find_victim_buffer();
 	ASSERT(buf_sizes[buf_id] > 0);
 	ASSERT(buf_id < NUM_WRITE_BUFFERS);
 
 	ASSERT(buf_managed_ids[buf_id] != NULL_BUF_ID);
 	*flushed_buf_id = buf_managed_ids[buf_id];
 	buf_managed_ids[buf_id] = NULL_BUF_ID;
-#if OPION_ACL
-	*uid = buf_uids[buf_id];
-#endif
 
 	*valid_sectors 	= 0;
 	mem_set_sram(sp_lpn, NULL_LPN, sizeof(UINT32) * SUB_PAGES_PER_PAGE);
+#if OPTION_ACL
+	for_each_subpage(sp_i) sp_uid[sp_i] = NULL_USER_ID;
+#endif
 
 	UINT32  lpn_i   = 0;
 	// Iterate each lpn in the victim buffer
@@ -492,7 +757,12 @@ void write_buffer_flush(UINT8 *flushed_buf_id,
 		for (UINT8 sp_i = begin_sp; sp_i < end_sp; sp_i++) {
 			UINT8	lsp_mask = (lp_mask >>
 						(SECTORS_PER_SUB_PAGE * sp_i));
-			if (lsp_mask) sp_lpn[sp_i] = lpn;
+			if (lsp_mask == 0) continue;
+
+			sp_lpn[sp_i] = lpn;
+#if OPTION_ACL
+			sp_uid[sp_i] = lp_uids[lpn_i];
+#endif
 		}
 
 		// remove the lpn from buffer
@@ -503,11 +773,16 @@ void write_buffer_flush(UINT8 *flushed_buf_id,
 	ASSERT(buf_masks[buf_id] == 0ULL);
 	ASSERT(buf_sizes[buf_id] == 0);
 	ASSERT(buf_managed_ids[buf_id] == NULL_BUF_ID);
-#if OPTION_ACL
-	ASSERT(buf_uids[buf_id] == NULL_USER_ID);
-#endif
+	ASSERT(buf_free_sps[buf_id] == ALL_SUB_PAGES);
 	ASSERT(num_clean_buffers > 0);
 
+	/* flash program utilization of write buffer flushes */
+	counter_inc(COUNTER_WRITE_BUFFER_FLUSHES);
+	counter_add(COUNTER_WRITE_BUFFER_FLUSH_SECTORS,
+		    count_sectors(*valid_sectors));
+	debug("flush buffer %u: %u of %u sectors are valid", buf_id,
+	      count_sectors(*valid_sectors), SECTORS_PER_PAGE);
+
 	if (buf_id == head_buf_id)
 		head_buf_id = next_buf_id(head_buf_id);
 }
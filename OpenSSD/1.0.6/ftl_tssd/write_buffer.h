@@ -55,6 +55,26 @@ void write_buffer_drop(UINT32 const lpn);
  */
 BOOL8 write_buffer_is_full();
 
+/*
+ * Return the number of buffers that hold some data and thus need flushing.
+ */
+UINT8 write_buffer_num_used_buffers();
+
+/*
+ * Return the number of buffers that can be flushed without programming a
+ * partial page of a sequential stream, i.e. buffers that are not staging plus
+ * a ready staging buffer.
+ *	If not 0, the next write_buffer_flush() will flush one of them.
+ */
+UINT8 write_buffer_num_drainable_buffers();
+
+/*
+ * Return whether a staging page of a sequential stream is ready to flush,
+ * i.e. the page is full or has not been appended to for a while.
+ *	If true, the next write_buffer_flush() will flush that page.
+ */
+BOOL8 write_buffer_has_ready_page();
+
 /*
  * Flush a buffer in write buffer.
  *
@@ -63,13 +83,16 @@ BOOL8 write_buffer_is_full();
  *	managed buffer after using it.
  *	Output *valid_sectors* indicates which sectors in the buffer is valid;
  *	Output *sp_lpn* keeps the LPN of each sub-page in the flushed buffer;
- *	Output *uid* is the id of the owner of the flushed data;
+ *	Output *sp_uid* keeps the owner of each sub-page in the flushed buffer.
+ *
+ * Note that sub-pages of different users may be flushed in one buffer.
  * */
 void write_buffer_flush(UINT8 *managed_buf_id,
 			sectors_mask_t *valid_sectors,
+			UINT32 sp_lpn[SUB_PAGES_PER_PAGE]
 #if OPTION_ACL
-			user_id_t *uid,
+			,user_id_t sp_uid[SUB_PAGES_PER_PAGE]
 #endif
-			UINT32 sp_lpn[SUB_PAGES_PER_PAGE]);
+			);
 
 #endif
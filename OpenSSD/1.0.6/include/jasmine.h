@@ -22,9 +22,12 @@
 
 #define	FLASH_TYPE		K9LCG08U1M
 #define	DRAM_SIZE		65075200
-// Default flash modules configuration
+// Default flash modules configuration; the host build can override it to
+// simulate other configurations (see build_sim/Makefile)
 //#define	BANK_BMP		0x00330033
+#ifndef BANK_BMP
 #define	BANK_BMP		0x00FF00FF
+#endif
 #define	CLOCK_SPEED		175000000
 
 #define OPTION_ENABLE_ASSERT		1	// 1 = enable ASSERT() for debugging, 0 = disable ASSERT()
@@ -51,6 +54,14 @@
  * by major compoents/functions. This macro is defined in Makefile.
  * */
 
+/* About macro OPTION_SIMULATION
+ *
+ * This macro is defined by the Makefile of the host build (see build_sim),
+ * which runs the firmware as an ordinary Linux process on top of a software
+ * model of Jasmine hardware instead of target_spw. Only FTL test mode is
+ * supported.
+ * */
+
 /* About macro OPTION_2_PLANE
  *
  * Flash performance profiling result shows that flash throughput is
@@ -67,6 +78,33 @@
  * */
 #define OPTION_ACL			1
 
+/* About macro OPTION_LAZY_MERGE
+ *
+ * Without this macro, a sub-page that is only partially valid when flushed
+ * from write buffer is completed by reading its missing sectors from flash
+ * (read-modify-write) before it is programmed. With this macro, the partial
+ * sub-page is programmed as is and the location of its missing sectors is
+ * remembered in a small table (see psp.h), so that the sub-page is merged
+ * lazily when it is read.
+ * */
+#define OPTION_LAZY_MERGE		1
+
+/* About macro OPTION_FDE
+ *
+ * Full Disk Encryption (FDE) encrypts user data before it is programmed into
+ * flash and decrypts it after it is read from flash. Each user has its own
+ * key (see fde.h). Use macro OPTION_FDE to enable FDE.
+ * */
+#define OPTION_FDE			1
+
+/* About macro OPTION_FLA_TRACE
+ *
+ * Flash tracer records every flash command and its completion, together with
+ * the thread and LPN it is issued on behalf of, into a ring buffer in DRAM
+ * (see fla.h). Use macro OPTION_FLA_TRACE to enable flash tracer.
+ * */
+#define OPTION_FLA_TRACE		1
+
 #ifdef OPTION_FTL_TEST
 /* About macro OPTION_FTL_VERIFY
  *
@@ -230,8 +268,10 @@ UINT8 end_sector(sectors_mask_t const mask);
 BOOL8 show_debug_msg;
 
 
+#ifndef MAX_NUM_THREADS
 #define MAX_NUM_THREADS		16
 /* #define MAX_NUM_THREADS		8 */
+#endif
 
 /* virtual page */
 typedef union {
@@ -372,7 +412,7 @@ scan_list_t;
 	#define BUG_ON(MESSAGE, COND) do {\
 		if (COND) {\
 			uart_print("bug on");\
-			while(1);\
+			HANG();\
 		}\
 	} while(0);
 	/* #define BUG_ON(MESSAGE, COND) */
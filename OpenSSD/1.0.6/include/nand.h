@@ -71,7 +71,9 @@
 	#define NAND_SPEC_READ			NAND_SPEC_READ_CYCLE_2
 	#define SECTORS_PER_PHYPAGE 	16
 	#define PAGES_PER_VBLK			128
+	#ifndef _PBLKS_PER_BANK
 	#define _PBLKS_PER_BANK 		4096
+	#endif
 	#define SPARE_PBLKS_PER_BANK	56
 	#define SPARE_PER_PHYPAGE		448
 
@@ -87,7 +89,9 @@
 	#define NAND_SPEC_READ			NAND_SPEC_READ_CYCLE_2
 	#define SECTORS_PER_PHYPAGE 	8
 	#define PAGES_PER_VBLK			256
+	#ifndef _PBLKS_PER_BANK
 	#define _PBLKS_PER_BANK 		(8192/2)
+	#endif
 	#define SPARE_PBLKS_PER_BANK	0
 	#define SPARE_PER_PHYPAGE		224
 
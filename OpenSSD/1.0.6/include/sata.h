@@ -101,6 +101,30 @@ typedef struct
 
 extern sata_context_t	g_sata_context;
 
+#define HW_EQ_SIZE		128
+
+#if OPTION_ACL
+#if OPTION_SUPPORT_NCQ
+/* FPDMA commands are inserted into event queue by hardware without going
+ * through handle_got_cfis(), so their session keys would never be queued. */
+#error "OPTION_ACL does not support OPTION_SUPPORT_NCQ"
+#endif
+
+/* Session keys of the commands in event queue, in the same order. Event queue
+ * can only hold LBA and sector count, so the ISR keeps the session key of a
+ * command here when inserting the command into event queue. */
+typedef struct
+{
+	UINT32	keys[HW_EQ_SIZE];
+	UINT8	head;
+	volatile UINT8	tail;
+	UINT8	unused1;
+	UINT8	unused2;
+} sata_skey_queue_t;
+
+extern sata_skey_queue_t	g_sata_skey_queue;
+#endif
+
 #define	B_ERR	BIT0
 #define	B_DRQ	BIT3
 #define	B_DF	BIT5
@@ -185,6 +209,7 @@ enum
 	ATA_SECURITY_DISABLE_PASSWORD	= 0xF6, /* Security Disable Password */
 	ATA_READ_NATIVE_MAX_ADDRESS		= 0xF8,	/* Read Native Max Address   */
 	ATA_SET_MAX_ADDRESS				= 0xF9,	/* Set Max Address   		 */
+	ATA_TSSD_SESSION				= 0xFA,	/* TrustedSSD Session (vendor specific) */
 	ATA_SRST						= 0xFF	/* SRST request is regarded as if it were an ATA command. */
 };
 
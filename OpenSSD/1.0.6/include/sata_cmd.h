@@ -20,7 +20,7 @@
 #ifndef SATA_CMD_H
 #define SATA_CMD_H
 
-#define	ATA_CMD_NUM			59
+#define	ATA_CMD_NUM			60
 #define	CMD_TABLE_SIZE		60
 
 
@@ -45,6 +45,22 @@ enum tag_FEATURES_subcommands
 	FEATURE_ENABLE_REVERTING_TO_POWER_ON_DEFAULTS		= 0xCC
 };
 
+// sub-commands of TrustedSSD vendor command ATA_TSSD_SESSION
+enum tag_TSSD_SESSION_subcommands
+{
+	TSSD_SESSION_OPEN		= 0x01,
+	TSSD_SESSION_CLOSE		= 0x02,
+	TSSD_SESSION_SET_FDE_KEY	= 0x03,
+	TSSD_SESSION_REVOKE		= 0x04
+};
+
+// SMART sub-command and vendor specific logs of performance counters and
+// flash trace
+#define SMART_READ_LOG			0xD5
+#define SMART_SIGNATURE			0xC24F	/* LBA high and mid */
+#define TSSD_LOG_COUNTERS		0xA0
+#define TSSD_LOG_FLASH_TRACE	0xA1
+
 #define MAXNUM_DRQ_SECTORS		0x01	/* using const UINT8 ht_identify_data[IDENTIFY_VALLEN] */
 
 extern const UINT8 ata_cmd_class_table[];
@@ -75,6 +91,8 @@ void ata_nop(UINT32 lba, UINT32 sector_count);
 void ata_initialize_device_parameters(UINT32 lba, UINT32 sector_count);
 void ata_not_supported(UINT32 lba, UINT32 sector_count);
 void ata_srst(UINT32 lba, UINT32 sector_count);
+void ata_tssd_session(UINT32 lba, UINT32 sector_count);
+void ata_smart(UINT32 lba, UINT32 sector_count);
 
 
 #endif	// SATA_CMD_H
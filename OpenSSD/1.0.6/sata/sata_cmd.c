@@ -20,6 +20,14 @@
 #include "jasmine.h"
 #include "dram.h"
 #include "ftl.h"
+#include "counters.h"
+#include "fla.h"
+#if OPTION_ACL
+#include "acl.h"
+#endif
+#if OPTION_FDE
+#include "fde.h"
+#endif
 
 void ata_check_power_mode(UINT32 lba, UINT32 sector_count)
 {
@@ -128,6 +136,116 @@ void ata_write_buffer(UINT32 lba, UINT32 sector_count)
 	pio_sector_transfer(HIL_BUF_ADDR, PIO_H2D);
 }
 
+// TrustedSSD vendor command to open and close sessions, to revoke users (see
+// acl.h) and to set the master key of full disk encryption (see fde.h).
+// The host sends one sector of data, which consists of UINT32 words:
+//
+//	op, num_entries, skey_0, uid_0, skey_1, uid_1, ...
+//
+// where op is TSSD_SESSION_OPEN, TSSD_SESSION_CLOSE (uid is ignored) or
+// TSSD_SESSION_REVOKE (skey is ignored). Thousands of sessions can be set up by
+// issuing this command repeatedly.
+//
+// If op is TSSD_SESSION_SET_FDE_KEY, num_entries is ignored and the 32 bytes
+// following it are the master key, which turns FDE on. It must be set before
+// any data is written (see fde.h).
+void ata_tssd_session(UINT32 lba, UINT32 sector_count)
+{
+#if OPTION_ACL || OPTION_FDE
+	pio_sector_transfer(HIL_BUF_ADDR, PIO_H2D);
+
+	UINT32 op = read_dram_32(HIL_BUF_ADDR);
+#if OPTION_FDE
+	if (op == TSSD_SESSION_SET_FDE_KEY)
+	{
+		fde_key_t master_key;
+		UINT32 key_addr = HIL_BUF_ADDR + 2 * sizeof(UINT32);
+		UINT32 i;
+		for (i = 0; i < sizeof(master_key.key); i++)
+		{
+			UINT32 word = read_dram_32(key_addr + i / sizeof(UINT32) * sizeof(UINT32));
+			master_key.key[i] = (UINT8)(word >> (8 * (i % sizeof(UINT32))));
+		}
+		if (!fde_set_master_key(&master_key))
+			uart_print("FDE key cannot be changed once data is written");
+		return;
+	}
+#endif
+#if OPTION_ACL
+	UINT32 num_entries = read_dram_32(HIL_BUF_ADDR + sizeof(UINT32));
+	UINT32 max_entries = BYTES_PER_SECTOR / (2 * sizeof(UINT32)) - 1;
+	if (num_entries > max_entries) num_entries = max_entries;
+
+	UINT32 entry_addr = HIL_BUF_ADDR + 2 * sizeof(UINT32);
+	UINT32 i;
+	for (i = 0; i < num_entries; i++, entry_addr += 2 * sizeof(UINT32))
+	{
+		UINT32 skey = read_dram_32(entry_addr);
+		UINT32 uid  = read_dram_32(entry_addr + sizeof(UINT32));
+
+		if (op == TSSD_SESSION_OPEN)
+		{
+			if (!acl_open_session(skey, (user_id_t)uid))
+				uart_print("session table is full");
+		}
+		else if (op == TSSD_SESSION_CLOSE)
+		{
+			acl_close_session(skey);
+		}
+		else if (op == TSSD_SESSION_REVOKE)
+		{
+			if (!acl_revoke_user((user_id_t)uid))
+				uart_print("user cannot be revoked");
+		}
+	}
+#endif
+#else
+	ata_not_supported(lba, sector_count);
+#endif
+}
+
+// SMART READ LOG of the vendor specific logs:
+//
+//	TSSD_LOG_COUNTERS	one sector of performance counters (see counters.h)
+//	TSSD_LOG_FLASH_TRACE	one sector of flash trace events, which are drained
+//				from the ring buffer (see fla.h); hosts read it
+//				until a sector has no events
+//
+// Other SMART sub-commands and logs are not supported.
+void ata_smart(UINT32 lba, UINT32 sector_count)
+{
+	// SMART is not a R/W command, so lba and sector_count are not decoded
+	UINT32 feature = GETREG(SATA_FIS_H2D_0) >> 24;
+	UINT32 lba_regs = GETREG(SATA_FIS_H2D_1) & 0xFFFFFF;
+	UINT32 log_addr = lba_regs & 0xFF;
+	UINT32 signature = lba_regs >> 8;
+	UINT32 num_sectors = GETREG(SATA_FIS_H2D_3) & 0xFF;
+
+	if (feature != SMART_READ_LOG || signature != SMART_SIGNATURE ||
+	    num_sectors != 1)
+	{
+		send_status_to_host(B_ABRT);
+		return;
+	}
+
+	if (log_addr == TSSD_LOG_COUNTERS)
+	{
+		counters_export(HIL_BUF_ADDR);
+	}
+#if OPTION_FLA_TRACE
+	else if (log_addr == TSSD_LOG_FLASH_TRACE)
+	{
+		fla_trace_export(HIL_BUF_ADDR);
+	}
+#endif
+	else
+	{
+		send_status_to_host(B_ABRT);
+		return;
+	}
+	pio_sector_transfer(HIL_BUF_ADDR, PIO_D2H);
+}
+
 void ata_standby(UINT32 lba, UINT32 sector_count)
 {
 	ftl_flush();
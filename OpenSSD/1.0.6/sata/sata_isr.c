@@ -97,20 +97,12 @@ static __inline void handle_srst(void)
 static __inline void handle_got_cfis(void)
 {
 	UINT32 lba, sector_count, cmd_code, cmd_type, fis_d1, fis_d3;
-	UINT32 session_key;
 
 	cmd_code = (GETREG(SATA_FIS_H2D_0) & 0x00FF0000) >> 16;
 	cmd_type = ata_cmd_class_table[cmd_code];
 	fis_d1 = GETREG(SATA_FIS_H2D_1);
 	fis_d3 = GETREG(SATA_FIS_H2D_3);
 
-	// Get session key
-	session_key = GETREG(SATA_FIS_H2D_4);
-	if(session_key) {
-		uart_print("session_key:");
-		uart_print_hex(session_key);
-	}
-
 	if (cmd_type & ATR_LBA_NOR)
 	{
 		if ((fis_d1 & BIT30) == 0)	// CHS
@@ -160,6 +152,13 @@ static __inline void handle_got_cfis(void)
 		SETREG(SATA_LBA, lba);
 		SETREG(SATA_SECT_CNT, sector_count);
 
+#if OPTION_ACL
+		// The session key is passed in the last dword of the FIS; it is
+		// dequeued together with the command in eventq_get().
+		g_sata_skey_queue.keys[g_sata_skey_queue.tail] = GETREG(SATA_FIS_H2D_4);
+		g_sata_skey_queue.tail = (g_sata_skey_queue.tail + 1) % HW_EQ_SIZE;
+#endif
+
 		if (cmd_type & CCL_FTL_H2D)
 		{
 			SETREG(SATA_INSERT_EQ_W, 1);	// The contents of SATA_LBA and SATA_SECT_CNT are inserted into the event queue as a write command.
@@ -24,8 +24,12 @@
 sata_context_t		g_sata_context;
 sata_ncq_t		g_sata_ncq;
 volatile UINT32		g_sata_action_flags;
+#if OPTION_ACL
+sata_skey_queue_t	g_sata_skey_queue;
+#endif
+
+/* #define DEBUG_SESSION_KEY */
 
-#define HW_EQ_SIZE		128
 #define HW_EQ_MARGIN		4
 
 #if OPTION_FTL_TEST
@@ -102,8 +106,9 @@ static void eventq_get(CMD_T* cmd)
 	cmd->sector_count	= EQReadData0 >> 16;
 	cmd->cmd_type		= EQReadData1 >> 31;
 #if OPTION_ACL
-	// FIXME: read real session_key from queue
-	cmd->session_key	= DEFAULT_USER_ID;
+	ASSERT(g_sata_skey_queue.head != g_sata_skey_queue.tail);
+	cmd->session_key	= g_sata_skey_queue.keys[g_sata_skey_queue.head];
+	g_sata_skey_queue.head	= (g_sata_skey_queue.head + 1) % HW_EQ_SIZE;
 #endif
 
 	if(cmd->sector_count == 0)
@@ -120,6 +125,13 @@ static void eventq_get(CMD_T* cmd)
 	}
 
 	enable_fiq();
+
+#if OPTION_ACL && defined(DEBUG_SESSION_KEY)
+	if (cmd->session_key) {
+		uart_print("session_key:");
+		uart_print_hex(cmd->session_key);
+	}
+#endif
 }
 
 #endif
@@ -182,6 +194,9 @@ void sata_reset(void)
 	disable_interrupt();
 
 	mem_set_sram(&g_sata_context, 0, sizeof(g_sata_context));
+#if OPTION_ACL
+	mem_set_sram(&g_sata_skey_queue, 0, sizeof(g_sata_skey_queue));
+#endif
 
 	g_sata_context.write_cache_enabled = TRUE;
 	g_sata_context.read_look_ahead_enabled = TRUE;
@@ -273,7 +273,7 @@ ATR_NO_SECT|ATR_LBA_EXT	| 	CCL_OTHER,			// 0x37	Set Max Address Ext
 							CCL_UNDEFINED,		// 0xF7
 			ATR_LOCK_FREE |	CCL_OTHER,			// 0xF8	Read Native Max Address
 ATR_NO_SECT|ATR_LBA_NOR	| 	CCL_OTHER,			// 0xF9	Set Max Address
-							CCL_UNDEFINED,		// 0xFA
+			ATR_LOCK_FREE |	CCL_OTHER,			// 0xFA	TrustedSSD Session (vendor specific)
 							CCL_UNDEFINED,		// 0xFB
 			ATR_LBA_NOR |	CCL_OTHER,			// 0xFC Delete
 			ATR_LBA_EXT	|	CCL_OTHER,			// 0xFD Delete Ext
@@ -340,10 +340,10 @@ const UINT8 ata_command_code_table[] =
     0xF6,   // 53 SECURITY DISABLE PASSWORD
     0xF8,   // 54 READ NATIVE MAX ADDRESS
     0xF9,   // 55 SET MAX ADDRESS
-    0xFC,  // 56 DELETE
-    0xFD,  // 57 DELETE EXT
-    0xFF,   // 58 SRST
-    0xFF,   // 59 Dummy for 4 byte alignment
+    0xFA,   // 56 TRUSTEDSSD SESSION
+    0xFC,  // 57 DELETE
+    0xFD,  // 58 DELETE EXT
+    0xFF,   // 59 SRST
 };
 
 const ATA_FUNCTION_T ata_function_table[] =
@@ -376,7 +376,7 @@ const ATA_FUNCTION_T ata_function_table[] =
 	ata_idle,							// IDLE
 	ata_check_power_mode,				// CHECK POWER MODE
 	ata_sleep,							// SLEEP
-	(ATA_FUNCTION_T) INVALID32,			// SMART
+	ata_smart,							// SMART
 	(ATA_FUNCTION_T) INVALID32,			// DEVICE CONFIGURATION
 	(ATA_FUNCTION_T) INVALID32,			// READ DMA
 	(ATA_FUNCTION_T) INVALID32,			// WRITE DMA
@@ -404,6 +404,7 @@ const ATA_FUNCTION_T ata_function_table[] =
 	(ATA_FUNCTION_T) INVALID32,			// SECURITY DISABLE PASSWORD
 	ata_read_native_max_address,		// READ NATIVE MAX ADDRESS
 	(ATA_FUNCTION_T) INVALID32,			// SET MAX ADDRESS
+	ata_tssd_session,					// TRUSTEDSSD SESSION
 	(ATA_FUNCTION_T) INVALID32,
 	(ATA_FUNCTION_T) INVALID32,
 	ata_srst,							// SRST
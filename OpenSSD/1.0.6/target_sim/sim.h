@@ -0,0 +1,91 @@
+#ifndef __SIM_H
+#define __SIM_H
+
+/* *
+ * Sim -- a software model of Jasmine hardware
+ *
+ * The host build (see build_sim/Makefile) runs FTL and its unit tests as an
+ * ordinary Linux process. The firmware is compiled as it is, including the
+ * drivers in target_spw, except that GETREG() and SETREG() call into this
+ * model instead of accessing memory-mapped registers (see target.h). The
+ * model emulates
+ *	- the flash controller: the waiting room, the FSM and the interrupt
+ *	  flags of every bank and the data of every flash page, with the NAND
+ *	  timings below and a bus per channel shared by the banks of it;
+ *	- the memory utility: copy, set, bitmap find and the search engine;
+ *	- the timers and the UART, whose output goes to stdout.
+ * Interrupts are never raised. DRAM is mapped at DRAM_BASE with the layout of
+ * the real one, i.e. 4 bytes of ECC after every 128 bytes of data, so that
+ * read_dram_*() work unchanged; the rest of the address space below DRAM_BASE
+ * is SRAM.
+ *
+ * Time is virtual. The clock advances only when firmware accesses a register
+ * or waits for the hardware: a register access costs SIM_REG_ACCESS_CYCLES
+ * CPU cycles and a memory utility command costs SIM_MU_CYCLES_PER_WORD cycles
+ * per word. Polling the waiting room or MON_CHABANKIDLE while the flash
+ * controller is busy, or polling bank FSMs SIM_IDLE_POLLS times in a row with
+ * no other register access, fast-forwards the clock to the next completion of
+ * a flash command. Computation of firmware itself is free, so the throughput
+ * measured in the model is the bound set by flash and memory utility.
+ * */
+
+/* NAND array timings; bank.h and nand.h only describe the geometry, so the
+ * typical numbers of the cell type are used unless the Makefile gives a
+ * timing profile (see test/util/sweep.py) */
+#ifndef SIM_NAND_T_R_NS
+#if NAND_SPEC_CELL == NAND_SPEC_CELL_SLC
+#define SIM_NAND_T_R_NS		25000
+#define SIM_NAND_T_PROG_NS	250000
+#define SIM_NAND_T_BERS_NS	1500000
+#else
+#define SIM_NAND_T_R_NS		60000
+#define SIM_NAND_T_PROG_NS	1300000
+#define SIM_NAND_T_BERS_NS	3500000
+#endif
+#endif
+/* other commands, e.g. reset and wait */
+#define SIM_NAND_T_MISC_NS	1000
+/* a channel moves CHN_WIDTH bytes per flash cycle */
+#ifndef SIM_PS_PER_BUS_BYTE
+#define SIM_PS_PER_BUS_BYTE	(PS_PER_FLASH_CYCLE / CHN_WIDTH)
+#endif
+#define SIM_CHANNEL(RBANK)	((RBANK) % NUM_CHNLS_MAX)
+
+#define SIM_REG_ACCESS_CYCLES	4
+#define SIM_MU_CYCLES_PER_WORD	2
+#define SIM_IDLE_POLLS		64
+/* firmware hangs if it polls this many times with flash idle */
+#define SIM_HANG_POLLS		(1 << 26)
+
+#define SIM_NS_PER_CYCLES(n)	((UINT64)(n) * 1000000000ULL / CLOCK_SPEED)
+
+#define SIM_DRAM_BYTES		(DRAM_SIZE / DRAM_ECC_UNIT * (DRAM_ECC_UNIT + 4))
+#define SIM_SRAM_BYTES		(96 * 1024)
+
+/* Register access, see target.h */
+UINT32 sim_getreg(UINT32 const addr);
+void   sim_setreg(UINT32 const addr, UINT32 const val);
+/* Stop the simulation because of a bug of firmware */
+void   sim_halt(void) __attribute__ ((noreturn));
+
+/* Virtual clock */
+UINT64 sim_now(void);
+void   sim_advance(UINT64 const ns);
+void   sim_advance_to(UINT64 const time);
+/* Number of register accesses so far */
+UINT64 sim_num_accesses(void);
+
+/* Copy between the address space of firmware and host memory */
+void sim_mem_read(UINT32 const addr, void *buf, UINT32 const num_bytes);
+void sim_mem_write(UINT32 const addr, void const *buf, UINT32 const num_bytes);
+
+/* Components of the model */
+void   sim_flash_init(void);
+void   sim_flash_print_stats(void);
+UINT32 sim_flash_getreg(UINT32 const addr);
+void   sim_flash_setreg(UINT32 const addr, UINT32 const val);
+
+UINT32 sim_mu_getreg(UINT32 const addr);
+void   sim_mu_setreg(UINT32 const addr, UINT32 const val);
+
+#endif /* __SIM_H */
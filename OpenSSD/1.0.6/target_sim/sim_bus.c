@@ -0,0 +1,245 @@
+/* *
+ * The register bus of the model, the virtual clock, the timers and the UART
+ * */
+#include "jasmine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#define FREG_END		(FREG_BASE + 0x1000)
+#define MREG_END		(MREG_BASE + 0x1000)
+#define TIMER_END		(TIMER_BASE + 0x80)
+#define UART_END		(UART_FIFODATA + 4)
+#define DRAM_END		(DRAM_BASE + SIM_DRAM_BYTES)
+
+#define in_range(addr, begin, end)	((addr) >= (begin) && (addr) < (end))
+
+#define dram_real_addr(addr)	(DRAM_BASE + ((addr) - DRAM_BASE) / DRAM_ECC_UNIT *\
+				 (DRAM_ECC_UNIT + 4) + ((addr) - DRAM_BASE) % DRAM_ECC_UNIT)
+#define host_ptr(addr)		((void*)(uintptr_t)(addr))
+
+static UINT64	now;
+static UINT64	num_accesses;
+
+/* ===========================================================================
+ *  Virtual Clock
+ * =========================================================================*/
+
+UINT64 sim_now(void)
+{
+	return now;
+}
+
+void sim_advance(UINT64 const ns)
+{
+	now += ns;
+}
+
+void sim_advance_to(UINT64 const time)
+{
+	if (time > now) now = time;
+}
+
+UINT64 sim_num_accesses(void)
+{
+	return num_accesses;
+}
+
+void sim_halt(void)
+{
+	fflush(stdout);
+	fprintf(stderr, "sim: firmware halted at %lluus of virtual time\n",
+		now / 1000);
+	abort();
+}
+
+/* ===========================================================================
+ *  Memory
+ * =========================================================================*/
+
+void sim_mem_read(UINT32 const addr, void *buf, UINT32 const num_bytes)
+{
+	if (addr < DRAM_BASE) {
+		memcpy(buf, host_ptr(addr), num_bytes);
+		return;
+	}
+
+	UINT32 done = 0;
+	while (done < num_bytes) {
+		UINT32 a = addr + done;
+		UINT32 n = MIN(num_bytes - done,
+			       DRAM_ECC_UNIT - (a - DRAM_BASE) % DRAM_ECC_UNIT);
+		memcpy((UINT8*)buf + done, host_ptr(dram_real_addr(a)), n);
+		done += n;
+	}
+}
+
+void sim_mem_write(UINT32 const addr, void const *buf, UINT32 const num_bytes)
+{
+	if (addr < DRAM_BASE) {
+		memcpy(host_ptr(addr), buf, num_bytes);
+		return;
+	}
+
+	UINT32 done = 0;
+	while (done < num_bytes) {
+		UINT32 a = addr + done;
+		UINT32 n = MIN(num_bytes - done,
+			       DRAM_ECC_UNIT - (a - DRAM_BASE) % DRAM_ECC_UNIT);
+		memcpy(host_ptr(dram_real_addr(a)), (UINT8 const*)buf + done, n);
+		done += n;
+	}
+}
+
+/* ===========================================================================
+ *  Timers
+ * =========================================================================*/
+
+#define NUM_TIMERS		4
+#define timer_of(addr)		(((addr) - TIMER_BASE) / 0x20)
+#define timer_reg(addr)		(((addr) - TIMER_BASE) % 0x20)
+
+static struct {
+	UINT32	load;
+	UINT32	control;
+	UINT64	start;
+} timers[NUM_TIMERS];
+
+/* A timer counts down at half of CPU clock, divided by its prescale */
+static UINT32 timer_value(UINT32 const i)
+{
+	if ((timers[i].control & TM_ENABLE) == 0) return timers[i].load;
+
+	UINT32 prescale = (timers[i].control >> 2) & 0x3;
+	UINT32 div = PRESCALE_TO_DIV(prescale);
+	UINT64 ticks = (now - timers[i].start) * (CLOCK_SPEED / 2 / div) /
+			1000000000ULL;
+	return timers[i].load - (UINT32)ticks;
+}
+
+static UINT32 timer_getreg(UINT32 const addr)
+{
+	UINT32 i = timer_of(addr);
+	switch (timer_reg(addr)) {
+	case 0x00: return timers[i].load;
+	case 0x04: return timer_value(i);
+	case 0x08: return timers[i].control;
+	}
+	return 0;
+}
+
+static void timer_setreg(UINT32 const addr, UINT32 const val)
+{
+	UINT32 i = timer_of(addr);
+	switch (timer_reg(addr)) {
+	case 0x00:
+		timers[i].load = val;
+		timers[i].start = now;
+		break;
+	case 0x08:
+		if ((val & TM_ENABLE) && (timers[i].control & TM_ENABLE) == 0)
+			timers[i].start = now;
+		timers[i].control = val;
+		break;
+	}
+}
+
+/* ===========================================================================
+ *  UART
+ * =========================================================================*/
+
+/* TX FIFO is always empty and RX FIFO has nothing */
+#define UART_FIFOCNT_EMPTY	0x800
+
+static UINT32 uart_getreg(UINT32 const addr)
+{
+	if (addr == UART_FIFOCNT) return UART_FIFOCNT_EMPTY;
+	return 0;
+}
+
+static void uart_setreg(UINT32 const addr, UINT32 const val)
+{
+	if (addr == UART_FIFODATA && val != '\r') putchar(val);
+}
+
+/* ===========================================================================
+ *  Other Registers
+ * =========================================================================*/
+
+/* The rest of the registers only remember what is written to them */
+#define NUM_OTHER_REGS		1024
+#define NULL_REG_ADDR		0
+
+static struct {
+	UINT32	addr;
+	UINT32	val;
+} other_regs[NUM_OTHER_REGS];
+
+static UINT32 find_other_reg(UINT32 const addr)
+{
+	UINT32 i = (addr * 2654435761u) % NUM_OTHER_REGS;
+	while (other_regs[i].addr != addr && other_regs[i].addr != NULL_REG_ADDR)
+		i = (i + 1) % NUM_OTHER_REGS;
+	return i;
+}
+
+static UINT32 other_getreg(UINT32 const addr)
+{
+	return other_regs[find_other_reg(addr)].val;
+}
+
+static void other_setreg(UINT32 const addr, UINT32 const val)
+{
+	UINT32 i = find_other_reg(addr);
+	if (other_regs[i].addr == NULL_REG_ADDR) {
+		static UINT32 num_other_regs = 0;
+		if (++num_other_regs == NUM_OTHER_REGS) {
+			fprintf(stderr, "sim: too many registers\n");
+			sim_halt();
+		}
+		other_regs[i].addr = addr;
+	}
+	other_regs[i].val = val;
+}
+
+/* ===========================================================================
+ *  Register Bus
+ * =========================================================================*/
+
+UINT32 sim_getreg(UINT32 const addr)
+{
+	num_accesses++;
+	now += SIM_NS_PER_CYCLES(SIM_REG_ACCESS_CYCLES);
+
+	if (addr < DRAM_END)
+		return *(volatile UINT32*)host_ptr(addr);
+	if (in_range(addr, FREG_BASE, FREG_END))
+		return sim_flash_getreg(addr);
+	if (in_range(addr, MREG_BASE, MREG_END))
+		return sim_mu_getreg(addr);
+	if (in_range(addr, TIMER_BASE, TIMER_END))
+		return timer_getreg(addr);
+	if (in_range(addr, UART_CTRL, UART_END))
+		return uart_getreg(addr);
+	return other_getreg(addr);
+}
+
+void sim_setreg(UINT32 const addr, UINT32 const val)
+{
+	num_accesses++;
+	now += SIM_NS_PER_CYCLES(SIM_REG_ACCESS_CYCLES);
+
+	if (addr < DRAM_END)
+		*(volatile UINT32*)host_ptr(addr) = val;
+	else if (in_range(addr, FREG_BASE, FREG_END))
+		sim_flash_setreg(addr, val);
+	else if (in_range(addr, MREG_BASE, MREG_END))
+		sim_mu_setreg(addr, val);
+	else if (in_range(addr, TIMER_BASE, TIMER_END))
+		timer_setreg(addr, val);
+	else if (in_range(addr, UART_CTRL, UART_END))
+		uart_setreg(addr, val);
+	else
+		other_setreg(addr, val);
+}
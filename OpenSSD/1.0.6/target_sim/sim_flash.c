@@ -0,0 +1,427 @@
+/* *
+ * The flash controller of the model
+ *
+ * A command written to FCP registers is copied to the waiting room when
+ * FCP_ISSUE is written, and is taken by its bank as soon as the bank is idle.
+ * A bank is busy for the time of the array operation (see SIM_NAND_T_*) plus
+ * the time of moving data on the bus of its channel, which is shared by all
+ * the banks of the channel and serves them in the order of commands. The data
+ * of a command are read from or written to DRAM when the command completes.
+ * */
+#include "jasmine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NUM_RBANKS		NUM_BANKS_MAX
+#define ROWS_PER_RBANK		(VBLKS_PER_BANK * PAGES_PER_VBLK)
+
+#define freg(addr)		fregs[((addr) - FREG_BASE) / sizeof(UINT32)]
+
+typedef struct {
+	UINT32	cmd;
+	UINT32	option;
+	UINT32	dma_addr;
+	UINT32	dma_cnt;
+	UINT32	col;
+	UINT32	row;
+	UINT32	dst_col;
+	UINT32	dst_row;
+} fcmd_t;
+
+typedef struct {
+	BOOL8	busy;
+	UINT8	intr;
+	UINT64	busy_until;
+	fcmd_t	fcmd;
+} bank_t;
+
+static UINT32	fregs[0x1000 / sizeof(UINT32)];
+static bank_t	banks[NUM_RBANKS];
+static UINT64	chn_free_time[NUM_CHNLS_MAX];
+/* flash pages of a bank; NULL means erased */
+static UINT8	**pages[NUM_RBANKS];
+static UINT8	page_buf[BYTES_PER_PAGE];
+
+static struct {
+	BOOL8	full;
+	UINT32	rbank;
+	fcmd_t	fcmd;
+} waiting_room;
+
+/* consecutive polls of bank FSMs */
+static UINT64	num_polls, last_poll;
+
+static struct {
+	UINT32	reads, programs, copybacks, erases;
+	UINT32	overwrites;
+	UINT64	bus_bytes;
+} stats;
+
+/* ===========================================================================
+ *  Flash Pages
+ * =========================================================================*/
+
+static void check_row(UINT32 const rbank, UINT32 const row)
+{
+	if (row < ROWS_PER_RBANK) return;
+	fprintf(stderr, "sim: row %u is out of bank %u\n", row, rbank);
+	sim_halt();
+}
+
+static UINT8 *get_page(UINT32 const rbank, UINT32 const row)
+{
+	check_row(rbank, row);
+	return pages[rbank][row];
+}
+
+/* Program a page with the data in page_buf */
+static void program_page(UINT32 const rbank, UINT32 const row)
+{
+	check_row(rbank, row);
+
+	UINT8 *page = pages[rbank][row];
+	if (page != NULL) {
+		stats.overwrites++;
+		fprintf(stderr, "sim: row %u of bank %u is programmed "
+			"without being erased\n", row, rbank);
+	}
+	else {
+		page = malloc(BYTES_PER_PAGE);
+		if (page == NULL) {
+			fprintf(stderr, "sim: out of memory for flash\n");
+			sim_halt();
+		}
+		pages[rbank][row] = page;
+	}
+	memcpy(page, page_buf, BYTES_PER_PAGE);
+}
+
+/* Load a page into page_buf and return FIRQ_ALL_FF if it is erased */
+static UINT8 load_page(UINT32 const rbank, UINT32 const row)
+{
+	UINT8 *page = get_page(rbank, row);
+	if (page == NULL) {
+		memset(page_buf, 0xFF, BYTES_PER_PAGE);
+		return FIRQ_ALL_FF;
+	}
+	memcpy(page_buf, page, BYTES_PER_PAGE);
+	return 0;
+}
+
+static void erase_block(UINT32 const rbank, UINT32 const row)
+{
+	UINT32 first_row = row / PAGES_PER_VBLK * PAGES_PER_VBLK;
+	check_row(rbank, first_row);
+
+	for (UINT32 r = first_row; r < first_row + PAGES_PER_VBLK; r++) {
+		free(pages[rbank][r]);
+		pages[rbank][r] = NULL;
+	}
+}
+
+/* The DMA address of a command is the address of the page in DRAM, so the
+ * sectors from column *col* are at the same offset of the buffer */
+static void dma_in(fcmd_t const *fcmd, UINT32 const col)
+{
+	UINT32 offset = col * BYTES_PER_SECTOR;
+	if (offset + fcmd->dma_cnt > BYTES_PER_PAGE) {
+		fprintf(stderr, "sim: DMA of %u bytes at sector %u\n",
+			fcmd->dma_cnt, col);
+		sim_halt();
+	}
+	sim_mem_read(fcmd->dma_addr + offset, page_buf + offset, fcmd->dma_cnt);
+}
+
+static void dma_out(fcmd_t const *fcmd)
+{
+	UINT32 offset = fcmd->col * BYTES_PER_SECTOR;
+	if (offset + fcmd->dma_cnt > BYTES_PER_PAGE) {
+		fprintf(stderr, "sim: DMA of %u bytes at sector %u\n",
+			fcmd->dma_cnt, fcmd->col);
+		sim_halt();
+	}
+	sim_mem_write(fcmd->dma_addr + offset, page_buf + offset, fcmd->dma_cnt);
+}
+
+/* ===========================================================================
+ *  Banks
+ * =========================================================================*/
+
+/* Occupy the bus of a channel for *num_bytes* from *time* at the earliest
+ * and return the time when the transfer is done */
+static UINT64 transfer(UINT32 const rbank, UINT64 const time,
+		       UINT32 const num_bytes)
+{
+	UINT64 *free_time = &chn_free_time[SIM_CHANNEL(rbank)];
+	UINT64 begin = MAX(time, *free_time);
+	*free_time = begin + (UINT64)num_bytes * SIM_PS_PER_BUS_BYTE / 1000;
+	stats.bus_bytes += num_bytes;
+	return *free_time;
+}
+
+static void start(UINT32 const rbank, fcmd_t const *fcmd, UINT64 const time)
+{
+	bank_t *bank = &banks[rbank];
+	UINT64 done;
+
+	switch (fcmd->cmd) {
+	case FC_COL_ROW_READ_OUT:
+		done = transfer(rbank, time + SIM_NAND_T_R_NS, fcmd->dma_cnt);
+		stats.reads++;
+		break;
+	case FC_COL_ROW_IN_PROG:
+		done = transfer(rbank, time, fcmd->dma_cnt) + SIM_NAND_T_PROG_NS;
+		stats.programs++;
+		break;
+	case FC_COPYBACK:
+		done = time + SIM_NAND_T_R_NS + SIM_NAND_T_PROG_NS;
+		stats.copybacks++;
+		break;
+	case FC_MODIFY_COPYBACK:
+		done = transfer(rbank, time + SIM_NAND_T_R_NS, fcmd->dma_cnt) +
+		       SIM_NAND_T_PROG_NS;
+		stats.copybacks++;
+		break;
+	case FC_ERASE:
+		done = time + SIM_NAND_T_BERS_NS;
+		stats.erases++;
+		break;
+	case FC_GENERIC:
+	case FC_GENERIC_ADDR:
+	case FC_WAIT:
+	case FC_IN:
+		done = time + SIM_NAND_T_MISC_NS;
+		break;
+	default:
+		fprintf(stderr, "sim: flash command 0x%x is not supported\n",
+			fcmd->cmd);
+		sim_halt();
+	}
+
+	bank->busy	 = TRUE;
+	bank->busy_until = done;
+	bank->fcmd	 = *fcmd;
+	freg(_BSP_CMD(rbank))	 = fcmd->cmd;
+	freg(_BSP_OPTION(rbank)) = fcmd->option;
+	freg(_BSP_ROW_L(rbank))	 = fcmd->row;
+	freg(_BSP_ROW_H(rbank))	 = fcmd->row;
+}
+
+static void finish(UINT32 const rbank)
+{
+	bank_t *bank = &banks[rbank];
+	fcmd_t const *fcmd = &bank->fcmd;
+
+	switch (fcmd->cmd) {
+	case FC_COL_ROW_READ_OUT:
+		bank->intr |= load_page(rbank, fcmd->row);
+		dma_out(fcmd);
+		break;
+	case FC_COL_ROW_IN_PROG:
+		memset(page_buf, 0xFF, BYTES_PER_PAGE);
+		dma_in(fcmd, fcmd->col);
+		program_page(rbank, fcmd->row);
+		break;
+	case FC_COPYBACK:
+		load_page(rbank, fcmd->row);
+		program_page(rbank, fcmd->dst_row);
+		break;
+	case FC_MODIFY_COPYBACK:
+		load_page(rbank, fcmd->row);
+		dma_in(fcmd, fcmd->dst_col);
+		program_page(rbank, fcmd->dst_row);
+		break;
+	case FC_ERASE:
+		erase_block(rbank, fcmd->row);
+		break;
+	}
+
+	bank->busy = FALSE;
+}
+
+/* Complete the commands that are done by now, in the order of time */
+static void update(void)
+{
+	while (1) {
+		UINT32 first = NUM_RBANKS;
+		for (UINT32 rbank = 0; rbank < NUM_RBANKS; rbank++) {
+			if (!banks[rbank].busy ||
+			    banks[rbank].busy_until > sim_now()) continue;
+			if (first == NUM_RBANKS ||
+			    banks[rbank].busy_until < banks[first].busy_until)
+				first = rbank;
+		}
+		if (first == NUM_RBANKS) return;
+
+		finish(first);
+
+		if (waiting_room.full && waiting_room.rbank == first) {
+			waiting_room.full = FALSE;
+			start(first, &waiting_room.fcmd,
+			      banks[first].busy_until);
+		}
+	}
+}
+
+static BOOL8 is_busy(void)
+{
+	if (waiting_room.full) return TRUE;
+	for (UINT32 rbank = 0; rbank < NUM_RBANKS; rbank++)
+		if (banks[rbank].busy) return TRUE;
+	return FALSE;
+}
+
+/* Fast-forward to the next completion of a command */
+static void wait_next_completion(void)
+{
+	UINT64 next = 0;
+	for (UINT32 rbank = 0; rbank < NUM_RBANKS; rbank++) {
+		if (!banks[rbank].busy) continue;
+		if (next == 0 || banks[rbank].busy_until < next)
+			next = banks[rbank].busy_until;
+	}
+	sim_advance_to(next);
+	update();
+}
+
+static void issue(void)
+{
+	UINT32 rbank = freg(FCP_BANK);
+	if (waiting_room.full) {
+		fprintf(stderr, "sim: a command is issued to bank %u while "
+			"the waiting room is not empty\n", rbank);
+		sim_halt();
+	}
+	if (rbank >= NUM_RBANKS || pages[rbank] == NULL) {
+		fprintf(stderr, "sim: a command is issued to absent bank %u\n",
+			rbank);
+		sim_halt();
+	}
+
+	fcmd_t fcmd = {
+		.cmd	  = freg(FCP_CMD),
+		.option	  = freg(FCP_OPTION),
+		.dma_addr = freg(FCP_DMA_ADDR),
+		.dma_cnt  = freg(FCP_DMA_CNT),
+		.col	  = freg(FCP_COL),
+		.row	  = freg(_FCP_ROW_L(rbank)),
+		.dst_col  = freg(FCP_DST_COL),
+		.dst_row  = freg(FCP_DST_ROW_L)
+	};
+
+	update();
+	if (banks[rbank].busy) {
+		waiting_room.full  = TRUE;
+		waiting_room.rbank = rbank;
+		waiting_room.fcmd  = fcmd;
+	}
+	else
+		start(rbank, &fcmd, sim_now());
+}
+
+/* Firmware polls bank FSMs in a loop when it has nothing else to do */
+static void poll(void)
+{
+	UINT64 access = sim_num_accesses();
+	num_polls = last_poll + 1 == access ? num_polls + 1 : 1;
+	last_poll = access;
+
+	update();
+	if (num_polls < SIM_IDLE_POLLS) return;
+
+	if (is_busy()) {
+		wait_next_completion();
+		num_polls = 0;
+	}
+	else if (num_polls >= SIM_HANG_POLLS) {
+		fprintf(stderr, "sim: firmware keeps polling idle flash\n");
+		sim_halt();
+	}
+}
+
+static UINT32 pack_bank_bytes(UINT32 const addr, UINT32 const base,
+			      BOOL8 const fsm)
+{
+	UINT32 first = addr - base, val = 0;
+	for (UINT32 i = 0; i < sizeof(UINT32); i++) {
+		bank_t const *bank = &banks[first + i];
+		UINT8 b = fsm ? (bank->busy ? BANK_WAIT : BANK_IDLE) :
+				bank->intr;
+		val |= (UINT32)b << (i * 8);
+	}
+	return val;
+}
+
+/* ===========================================================================
+ *  Public Functions
+ * =========================================================================*/
+
+void sim_flash_init(void)
+{
+	UINT8 const bank_map[] = BANK_MAP;
+
+	for (UINT32 bank = 0; bank < NUM_BANKS; bank++) {
+		UINT32 rbank = bank_map[bank];
+		pages[rbank] = calloc(ROWS_PER_RBANK, sizeof(UINT8*));
+		if (pages[rbank] == NULL) {
+			fprintf(stderr, "sim: out of memory for flash\n");
+			sim_halt();
+		}
+
+		/* the scan list written by installer has no bad blocks */
+		memset(page_buf, 0xFF, BYTES_PER_PAGE);
+		((scan_list_t*)page_buf)->num_entries = 0;
+		program_page(rbank, SCAN_LIST_PAGE_OFFSET);
+	}
+}
+
+void sim_flash_print_stats(void)
+{
+	printf("sim: flash %u reads, %u programs, %u copybacks, %u erases, "
+	       "%lluMB on the bus\n",
+	       stats.reads, stats.programs, stats.copybacks, stats.erases,
+	       stats.bus_bytes / 1024 / 1024);
+	if (stats.overwrites)
+		printf("sim: %u pages programmed without being erased\n",
+		       stats.overwrites);
+}
+
+UINT32 sim_flash_getreg(UINT32 const addr)
+{
+	if (addr == WR_STAT) {
+		update();
+		if (waiting_room.full) wait_next_completion();
+		return waiting_room.full;
+	}
+	if (addr == MON_CHABANKIDLE) {
+		update();
+		if (is_busy()) wait_next_completion();
+		return is_busy();
+	}
+	if (addr >= BSP_FSM_BASE && addr < BSP_FSM_BASE + NUM_RBANKS) {
+		poll();
+		return pack_bank_bytes(addr, BSP_FSM_BASE, TRUE);
+	}
+	if (addr >= BSP_INTR_BASE && addr < BSP_INTR_BASE + NUM_RBANKS) {
+		poll();
+		return pack_bank_bytes(addr, BSP_INTR_BASE, FALSE);
+	}
+	return freg(addr);
+}
+
+void sim_flash_setreg(UINT32 const addr, UINT32 const val)
+{
+	if (addr == FCP_ISSUE) {
+		issue();
+		return;
+	}
+	if (addr >= BSP_INTR_BASE && addr < BSP_INTR_BASE + NUM_RBANKS) {
+		/* write 1 to clear */
+		UINT32 first = addr - BSP_INTR_BASE;
+		for (UINT32 i = 0; i < sizeof(UINT32); i++)
+			banks[first + i].intr &= ~(UINT8)(val >> (i * 8));
+		return;
+	}
+	freg(addr) = val;
+}
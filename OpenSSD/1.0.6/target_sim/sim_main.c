@@ -0,0 +1,123 @@
+/* *
+ * Entry of the host build, which replaces init_gnu.s and initialize.c
+ *
+ * The address space of firmware is 32-bit, so DRAM and SRAM are mapped at
+ * their addresses on Jasmine and firmware runs on a stack that is mapped below
+ * DRAM, since the addresses of local variables are given to the memory
+ * utility as well. The binary is linked at a fixed low address (see
+ * build_sim/Makefile) so that global variables are below DRAM, too.
+ * */
+#define _GNU_SOURCE
+#include "jasmine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <ucontext.h>
+
+#define SIM_STACK_BASE		0x20000000
+#define SIM_STACK_BYTES		(8 * 1024 * 1024)
+
+extern void ftl_open(void);
+extern void ftl_test(void);
+
+static ucontext_t	host_context, fw_context;
+static BOOL32		irq_disabled, fiq_disabled;
+
+/* ===========================================================================
+ *  Functions of init_gnu.s
+ * =========================================================================*/
+
+UINT32 disable_irq(void)
+{
+	BOOL32 was_disabled = irq_disabled;
+	irq_disabled = TRUE;
+	return was_disabled;
+}
+
+void enable_irq(void)
+{
+	irq_disabled = FALSE;
+}
+
+UINT32 disable_fiq(void)
+{
+	BOOL32 was_disabled = fiq_disabled;
+	fiq_disabled = TRUE;
+	return was_disabled;
+}
+
+void enable_fiq(void)
+{
+	fiq_disabled = FALSE;
+}
+
+void disable_interrupt(void)
+{
+	disable_irq();
+	disable_fiq();
+}
+
+void enable_interrupt(void)
+{
+	enable_irq();
+	enable_fiq();
+}
+
+/* ===========================================================================
+ *  Firmware
+ * =========================================================================*/
+
+static void fw_main(void)
+{
+	sim_flash_init();
+
+	uart_init();
+	uart_print("Welcome to OpenSSD");
+	flash_reset();
+
+	ftl_open();
+
+	UINT64 begin = sim_now();
+	ftl_test();
+	UINT64 end = sim_now();
+
+	fflush(stdout);
+	printf("sim: ftl_test took %llums of virtual time\n",
+	       (end - begin) / 1000000);
+	sim_flash_print_stats();
+	exit(0);
+}
+
+static void map_fixed(UINT32 const addr, UINT32 const num_bytes,
+		      int const prot, char const *name)
+{
+	void *p = mmap((void*)(uintptr_t)addr, num_bytes, prot,
+		       MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+		       -1, 0);
+	if (p == MAP_FAILED || p != (void*)(uintptr_t)addr) {
+		fprintf(stderr, "sim: cannot map %s at 0x%08x\n", name, addr);
+		exit(1);
+	}
+}
+
+int main(void)
+{
+	setvbuf(stdout, NULL, _IOLBF, 0);
+
+	map_fixed(DRAM_BASE, SIM_DRAM_BYTES, PROT_READ | PROT_WRITE, "DRAM");
+	map_fixed(SRAM_BASE, SIM_SRAM_BYTES, PROT_READ | PROT_WRITE, "SRAM");
+	/* nested functions (see lambda in jasmine.h) need executable stack */
+	map_fixed(SIM_STACK_BASE, SIM_STACK_BYTES,
+		  PROT_READ | PROT_WRITE | PROT_EXEC, "stack");
+
+	getcontext(&fw_context);
+	fw_context.uc_stack.ss_sp   = (void*)(uintptr_t)SIM_STACK_BASE;
+	fw_context.uc_stack.ss_size = SIM_STACK_BYTES;
+	fw_context.uc_link	    = &host_context;
+	makecontext(&fw_context, fw_main, 0);
+	swapcontext(&host_context, &fw_context);
+
+	fprintf(stderr, "sim: firmware returned\n");
+	return 1;
+}
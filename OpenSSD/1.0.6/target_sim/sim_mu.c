@@ -0,0 +1,169 @@
+/* *
+ * The memory utility of the model
+ *
+ * A command is done as soon as it is written to MU_CMD; the clock advances
+ * by the time the hardware would take.
+ * */
+#include "jasmine.h"
+#include <stdio.h>
+
+#define MU_RESULT_BUSY		0xFFFFFFFF
+
+#define MU_CMD_IS_DRAM(cmd)	(((cmd) & 0x040) != 0)
+#define MU_CMD_OP(cmd)		((cmd) & ~0x040)
+/* ops of commands regardless of SRAM or DRAM */
+#define MU_OP_SET_REPT		MU_CMD_SET_REPT_SRAM
+#define MU_OP_SET_INCR_32	MU_CMD_SET_INCR_32_SRAM
+#define MU_OP_SET_INCR_16	MU_CMD_SET_INCR_16_SRAM
+#define MU_OP_SET_INCR_8	MU_CMD_SET_INCR_8_SRAM
+#define MU_OP_FIND		MU_CMD_FIND_SRAM
+#define MU_OP_SEARCH_MAX	MU_CMD_SEARCH_MAX_SRAM
+#define MU_OP_SEARCH_MIN	MU_CMD_SEARCH_MIN_SRAM
+#define MU_OP_SEARCH_EQU	MU_CMD_SEARCH_EQU_SRAM
+
+static UINT32	src_addr, dst_addr, value, size, result, unitstep;
+static UINT8	buf[MU_MAX_BYTES];
+
+static void spend(UINT32 const num_bytes)
+{
+	sim_advance(SIM_NS_PER_CYCLES(SIM_MU_CYCLES_PER_WORD *
+				      COUNT_BUCKETS(num_bytes, sizeof(UINT32))));
+}
+
+static void check_size(UINT32 const num_bytes)
+{
+	if (num_bytes > MU_MAX_BYTES) {
+		fprintf(stderr, "sim: memory utility command of %u bytes\n",
+			num_bytes);
+		sim_halt();
+	}
+}
+
+static void mu_copy(void)
+{
+	check_size(size);
+	sim_mem_read(src_addr, buf, size);
+	sim_mem_write(dst_addr, buf, size);
+	spend(size);
+	result = 0;
+}
+
+static void mu_set(UINT32 const op)
+{
+	check_size(size);
+
+	UINT32 unit = op == MU_OP_SET_INCR_16 ? sizeof(UINT16) :
+		      op == MU_OP_SET_INCR_8  ? sizeof(UINT8)  : sizeof(UINT32);
+	UINT32 incr = op == MU_OP_SET_REPT ? 0 : 1;
+	UINT32 val  = value;
+	for (UINT32 i = 0; i < size; i += unit, val += incr) {
+		if (unit == sizeof(UINT32))
+			*(UINT32*)(buf + i) = val;
+		else if (unit == sizeof(UINT16))
+			*(UINT16*)(buf + i) = (UINT16)val;
+		else
+			buf[i] = (UINT8)val;
+	}
+	sim_mem_write(dst_addr, buf, size);
+	spend(size);
+	result = 0;
+}
+
+/* Index of the first bit of *value* in a bitmap of *size* bytes */
+static void mu_find(void)
+{
+	check_size(size);
+	sim_mem_read(src_addr, buf, size);
+	spend(size);
+
+	for (UINT32 i = 0; i < size * 8; i++) {
+		if (((buf[i / 8] >> (i % 8)) & 1) == value) {
+			result = i;
+			return;
+		}
+	}
+	result = size * 8;
+}
+
+static UINT32 item(UINT32 const i, UINT32 const unit, UINT32 const step)
+{
+	UINT8 const *p = buf + i * step;
+	if (unit == MU_UNIT_8)  return *p;
+	if (unit == MU_UNIT_16) return *(UINT16 const*)p;
+	return *(UINT32 const*)p;
+}
+
+/* Index of the first max, min or equal of *size* items; when no item is
+ * equal, the index is *size* */
+static void mu_search(UINT32 const op)
+{
+	UINT32 unit = unitstep & 0x300, step = unitstep & 0xFF;
+	UINT32 num_bytes = (size - 1) * step +
+			   (unit == MU_UNIT_8 ? 1 : unit == MU_UNIT_16 ? 2 : 4);
+	check_size(num_bytes);
+	sim_mem_read(src_addr, buf, num_bytes);
+	spend(num_bytes);
+
+	if (op == MU_OP_SEARCH_EQU) {
+		UINT32 val = unit == MU_UNIT_8  ? (UINT8)value :
+			     unit == MU_UNIT_16 ? (UINT16)value : value;
+		for (result = 0; result < size; result++)
+			if (item(result, unit, step) == val) return;
+		return;
+	}
+
+	result = 0;
+	for (UINT32 i = 1; i < size; i++) {
+		UINT32 x = item(i, unit, step), best = item(result, unit, step);
+		if (op == MU_OP_SEARCH_MAX ? x > best : x < best) result = i;
+	}
+}
+
+static void mu_exec(UINT32 const cmd)
+{
+	UINT32 op = MU_CMD_OP(cmd);
+
+	if (cmd == MU_CMD_COPY)
+		mu_copy();
+	else if (op == MU_OP_SET_REPT || op == MU_OP_SET_INCR_32 ||
+		 op == MU_OP_SET_INCR_16 || op == MU_OP_SET_INCR_8)
+		mu_set(op);
+	else if (op == MU_OP_FIND)
+		mu_find();
+	else if (op == MU_OP_SEARCH_MAX || op == MU_OP_SEARCH_MIN ||
+		 op == MU_OP_SEARCH_EQU)
+		mu_search(op);
+	else {
+		fprintf(stderr, "sim: unknown memory utility command 0x%x\n",
+			cmd);
+		sim_halt();
+	}
+}
+
+UINT32 sim_mu_getreg(UINT32 const addr)
+{
+	switch (addr) {
+	case MU_SRC_ADDR:	return src_addr;
+	case MU_DST_ADDR:	return dst_addr;
+	case MU_VALUE:		return value;
+	case MU_SIZE:		return size;
+	case MU_RESULT:		return result;
+	case MU_UNITSTEP:	return unitstep;
+	}
+	return 0;
+}
+
+void sim_mu_setreg(UINT32 const addr, UINT32 const val)
+{
+	switch (addr) {
+	case MU_SRC_ADDR:	src_addr = val;	break;
+	case MU_DST_ADDR:	dst_addr = val;	break;
+	case MU_VALUE:		value	 = val;	break;
+	case MU_SIZE:		size	 = val;	break;
+	case MU_UNITSTEP:	unitstep = val;	break;
+	case MU_CMD:
+		result = MU_RESULT_BUSY;
+		mu_exec(val);
+		break;
+	}
+}
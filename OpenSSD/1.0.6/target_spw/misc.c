@@ -52,6 +52,8 @@ void led_blink(void)
 volatile UINT32 g_barrier2;
 #endif
 
+// interrupts are never raised in the software model of the hardware
+#if OPTION_SIMULATION == 0
 #ifdef __GNUC__
 void swi_handler(void) __attribute__ ((interrupt ("SWI")));
 void swi_handler(void)
@@ -132,6 +134,7 @@ __irq void irq_handler(void)
 		}
 	}
 }
+#endif	// OPTION_SIMULATION == 0
 
 #include <stdlib.h>
 
@@ -58,10 +58,25 @@
 #define SRAM_BASE		0x10000000		// before remap
 #define ROM_BASE		0x10000000		// after remap
 
+#if OPTION_SIMULATION
+// registers are emulated by the software model of the hardware (see target_sim/sim.h)
+#include "sim.h"
+
+#define SETREG(ADDR, VAL)	sim_setreg((UINT32)(ADDR), (UINT32)(VAL))
+#define GETREG(ADDR)		sim_getreg((UINT32)(ADDR))
+
+#define HANG()			sim_halt()
+
+// SRAM of the model is the address space of the host process below DRAM
+#define SRAM_SIZE		DRAM_BASE
+#else
 #define SETREG(ADDR, VAL)	*(volatile UINT32*)(ADDR) = (UINT32)(VAL)
 #define GETREG(ADDR)		(*(volatile UINT32*)(ADDR))
 
+#define HANG()			while (1)
+
 #define SRAM_SIZE		(96*1024)
+#endif
 
 #if NAND_SPEC_SPEED == NAND_SPEC_VERY_FAST
 #define PS_PER_FLASH_CYCLE 	20000	// pico seconds
@@ -181,7 +196,7 @@ void disable_interrupt(void);
 		if (!(X))\
 		{\
 			uart_print("error: %u, %s", __LINE__, __FILE__);\
-			while (1);\
+			HANG();\
 		}\
 	}
 	/* #define ASSERT(X)\ */
@@ -1,11 +1,51 @@
 #include "profiler.h"
 #include "mem_util.h"
+#include "signal.h"
+#include "thread.h"
+
+/* ===========================================================================
+ * Clock
+ *
+ * Timer keeps running once started, so that subjects and threads can measure
+ * intervals by the difference of two readings. Wrapping around of the timer
+ * does no harm as long as an interval is shorter than the period (785s).
+ * =========================================================================*/
+
+#define PROFILER_TIMER		TIMER_CH3
+#define PROFILER_PRESCALE	TIMER_PRESCALE_1
+/* PRESCALE_TO_DIV takes the prescale before shifted */
+#define PROFILER_DIV		PRESCALE_TO_DIV(PROFILER_PRESCALE >> 2)
+
+/* the timer is started by flash tracer, if any (see fla.h) */
+static BOOL8 clock_started = OPTION_FLA_TRACE;
+
+static UINT32 now()
+{
+	return 0xFFFFFFFF - GET_TIMER_VALUE(PROFILER_TIMER);
+}
+
+static UINT32 ticks_to_us(UINT64 const ticks)
+{
+	return (UINT32)(ticks * 2 * 1000000 * PROFILER_DIV / CLOCK_SPEED);
+}
+
+/* ===========================================================================
+ * Subjects
+ * =========================================================================*/
 
 static UINT32 subject_time[NUM_PROFILER_SUBJECTS];
+static UINT32 subject_start[NUM_PROFILER_SUBJECTS];
+
+static void reset_phases();
 
 void profiler_init()
 {
+	if (!clock_started) {
+		start_interval_measurement(PROFILER_TIMER, PROFILER_PRESCALE);
+		clock_started = TRUE;
+	}
 	mem_set_sram(subject_time, 0, NUM_PROFILER_SUBJECTS * sizeof(UINT32));
+	reset_phases();
 }
 
 void profiler_reset		(profiler_subject_t const subject)
@@ -15,19 +55,211 @@ void profiler_reset		(profiler_subject_t const subject)
 
 void profiler_start_timer	(profiler_subject_t const subject)
 {
-	start_interval_measurement(TIMER_CH3, TIMER_PRESCALE_0);
+	subject_start[subject] = now();
 }
 
 void profiler_end_timer		(profiler_subject_t const subject)
 {
-	UINT32 rtime = 0xFFFFFFFF - GET_TIMER_VALUE(TIMER_CH3);
-	subject_time[subject] += rtime;
+	subject_time[subject] += now() - subject_start[subject];
 }
 
 UINT32 profiler_get_total_time	(profiler_subject_t const subject)
 {
-	
-	UINT32 rtime = subject_time[subject];
-	rtime = (UINT32)((UINT64)rtime * 2 * 1000000 * PRESCALE_TO_DIV(TIMER_PRESCALE_0) / CLOCK_SPEED);
-	return rtime;
+	return ticks_to_us(subject_time[subject]);
+}
+
+/* ===========================================================================
+ * Phases of threads
+ * =========================================================================*/
+
+#define MAX_PROFILED_HANDLERS	8
+#define MAX_PROFILED_PHASES	10
+
+/* sleep durations are bucketed by powers of 4 ticks */
+#define NUM_SLEEP_BUCKETS	16
+#define sleep_bucket(ticks)	((ticks) ? (31 - __builtin_clz(ticks)) / 2 : 0)
+
+typedef enum {
+	WAKEUP_BY_BANK,
+	WAKEUP_BY_PMT_LOADED,
+	WAKEUP_BY_LOCK_RELEASED,
+	WAKEUP_BY_OTHERS,
+	NUM_WAKEUP_REASONS
+} wakeup_reason_t;
+
+static char const * const wakeup_reason_names[NUM_WAKEUP_REASONS] = {
+	"bank", "pmt", "lock", "others"
+};
+
+typedef struct {
+	char const	*name;
+	UINT32		num_entries;
+	UINT32		run_ticks;
+	UINT32		sleep_ticks;
+	UINT32		num_sleeps;
+	UINT32		num_wakeups[NUM_WAKEUP_REASONS];
+	UINT32		sleep_hist[NUM_SLEEP_BUCKETS];
+} phase_stat_t;
+
+typedef struct {
+	char const	*name;
+	phase_stat_t	phases[MAX_PROFILED_PHASES];
+} handler_stat_t;
+
+/* what a thread is doing since when */
+typedef struct {
+	UINT32		since;
+	UINT8		phase;
+	BOOL8		sleeping;
+	BOOL8		marked;
+	/* profiling starts in the middle of the phase of the thread */
+	BOOL8		adopting;
+} thread_mark_t;
+
+static handler_stat_t	handler_stats[MAX_PROFILED_HANDLERS];
+static thread_mark_t	thread_marks[MAX_NUM_THREADS];
+
+static void reset_phases()
+{
+	mem_set_sram(handler_stats, 0, sizeof(handler_stats));
+	mem_set_sram(thread_marks, 0, sizeof(thread_marks));
+}
+
+static phase_stat_t *phase_stat(UINT8 const handler_id, UINT8 const phase)
+{
+	if (handler_id >= MAX_PROFILED_HANDLERS ||
+	    phase >= MAX_PROFILED_PHASES) return NULL;
+	return &handler_stats[handler_id].phases[phase];
+}
+
+static wakeup_reason_t wakeup_reason(UINT32 const wakeup_signals)
+{
+	extern signals_t g_scheduler_signals;
+	signals_t signals = wakeup_signals & g_scheduler_signals;
+
+	if (signals & SIG_ALL_BANKS)	 return WAKEUP_BY_BANK;
+	if (signals & SIG_PMT_LOADED)	 return WAKEUP_BY_PMT_LOADED;
+	if (signals & SIG_LOCK_RELEASED) return WAKEUP_BY_LOCK_RELEASED;
+	return WAKEUP_BY_OTHERS;
+}
+
+/* Charge the time since the last mark of a thread to its phase */
+static UINT32 charge(UINT8 const tid, UINT8 const handler_id)
+{
+	thread_mark_t *mark = &thread_marks[tid];
+	UINT32 time   = now();
+	UINT32 ticks  = time - mark->since;
+	mark->since   = time;
+	if (!mark->marked) {
+		mark->marked = TRUE;
+		return 0;
+	}
+
+	phase_stat_t *stat = phase_stat(handler_id, mark->phase);
+	if (stat == NULL) return ticks;
+	if (mark->sleeping)
+		stat->sleep_ticks += ticks;
+	else
+		stat->run_ticks += ticks;
+	return ticks;
+}
+
+void profiler_thread_resume	(UINT8 const tid, UINT8 const handler_id,
+				 UINT32 const wakeup_signals,
+				 BOOL8 const started)
+{
+	thread_mark_t *mark = &thread_marks[tid];
+	BOOL8 was_marked    = mark->marked;
+	UINT32 ticks	    = charge(tid, handler_id);
+	if (!was_marked) {
+		mark->sleeping = FALSE;
+		mark->adopting = started;
+		return;
+	}
+	if (!mark->sleeping) return;
+
+	mark->sleeping = FALSE;
+	phase_stat_t *stat = phase_stat(handler_id, mark->phase);
+	if (stat == NULL) return;
+	stat->num_sleeps++;
+	stat->sleep_hist[sleep_bucket(ticks)]++;
+	stat->num_wakeups[wakeup_reason(wakeup_signals)]++;
+}
+
+void profiler_thread_phase	(UINT8 const tid, UINT8 const handler_id,
+				 UINT8 const phase, char const *name,
+				 char const *handler_name)
+{
+	thread_mark_t *mark = &thread_marks[tid];
+	phase_stat_t *stat  = phase_stat(handler_id, phase);
+	if (mark->adopting) {
+		mark->adopting = FALSE;
+		mark->phase    = phase;
+	}
+	/* resuming in the same phase is not an entry */
+	if (mark->marked && mark->phase == phase) {
+		if (stat && stat->name == NULL) {
+			handler_stats[handler_id].name = handler_name;
+			stat->name = name;
+		}
+		return;
+	}
+
+	charge(tid, handler_id);
+	mark->phase = phase;
+
+	if (stat == NULL) return;
+	handler_stats[handler_id].name = handler_name;
+	stat->name = name;
+	stat->num_entries++;
+}
+
+void profiler_thread_switch	(UINT8 const tid, UINT8 const handler_id,
+				 UINT8 const state)
+{
+	charge(tid, handler_id);
+	thread_marks[tid].sleeping = state == THREAD_SLEEPING;
+	/* the next thread of the same id starts afresh */
+	if (state == THREAD_STOPPED) thread_marks[tid].marked = FALSE;
+}
+
+void profiler_report_phases()
+{
+	for (UINT8 h = 0; h < MAX_PROFILED_HANDLERS; h++) {
+		handler_stat_t *handler = &handler_stats[h];
+		if (handler->name == NULL) continue;
+
+		/* name of a handler is its file */
+		char const *name = handler->name;
+		for (char const *c = handler->name; *c; c++)
+			if (*c == '/') name = c + 1;
+		uart_print("> phases of %s:", name);
+		for (UINT8 p = 0; p < MAX_PROFILED_PHASES; p++) {
+			phase_stat_t *stat = &handler->phases[p];
+			if (stat->name == NULL) continue;
+
+			uart_print(">   %s: %u entries, run %uus, "
+				   "sleep %uus in %u sleeps",
+				   stat->name, stat->num_entries,
+				   ticks_to_us(stat->run_ticks),
+				   ticks_to_us(stat->sleep_ticks),
+				   stat->num_sleeps);
+			if (stat->num_sleeps == 0) continue;
+
+			uart_printf(">     woken up by");
+			for (UINT8 r = 0; r < NUM_WAKEUP_REASONS; r++) {
+				if (stat->num_wakeups[r] == 0) continue;
+				uart_printf(" %s %u", wakeup_reason_names[r],
+					    stat->num_wakeups[r]);
+			}
+			uart_printf("\r\n>     sleeps under (us)");
+			for (UINT8 b = 0; b < NUM_SLEEP_BUCKETS; b++) {
+				if (stat->sleep_hist[b] == 0) continue;
+				uart_printf(" %u: %u",
+					    ticks_to_us((UINT64)4 << (2 * b)),
+					    stat->sleep_hist[b]);
+			}
+			uart_printf("\r\n");
+		}
+	}
 }
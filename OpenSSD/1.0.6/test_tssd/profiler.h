@@ -14,5 +14,24 @@ void profiler_start_timer	(profiler_subject_t const subject);
 void profiler_end_timer		(profiler_subject_t const subject);
 UINT32 profiler_get_total_time	(profiler_subject_t const subject);
 
+/*
+ * Phases of threads
+ *
+ * The phase machine of thread handlers (see thread_handler_util.h) reports
+ * when a thread enters a phase, leaves the CPU by sleep(), run_later() or
+ * end(), and resumes. For every phase of every handler, the profiler
+ * accumulates the time threads are runnable and sleeping, a histogram of
+ * sleep durations and the signals that wake them up.
+ * */
+void profiler_thread_resume	(UINT8 const tid, UINT8 const handler_id,
+				 UINT32 const wakeup_signals,
+				 BOOL8 const started);
+void profiler_thread_phase	(UINT8 const tid, UINT8 const handler_id,
+				 UINT8 const phase, char const *name,
+				 char const *handler_name);
+void profiler_thread_switch	(UINT8 const tid, UINT8 const handler_id,
+				 UINT8 const state);
+void profiler_report_phases();
+
 #endif
 #endif
@@ -0,0 +1,340 @@
+/* ===========================================================================
+ * Benchmark FTL with a suite of synthetic workloads
+ *
+ * A workload is sequential or random commands of a fixed size over the first
+ * *footprint* MB of the disk, mixed of reads and writes by *read_percent*.
+ * Offsets of random workloads are uniform or, if *zipf_percent* is not 0,
+ * follow a Zipf-like distribution of skew *zipf_percent* / 100. With ACL,
+ * commands can be spread over *num_users* users, each of which opens a
+ * session and works on its own slice of the footprint. Commands arrive as
+ * fast as *queue_depth* allows or, if *iops* is not 0, at that rate, which
+ * leaves the FTL idle between them.
+ *
+ * The footprint is written before a workload that reads, which is not
+ * measured. Every workload prints a 'result' line (see test_workload_common.h)
+ * to be compared against the baselines by test/util/bench.py.
+ *
+ * A footprint of 0 is the whole disk, which is written before the workload
+ * even if it only writes, so that GC runs from the first command on and the
+ * workload measures the steady state. Filling up a full-size disk takes too
+ * long, so such workloads are only run when selected by name, on a build of
+ * a reduced disk (see bench.py).
+ *
+ * On the host build (build_sim), environment variable BENCH selects one
+ * workload by name and BENCH_<FIELD> (e.g. BENCH_QUEUE_DEPTH) overrides a
+ * field of the selected workloads.
+ *
+ * With FDE, a master key is given before the first workload, so that all of
+ * them run with encryption on; BENCH_FDE=0 runs them with FDE off instead,
+ * e.g. 'bench.py --set fde=0', to measure the cost of FDE against the
+ * baselines. FDE cannot be turned on or off once data is written.
+ * =========================================================================*/
+#include "jasmine.h"
+#if OPTION_FTL_TEST
+#include "test_workload_common.h"
+#if OPTION_ACL
+#include "acl.h"
+#endif
+#if OPTION_FDE
+#include "fde.h"
+#endif
+#if OPTION_SIMULATION
+#include <string.h>
+#endif
+
+/* Data is not checked, so there is nothing to verify */
+void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
+		UINT8 const num_sectors, UINT32 const sata_rd_buf)
+{
+}
+
+typedef struct {
+	char const	*name;
+	BOOL8		random;
+	UINT32		read_percent;
+	UINT32		io_sectors;
+	UINT32		queue_depth;
+	UINT32		footprint_mb;	/* 0 - whole disk */
+	UINT32		zipf_percent;	/* 0 - uniform */
+	UINT32		num_users;	/* 0 - default user */
+	UINT32		iops;		/* 0 - unlimited */
+	UINT32		num_cmds;
+} workload_t;
+
+static workload_t const workloads[] = {
+	/* name			rand	rd%	size	qd	MB	zipf	users	iops	cmds */
+	{"seq_write_128k",	FALSE,	0,	256,	4,	256,	0,	0,	0,	2048},
+	{"seq_read_128k",	FALSE,	100,	256,	4,	256,	0,	0,	0,	2048},
+	{"seq_write_4k_qd1",	FALSE,	0,	8,	1,	256,	0,	0,	0,	8192},
+	{"seq_write_4k_2k",	FALSE,	0,	8,	1,	256,	0,	0,	2000,	4096},
+	{"rand_write_4k",	TRUE,	0,	8,	32,	256,	0,	0,	0,	32768},
+	{"rand_read_4k",	TRUE,	100,	8,	32,	256,	0,	0,	0,	32768},
+	{"mixed_70r_4k",	TRUE,	70,	8,	32,	256,	0,	0,	0,	32768},
+	{"zipf_90_4k",		TRUE,	70,	8,	32,	256,	90,	0,	0,	32768},
+	{"acl_4users_4k",	TRUE,	70,	8,	32,	256,	0,	4,	0,	32768},
+	{"steady_write_4k",	TRUE,	0,	8,	32,	0,	0,	0,	0,	65536},
+};
+#define NUM_WORKLOADS		(sizeof(workloads) / sizeof(workloads[0]))
+
+#define DISK_MB			(NUM_LSECTORS / (MB / BYTES_PER_SECTOR))
+
+#define PREFILL_SECTORS		256
+#define PREFILL_QUEUE_DEPTH	8
+/* session keys of users are SKEY_BASE + user index */
+#define SKEY_BASE		0x5E550000
+
+/* ===========================================================================
+ *  Zipf
+ *
+ *  Ranks follow the density x^-s over [1, N + 1), of which the inverse CDF
+ *  is x = (1 + u * ((N + 1)^(1 - s) - 1))^(1 / (1 - s)) for u uniform in
+ *  [0, 1). This approximates Zipf of skew s < 1 without a table of N
+ *  entries. Ranks are scattered over the footprint by multiplying with a
+ *  prime, so that hot offsets are not clustered. Powers are computed in
+ *  fixed point through log2 and exp2, for there is no libm on the firmware.
+ * =========================================================================*/
+
+/* log2(x) in 16.16 fixed point */
+static UINT32 log2_q16(UINT64 const x)
+{
+	UINT32 msb    = 63 - __builtin_clzll(x);
+	UINT32 result = msb << 16;
+	/* mantissa in [1, 2) as 1.31 fixed point */
+	UINT64 m      = msb > 31 ? x >> (msb - 31) : x << (31 - msb);
+	for (UINT32 bit = 1 << 15; bit; bit >>= 1) {
+		m = (m * m) >> 31;
+		if (m >= (2ULL << 31)) {
+			m >>= 1;
+			result += bit;
+		}
+	}
+	return result;
+}
+
+/* 2^(-2^-i) for i = 1, 2, ... in 2.30 fixed point */
+static UINT32 const exp2_neg_frac_q30[16] = {
+	0x2D413CCD, 0x35D13F33, 0x3AB031BA, 0x3D495F45,
+	0x3EA0ECB7, 0x3F4F8303, 0x3FA78457, 0x3FD3B2D6,
+	0x3FE9D595, 0x3FF4E9D4, 0x3FFA74AD, 0x3FFD3A47,
+	0x3FFE9D20, 0x3FFF4E8F, 0x3FFFA747, 0x3FFFD3A4
+};
+
+/* 2^(e / 2^16) in 16.16 fixed point for e < 32 * 2^16 */
+static UINT64 exp2_q16(UINT32 const e)
+{
+	UINT32 n = e >> 16, f = e & 0xFFFF;
+	if (f == 0) return 1ULL << (16 + n);
+
+	/* 2^f = 2 * 2^-(1 - f) */
+	UINT64 r = 1 << 30;
+	for (UINT32 i = 0; i < 16; i++)
+		if ((0x10000 - f) & (1 << (15 - i)))
+			r = (r * exp2_neg_frac_q30[i]) >> 30;
+	return (r << (n + 1)) >> 14;
+}
+
+/* (N + 1)^(1 - s) in 16.16 fixed point, fixed for a workload */
+static UINT64 zipf_max_q16;
+
+static void zipf_init(UINT32 const n, UINT32 const zipf_percent)
+{
+	zipf_max_q16 = exp2_q16((UINT64)log2_q16(n + 1) *
+				(100 - zipf_percent) / 100);
+}
+
+static UINT32 zipf_next(UINT32 const n, UINT32 const zipf_percent)
+{
+	UINT64 u    = rand() & 0xFFFF;
+	UINT64 y    = (1 << 16) + ((u * (zipf_max_q16 - (1 << 16))) >> 16);
+	UINT32 e    = (UINT32)((UINT64)(log2_q16(y) - (16 << 16)) * 100 /
+			       (100 - zipf_percent));
+	UINT32 x    = (UINT32)(exp2_q16(e) >> 16);
+	UINT32 rank = MIN(MAX(x, 1), n) - 1;
+	return (UINT32)((UINT64)rank * 2654435761u % n);
+}
+
+/* ===========================================================================
+ *  Workloads
+ * =========================================================================*/
+
+static workload_t	wl;
+static UINT32		num_slots;	/* of io_sectors in a user's slice */
+static UINT32		next_slot[2];	/* of sequential READ and WRITE */
+static UINT32		num_cmds_left;
+
+static BOOL8 bench_next(UINT32 *lba, UINT32 *num_sectors, UINT32 *cmd_type,
+			UINT32 *session_key)
+{
+	if (num_cmds_left == 0) return FALSE;
+	num_cmds_left--;
+
+	*cmd_type = random(0, 99) < wl.read_percent ? READ : WRITE;
+
+	UINT32 user = wl.num_users ? random(0, wl.num_users - 1) : 0;
+	UINT32 slot;
+	if (!wl.random) {
+		slot = next_slot[*cmd_type];
+		next_slot[*cmd_type] = (slot + 1) % num_slots;
+	}
+	else if (wl.zipf_percent)
+		slot = zipf_next(num_slots, wl.zipf_percent);
+	else
+		slot = random(0, num_slots - 1);
+
+	*num_sectors = wl.io_sectors;
+	*lba	     = (user * num_slots + slot) * wl.io_sectors;
+	*session_key = wl.num_users ? SKEY_BASE + user : 0;
+	return TRUE;
+}
+
+/* the footprint that has been written and by how many users */
+static UINT32 prefilled_mb, prefilled_users;
+static UINT32 prefill_lba, prefill_end;
+
+static BOOL8 prefill_next(UINT32 *lba, UINT32 *num_sectors, UINT32 *cmd_type,
+			  UINT32 *session_key)
+{
+	if (prefill_lba >= prefill_end) return FALSE;
+
+	*lba	     = prefill_lba;
+	*num_sectors = MIN(PREFILL_SECTORS, prefill_end - prefill_lba);
+	*cmd_type    = WRITE;
+	/* every user writes its own slice */
+	UINT32 user  = prefill_lba / (num_slots * wl.io_sectors);
+	*session_key = wl.num_users ? SKEY_BASE + user : 0;
+	prefill_lba += *num_sectors;
+	return TRUE;
+}
+
+static void prefill(BOOL8 const whole_disk)
+{
+	if (wl.read_percent == 0 && !whole_disk) return;
+	if (prefilled_mb >= wl.footprint_mb &&
+	    prefilled_users == wl.num_users) return;
+
+	uart_print("prefill %uMB", wl.footprint_mb);
+	prefill_lba = 0;
+	prefill_end = MAX(wl.num_users, 1) * num_slots * wl.io_sectors;
+	workload_run(prefill_next, PREFILL_QUEUE_DEPTH, 0);
+
+	prefilled_mb	= wl.footprint_mb;
+	prefilled_users = wl.num_users;
+}
+
+#if OPTION_ACL
+static void open_sessions()
+{
+	for (UINT32 user = 0; user < wl.num_users; user++)
+		BUG_ON("failed to open session",
+		       !acl_open_session(SKEY_BASE + user,
+					 (user_id_t)(user + 1)));
+}
+
+static void close_sessions()
+{
+	for (UINT32 user = 0; user < wl.num_users; user++)
+		acl_close_session(SKEY_BASE + user);
+}
+#else
+#define open_sessions()
+#define close_sessions()
+#endif
+
+static void load_workload(workload_t const *w)
+{
+	wl = *w;
+#define override(field, name)	\
+		wl.field = test_param("BENCH_" name, wl.field)
+	override(random,	"RANDOM");
+	override(read_percent,	"READ_PERCENT");
+	override(io_sectors,	"IO_SECTORS");
+	override(queue_depth,	"QUEUE_DEPTH");
+	override(footprint_mb,	"FOOTPRINT_MB");
+	override(zipf_percent,	"ZIPF_PERCENT");
+	override(num_users,	"USERS");
+	override(iops,		"IOPS");
+	override(num_cmds,	"NUM_CMDS");
+#undef override
+
+	wl.read_percent = MIN(wl.read_percent, 100);
+	wl.io_sectors	= MIN(MAX(wl.io_sectors, 1), 65536);
+	wl.footprint_mb = wl.footprint_mb == 0 ? DISK_MB :
+			  MIN(wl.footprint_mb, DISK_MB);
+	wl.zipf_percent = MIN(wl.zipf_percent, 99);
+#if OPTION_ACL
+	wl.num_users	= MIN(wl.num_users,
+			      MIN(ACL_MAX_SESSIONS, ACL_MAX_USERS - 1));
+#else
+	wl.num_users	= 0;
+#endif
+}
+
+static void run_workload(workload_t const *w)
+{
+	load_workload(w);
+	uart_print("-------------------- %s --------------------", wl.name);
+	uart_print("%s, read %u%%, %u sectors, queue depth %u, footprint %uMB, "
+		   "zipf %u%%, %u users, %u IOPS, %u cmds",
+		   wl.random ? "random" : "sequential", wl.read_percent,
+		   wl.io_sectors, wl.queue_depth, wl.footprint_mb,
+		   wl.zipf_percent, wl.num_users, wl.iops, wl.num_cmds);
+
+	UINT32 footprint_sectors = wl.footprint_mb * (MB / BYTES_PER_SECTOR);
+	num_slots = MAX(footprint_sectors / MAX(wl.num_users, 1) /
+			wl.io_sectors, 1);
+	next_slot[READ] = next_slot[WRITE] = 0;
+	if (wl.zipf_percent) zipf_init(num_slots, wl.zipf_percent);
+
+	/* same commands every run */
+	srand(RAND_SEED);
+	open_sessions();
+	prefill(w->footprint_mb == 0);
+
+	num_cmds_left = wl.num_cmds;
+	workload_run(bench_next, wl.queue_depth, wl.iops);
+	close_sessions();
+
+	workload_report();
+	workload_report_result(wl.name);
+}
+
+#if OPTION_FDE
+static void set_bench_fde_key()
+{
+	if (test_param("BENCH_FDE", TRUE))
+		set_fde_key();
+	else
+		uart_print("FDE is off");
+}
+#else
+#define set_bench_fde_key()
+#endif
+
+static BOOL8 is_selected(workload_t const *w)
+{
+#if OPTION_SIMULATION
+	char const *name = getenv("BENCH");
+	if (name == NULL) return w->footprint_mb != 0;
+	return strcmp(name, w->name) == 0;
+#else
+	return w->footprint_mb != 0;
+#endif
+}
+
+void ftl_test()
+{
+	uart_print("Start benchmark");
+	set_bench_fde_key();
+
+	BOOL8 found = FALSE;
+	for (UINT32 i = 0; i < NUM_WORKLOADS; i++) {
+		if (!is_selected(&workloads[i])) continue;
+		run_workload(&workloads[i]);
+		found = TRUE;
+	}
+	BUG_ON("no such workload", !found);
+
+	uart_print("FTL passed unit test ^_^");
+}
+
+#endif
@@ -6,17 +6,58 @@
 #if OPTION_FTL_TEST
 #if OPTION_FDE
 #include "fde.h"
-#include "test_util.h"
+#include "test_ftl_rw_common.h"
+#include "write_buffer.h"
 #include "mem_util.h"
-#include "dram.h"
-#include "stdlib.h"
-
-#define RAND_SEED	123456
 #define NUM_TRIALS	32
 
 #define ENCRYPTED_BUF	COPY_BUF(0)
 #define PLAINTEXT_BUF 	COPY_BUF(1)
 
+/* Sectors in [written_lba, written_lba_end) hold their LBAs and the others
+ * are never written */
+static UINT32 written_lba, written_lba_end, num_verified_sectors;
+
+void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
+		UINT8 const num_sectors, UINT32 const sata_rd_buf)
+{
+	for (UINT8 sect_i = sect_offset; sect_i < sect_offset + num_sectors;
+	     sect_i++) {
+		UINT32 lba = lpn * SECTORS_PER_PAGE + sect_i;
+		UINT32 expected_sect_val =
+			lba >= written_lba && lba < written_lba_end ?
+				lba : 0xFFFFFFFF;
+		BUG_ON("Verification failed",
+		       is_buff_wrong(sata_rd_buf, expected_sect_val,
+				     sect_i, 1));
+		num_verified_sectors++;
+	}
+}
+
+/* XTS-AES-128 test vector 4 of IEEE P1619, i.e. a sector of bytes 0x00 to
+ * 0xFF repeated as LSN 0, and the same sector as LSN 1 (as computed by
+ * OpenSSL). The first and the last 16 bytes of ciphertext are checked. */
+static UINT8 const kat_key[32] = {
+	0x27, 0x18, 0x28, 0x18, 0x28, 0x45, 0x90, 0x45,
+	0x23, 0x53, 0x60, 0x28, 0x74, 0x71, 0x35, 0x26,
+	0x31, 0x41, 0x59, 0x26, 0x53, 0x58, 0x97, 0x93,
+	0x23, 0x84, 0x62, 0x64, 0x33, 0x83, 0x27, 0x95
+};
+#define KAT_NUM_SECTORS		2
+#define KAT_CHECK_BYTES		16
+static UINT8 const kat_head[KAT_NUM_SECTORS][KAT_CHECK_BYTES] = {
+	{0x27, 0xa7, 0x47, 0x9b, 0xef, 0xa1, 0xd4, 0x76,
+	 0x48, 0x9f, 0x30, 0x8c, 0xd4, 0xcf, 0xa6, 0xe2},
+	{0xbb, 0xf9, 0xd6, 0xa7, 0x4a, 0x74, 0x65, 0xfe,
+	 0xe2, 0x0f, 0x42, 0xad, 0xf9, 0xa6, 0x23, 0xfc}
+};
+static UINT8 const kat_tail[KAT_NUM_SECTORS][KAT_CHECK_BYTES] = {
+	{0x0a, 0x28, 0x2d, 0xf9, 0x20, 0x14, 0x7b, 0xea,
+	 0xbe, 0x42, 0x1e, 0xe5, 0x31, 0x9d, 0x05, 0x68},
+	{0x9b, 0x1c, 0x84, 0xa5, 0x2a, 0x6a, 0x5d, 0xc0,
+	 0x65, 0xdb, 0x24, 0x96, 0xfc, 0x4e, 0x84, 0xcb}
+};
+
 static void fill_buffer_randomly(UINT32 const buf, UINT8 const num_sectors)
 {
 	UINT32 addr = buf, addr_end = buf + num_sectors * BYTES_PER_SECTOR;
@@ -41,10 +82,86 @@ static void copy_buffer(UINT32 const target_buf,
 	mem_copy(target_buf, src_buf, num_sectors * BYTES_PER_SECTOR);
 }
 
+static BOOL8 is_bytes_same(UINT32 const addr, UINT8 const *bytes,
+			   UINT32 const num_bytes)
+{
+	for (UINT32 i = 0; i < num_bytes; i++)
+		if (read_dram_8(addr + i) != bytes[i]) return FALSE;
+	return TRUE;
+}
+
+static void test_known_answer()
+{
+	fde_key_t key;
+	for (UINT32 i = 0; i < sizeof(key.key); i++) key.key[i] = kat_key[i];
+
+	for (UINT32 i = 0; i < KAT_NUM_SECTORS * BYTES_PER_SECTOR; i++)
+		write_dram_8(PLAINTEXT_BUF + i, (UINT8)i);
+	copy_buffer(ENCRYPTED_BUF, PLAINTEXT_BUF, KAT_NUM_SECTORS);
+
+	fde_encrypt(ENCRYPTED_BUF, KAT_NUM_SECTORS, key);
+	for (UINT32 sect_i = 0; sect_i < KAT_NUM_SECTORS; sect_i++) {
+		UINT32 sector = ENCRYPTED_BUF + sect_i * BYTES_PER_SECTOR;
+		BUG_ON("ciphertext differs from the test vector",
+		       !is_bytes_same(sector, kat_head[sect_i],
+				      KAT_CHECK_BYTES) ||
+		       !is_bytes_same(sector + BYTES_PER_SECTOR -
+				      KAT_CHECK_BYTES, kat_tail[sect_i],
+				      KAT_CHECK_BYTES));
+	}
+
+	fde_decrypt(ENCRYPTED_BUF, KAT_NUM_SECTORS, key);
+	BUG_ON("decrypted text differs from the test vector",
+	       !is_buffer_same(ENCRYPTED_BUF, PLAINTEXT_BUF, KAT_NUM_SECTORS));
+}
+
+/* Write some sectors into a sub-page that has never been written, so that the
+ * rest of it is filled with 0xFFs, and read the whole sub-page from flash */
+static void test_data_path()
+{
+	set_fde_key();
+	BUG_ON("FDE should be on", !fde_is_enabled());
+
+	written_lba	= 2;
+	written_lba_end	= 5;
+	UINT32 sata_buf = SATA_WR_BUF_PTR(0);
+	for (UINT32 lba = written_lba; lba < written_lba_end; lba++)
+		mem_set_dram(sata_buf + lba * BYTES_PER_SECTOR, lba,
+			     BYTES_PER_SECTOR);
+	while (eventq_put(written_lba, written_lba_end - written_lba,
+#if OPTION_ACL
+			  0,
+#endif
+			  WRITE))
+		ftl_main();
+	/* the write buffer is drained when the host is idle */
+	do {
+		ftl_main();
+	} while (write_buffer_num_used_buffers() > 0);
+	finish_all();
+
+	num_verified_sectors = 0;
+	while (eventq_put(0, SECTORS_PER_SUB_PAGE,
+#if OPTION_ACL
+			  0,
+#endif
+			  READ))
+		ftl_main();
+	finish_all();
+	BUG_ON("not all sectors are read",
+	       num_verified_sectors != SECTORS_PER_SUB_PAGE);
+
+	BUG_ON("FDE key should not be changeable once data is written",
+	       fde_set_master_key(&(fde_key_t){{0}}));
+}
+
 void ftl_test()
 {
 	uart_print("Start testing FDE...");
 
+	test_known_answer();
+	test_data_path();
+
 	UINT8 trial_i;
 	for (trial_i = 0; trial_i < NUM_TRIALS; trial_i++) {
 		UINT8 num_sectors = random(1, SECTORS_PER_PAGE);
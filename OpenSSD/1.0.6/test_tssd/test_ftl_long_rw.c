@@ -123,6 +123,7 @@ void do_long_rw_test(rw_case_t *rw_case)
 {
 	UINT32  total_sectors = 0;
 	timer_reset();
+	waf_monitor_reset();
 
 	rw_case->read_percent = MIN(rw_case->read_percent, 100);
 
@@ -186,11 +187,16 @@ next:
 	uart_print("Done.");
 	uart_print("Summary: %u seconds used; %u MB data written and read.",
 			seconds, mb);
+	waf_monitor_report();
 }
 
 void ftl_test()
 {
 	uart_print("Start FTL long r/w test");
+#if OPTION_FDE
+	/* data is verified through encryption */
+	set_fde_key();
+#endif
 
 	declare_rw_case(rw_case);
 	rw_case.min_req_size = 8;
@@ -136,6 +136,7 @@ void do_rnd_rw_test(rw_case_t *rw_case)
 {
 	UINT32  total_sectors = 0;
 	timer_reset();
+	waf_monitor_reset();
 
 	uart_print("random r/w range: from sector 0 to sector %u, a total of %uMB",
 			BUF_SIZE - 1, BUF_SIZE / 2048);
@@ -183,11 +184,16 @@ void do_rnd_rw_test(rw_case_t *rw_case)
 	uart_print("Done.");
 	uart_print("Summary: %u seconds used; %u MB data written and read.",
 			seconds, mb);
+	waf_monitor_report();
 }
 
 void ftl_test()
 {
 	uart_print("Start FTL rnd r/w test");
+#if OPTION_FDE
+	/* data is verified through encryption */
+	set_fde_key();
+#endif
 
 	srand(RAND_SEED);
 	init_sector_val_buf(0xFFFFFFFF);
@@ -130,6 +130,7 @@ void do_seq_rw_test(rw_case_t *rw_case)
 {
 	UINT32  total_sectors = 0;
 	timer_reset();
+	waf_monitor_reset();
 
 	rw_case->read_percent = MIN(rw_case->read_percent, 100);
 	rw_case->max_num_reqs = MIN(rw_case->max_num_reqs, MAX_NUM_REQS);
@@ -182,11 +183,16 @@ void do_seq_rw_test(rw_case_t *rw_case)
 	uart_print("Done.");
 	uart_print("Summary: %u seconds used; %u MB data written and read.",
 			seconds, mb);
+	waf_monitor_report();
 }
 
 void ftl_test()
 {
 	uart_print("Start FTL seq r/w test");
+#if OPTION_FDE
+	/* data is verified through encryption */
+	set_fde_key();
+#endif
 
 	srand(RAND_SEED);
 	init_req_lba_buf(0);
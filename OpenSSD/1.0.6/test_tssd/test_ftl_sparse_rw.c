@@ -129,6 +129,7 @@ void do_sparse_rw_test(rw_case_t *rw_case)
 {
 	UINT32  total_sectors = 0;
 	timer_reset();
+	waf_monitor_reset();
 
 	rw_case->max_lba = MAX_LBA;
 	rw_case->max_num_reqs = MIN(rw_case->max_num_reqs, MAX_NUM_REQS);
@@ -177,11 +178,16 @@ void do_sparse_rw_test(rw_case_t *rw_case)
 	uart_print("Done.");
 	uart_print("Summary: %u seconds used; %u MB data written and read.",
 			seconds, mb);
+	waf_monitor_report();
 }
 
 void ftl_test()
 {
 	uart_print("Start FTL sparse r/w test");
+#if OPTION_FDE
+	/* data is verified through encryption */
+	set_fde_key();
+#endif
 
 	srand(RAND_SEED);
 	init_req_lba_buf(0);
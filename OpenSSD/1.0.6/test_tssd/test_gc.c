@@ -4,8 +4,11 @@
 #include "jasmine.h"
 #if OPTION_FTL_TEST
 #include "dram.h"
+#include "ftl.h"
 #include "gc.h"
 #include "bad_blocks.h"
+#include "buffer.h"
+#include "mem_util.h"
 #include "test_util.h"
 #include <stdlib.h>
 
@@ -17,6 +20,48 @@ SETUP_BUF(usage,	USAGE_BUF_ADDR,		SECTORS_PER_PAGE);
 
 #define MAX_VBLK	(BYTES_PER_PAGE / sizeof(UINT32))
 
+#if OPTION_FTL_VERIFY
+/* No data is read */
+void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
+		UINT8 const num_sectors, UINT32 const sata_rd_buf)
+{
+}
+#endif
+
+/* a key tells the stream and the place of a sub-page in block */
+#define test_key(stream, page, sp_i)	\
+		(((stream) * PAGES_PER_VBLK + (page)) * SUB_PAGES_PER_PAGE + (sp_i))
+
+static void check_summaries(UINT8 const bank, UINT32 const num_blocks,
+			    UINT32 const last_vpn[GC_NUM_STREAMS])
+{
+	UINT8	buf_id = buffer_allocate();
+	UINT32	summary_buf = MANAGED_BUF(buf_id);
+
+	for (UINT32 vblk = 0; vblk < num_blocks; vblk++) {
+		if (get_usage(vblk) == 0xFFFFFFFF) continue;
+
+		/* skip active blocks */
+		UINT8 stream = get_usage(vblk);
+		if (last_vpn[stream] / PAGES_PER_VBLK == vblk &&
+		    last_vpn[stream] % PAGES_PER_VBLK != GC_DATA_PAGES_PER_VBLK - 1)
+			continue;
+
+		nand_page_ptread(bank, vblk, GC_SUMMARY_PAGE, 0,
+				 GC_SUMMARY_SECTORS, summary_buf,
+				 RETURN_WHEN_DONE);
+		for (UINT32 page = 0; page < GC_DATA_PAGES_PER_VBLK; page++) {
+			for_each_subpage(sp_i) {
+				BUG_ON("wrong key in block summary",
+					gc_summary_key(summary_buf, page, sp_i)
+						!= test_key(stream, page, sp_i));
+			}
+		}
+	}
+
+	buffer_free(buf_id);
+}
+
 void ftl_test(void)
 {
 	INFO("test", "start testing garbage collector");
@@ -29,33 +74,66 @@ void ftl_test(void)
 		uart_printf("start testing gc for bank %d...", bank);
 
 		init_usage_buf(0xFFFFFFFF);
-		UINT32	last_vpn[2] = {0, 0};
+		UINT32	last_vpn[GC_NUM_STREAMS] = {0};
+		/* dynamic wear leveling takes the youngest erased block, or the
+		 * oldest one for relocation stream; as dirty blocks are erased
+		 * from the youngest, no block erased later is younger */
+		UINT32	min_ec = 0;
 		UINT32 	vblk = 0;
 		while (vblk < num_blocks_to_test) {
-			BOOL8	is_sys 	= rand() % 2;
-			UINT32	vpn	= gc_allocate_new_vpn(bank, is_sys);
-		
+			UINT8	stream 	= rand() % GC_NUM_STREAMS;
+			UINT32	keys[SUB_PAGES_PER_PAGE];
+			UINT32	next_page = last_vpn[stream] == 0 ? 0 :
+					(last_vpn[stream] + 1) % PAGES_PER_VBLK
+					% GC_DATA_PAGES_PER_VBLK;
+			for_each_subpage(sp_i)
+				keys[sp_i] = test_key(stream, next_page, sp_i);
+			/* wait for erase thread to erase a block */
+			while (!gc_can_allocate_new_vpn(bank, stream))
+				ftl_main();
+			UINT32	vpn	= gc_allocate_new_vpn(bank, stream, keys);
+			BUG_ON("summary page is allocated",
+				vpn % PAGES_PER_VBLK == GC_SUMMARY_PAGE);
+
 			if (vpn % PAGES_PER_VBLK == 0) {
 				vblk = vpn / PAGES_PER_VBLK;
 				if (vblk >= num_blocks_to_test) break;
 
-				if (last_vpn[is_sys]) {
+				if (last_vpn[stream]) {
 					BUG_ON("not use all pages in last block",
-						(last_vpn[is_sys] + 1) % PAGES_PER_VBLK != 0);
+						(last_vpn[stream] + 1) % PAGES_PER_VBLK
+						!= GC_DATA_PAGES_PER_VBLK);
 				}
 				BUG_ON("bad block", bb_is_bad(bank, vblk));
 				BUG_ON("this block has been used",
 					get_usage(vblk) != 0xFFFFFFFF);
 
-				set_usage(vblk, is_sys);
+				UINT32 ec = gc_get_erase_count(bank, vblk);
+				if (stream == GC_RELOC_STREAM) {
+					BUG_ON("not the oldest erased block",
+						ec < min_ec);
+				}
+				else {
+					BUG_ON("not the youngest erased block",
+						ec < min_ec);
+					min_ec = ec;
+				}
+
+				set_usage(vblk, stream);
 				vblk++;
 			}
 			else {
 				BUG_ON("not use all pages in last block",
-					last_vpn[is_sys] + 1 != vpn);
+					last_vpn[stream] + 1 != vpn);
 			}
-			last_vpn[is_sys] = vpn;
+			BUG_ON("keys are not for this page",
+				next_page != vpn % PAGES_PER_VBLK);
+			last_vpn[stream] = vpn;
 		}
+
+		/* summaries of full blocks are written by now */
+		gc_flush();
+		check_summaries(bank, num_blocks_to_test, last_vpn);
 		uart_print("done");
 	}
 
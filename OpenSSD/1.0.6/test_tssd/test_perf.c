@@ -9,6 +9,9 @@
 #include "bad_blocks.h"
 #include "gc.h"
 #include "test_util.h"
+#if OPTION_FDE
+#include "fde.h"
+#endif
 
 extern BOOL8 	eventq_put(UINT32 const lba, UINT32 const num_sectors,
 #if OPTION_ACL
@@ -17,6 +20,14 @@ extern BOOL8 	eventq_put(UINT32 const lba, UINT32 const num_sectors,
 				UINT32 const cmd_type);
 extern BOOL8 ftl_all_sata_cmd_accepted();
 
+#if OPTION_FTL_VERIFY
+/* Data is not checked */
+void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
+		UINT8 const num_sectors, UINT32 const sata_rd_buf)
+{
+}
+#endif
+
 static void sram_perf_test()
 {
 	uart_print("SRAM performance test begins...");
@@ -139,7 +150,11 @@ static void flash_perf_test(UINT32 const total_mb_thr)
 	perf_monitor_reset();
 	while (num_sectors_so_far < total_sectors_thr) {
 		FOR_EACH_BANK(bank) {
-			vpn = gc_allocate_new_vpn(bank, FALSE);
+			while (!gc_can_allocate_new_vpn(bank,
+					GC_USER_STREAM(DEFAULT_USER_ID, 0)))
+				ftl_main();
+			vpn = gc_allocate_new_vpn(bank, GC_USER_STREAM(DEFAULT_USER_ID, 0),
+						  NULL);
 
 			nand_page_program_from_host(bank,
 						    vpn / PAGES_PER_VBLK,
@@ -188,7 +203,11 @@ static void flash_perf_test(UINT32 const total_mb_thr)
 		bank = 0;
 		num_pages_so_far = 0;
 		while (num_pages_so_far < total_pages) {
-			vpn = gc_allocate_new_vpn(bank, FALSE);
+			while (!gc_can_allocate_new_vpn(bank,
+					GC_USER_STREAM(DEFAULT_USER_ID, 0)))
+				ftl_main();
+			vpn = gc_allocate_new_vpn(bank, GC_USER_STREAM(DEFAULT_USER_ID, 0),
+						  NULL);
 
 			// only write one sector
 			nand_page_ptprogram_from_host(bank,
@@ -241,6 +260,26 @@ static void flash_perf_test(UINT32 const total_mb_thr)
 	uart_print("Done");
 }
 
+#if OPTION_FDE
+static void fde_perf_test(UINT32 const total_mb)
+{
+	uart_print("FDE cipher performance test begins...");
+
+	fde_key_t const key = *fde_get_user_key(DEFAULT_USER_ID);
+	UINT32 num_pages_to_crypt = total_mb * 1024 * 1024 / BYTES_PER_PAGE;
+	UINT32 page_i;
+	timer_reset();
+	for (page_i = 0; page_i < num_pages_to_crypt; page_i++)
+		fde_encrypt(TEMP_BUF_ADDR, SECTORS_PER_PAGE, key);
+	UINT32 time_us = timer_ellapsed_us();
+	uart_printf("FDE throughput = %uMB/s (latency = %uus per page)\r\n",
+		    total_mb * 1024 * 1024 / time_us,
+		    time_us / num_pages_to_crypt);
+
+	uart_print("Done");
+}
+#endif
+
 //#define FTL_REQ_UNALIGNED
 #ifdef  FTL_REQ_UNALIGNED
 	#define LBA_BEGIN	3
@@ -384,6 +423,11 @@ void ftl_test()
 		ftl_perf_test_seq(8,  total_mb_seq);	// req stride -- 4KB
 		ftl_perf_test_seq(32, total_mb_seq);	// req stride -- 16KB
 		ftl_perf_test_seq(64, total_mb_seq);	// req stride -- 32KB
+#if OPTION_FDE
+	/* the cost of FDE on the data path is measured by test_bench */
+	uart_print("------------------------- FDE ---------------------------");
+		fde_perf_test(64);
+#endif
 	uart_print("--------------------- FTL Rnd R/W -----------------------");
 		UINT32 total_mb_rnd = 128;
 		ftl_perf_test_rnd(8,  total_mb_rnd);	// req stride -- 4KB
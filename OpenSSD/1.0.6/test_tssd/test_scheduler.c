@@ -0,0 +1,252 @@
+/* ===========================================================================
+ * Microbenchmark of the thread engine (see thread.h and scheduler.h)
+ *
+ * Synthetic threads, which do nothing but switch, are added to the threads
+ * of FTL, i.e. the PMT, GC and erase threads that sleep while FTL is idle.
+ * For every number of synthetic threads, cycles of a pass of schedule() are
+ * measured when they
+ *	- sleep on a signal that never comes,
+ *	- yield by run_later(), i.e. every thread is switched in and out,
+ *	- sleep on a signal that a waker thread sends every pass.
+ * The cost of a pass with no synthetic threads is taken out, which gives the
+ * cost per skipped thread, per context switch and per wakeup. Then threads
+ * are spawned the way ftl_main() does, i.e. SCHED_FAN_OUT of them before every
+ * pass, each of which runs SCHED_PHASES phases and ends, to measure the whole
+ * life of a thread.
+ *
+ * On the host build, computation of firmware is free (see sim.h), so only
+ * the register accesses and the memory utility, e.g. the copies of
+ * save_thread_variables() and restore_thread_variables(), are counted.
+ * =========================================================================*/
+#include "jasmine.h"
+#if OPTION_FTL_TEST
+#include "thread_handler_util.h"
+#include "scheduler.h"
+#include "test_util.h"
+
+/* passes of schedule() to measure */
+#define SCHED_PASSES		1000
+/* threads spawned before every pass */
+#define SCHED_FAN_OUT		4
+/* phases of a spawned thread, i.e. number of switches before it ends */
+#define SCHED_PHASES		4
+/* 1 - spawned threads yield by sleeping on a signal; 0 - by run_later() */
+#define SCHED_SLEEP		0
+/* threads spawned in total */
+#define SCHED_SPAWNS		1000
+
+/* a signal not used by FTL */
+#define SIG_BENCH		(1 << 31)
+#define FOREVER			0xFFFFFFFF
+
+#if OPTION_FTL_VERIFY
+/* No data is read */
+void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
+		UINT8 const num_sectors, UINT32 const sata_rd_buf)
+{
+}
+#endif
+
+/* ===========================================================================
+ *  Synthetic Thread
+ * =========================================================================*/
+
+typedef enum {
+	ROLE_WORKER,
+	ROLE_WAKER
+} role_t;
+
+static BOOL8	stopping;
+static UINT32	num_live_threads;
+
+begin_thread_variables
+	UINT8	role;
+	BOOL8	sleeps;
+	UINT32	phases_left;
+end_thread_variables
+
+begin_thread_handler
+phase(RUN) {
+	if (stopping || var(phases_left) == 0) {
+		num_live_threads--;
+		end();
+	}
+	var(phases_left)--;
+
+	if (var(role) == ROLE_WAKER) {
+		signals_set(g_scheduler_signals, SIG_BENCH);
+		run_later();
+	}
+	if (var(sleeps))
+		sleep(SIG_BENCH);
+	else
+		run_later();
+}
+end_thread_handler
+
+static thread_handler_id_t registered_handler_id = NULL_THREAD_HANDLER_ID;
+
+static thread_t *spawn(role_t const role, BOOL8 const sleeps,
+		       UINT32 const num_phases)
+{
+	thread_t *t = thread_allocate();
+	t->handler_id = registered_handler_id;
+
+	var(role)	 = role;
+	var(sleeps)	 = sleeps;
+	var(phases_left) = num_phases;
+	init_thread_variables(thread_id(t));
+
+	enqueue(t);
+	num_live_threads++;
+	return t;
+}
+
+/* ===========================================================================
+ *  Measurements
+ * =========================================================================*/
+
+typedef enum {
+	MODE_IDLE,		/* sleep and never wake up */
+	MODE_SWITCH,		/* run_later() */
+	MODE_WAKEUP,		/* sleep and wake up every pass */
+	NUM_MODES
+} sched_mode_t;
+
+static thread_t *threads[MAX_NUM_THREADS];
+
+static void stop_all(UINT32 const num_threads)
+{
+	stopping = TRUE;
+	for (UINT32 i = 0; i < num_threads; i++)
+		if (threads[i]->state == THREAD_SLEEPING)
+			threads[i]->state = THREAD_RUNNABLE;
+	while (num_live_threads) schedule();
+	stopping = FALSE;
+}
+
+/* cycles of a pass of schedule() with *num_threads* synthetic threads, plus
+ * a waker in MODE_WAKEUP */
+static UINT32 measure_pass(sched_mode_t const mode, UINT32 const num_threads,
+			   UINT32 const num_passes)
+{
+	UINT32 n = 0;
+	/* in addition to the threads measured */
+	if (mode == MODE_WAKEUP)
+		threads[n++] = spawn(ROLE_WAKER, FALSE, FOREVER);
+	while (n < num_threads + (mode == MODE_WAKEUP))
+		threads[n++] = spawn(ROLE_WORKER, mode != MODE_SWITCH,
+				     FOREVER);
+	/* let all threads reach their steady state */
+	schedule();
+	schedule();
+
+	timer_reset();
+	for (UINT32 pass = 0; pass < num_passes; pass++)
+		schedule();
+	UINT32 cycles = timer_ellapsed_cycles();
+
+	stop_all(n);
+	return cycles / num_passes;
+}
+
+static void measure_save_restore(UINT32 const num_loops)
+{
+	timer_reset();
+	for (UINT32 i = 0; i < num_loops; i++) {
+		restore_thread_variables(0);
+		save_thread_variables(0);
+	}
+	UINT32 cycles = timer_ellapsed_cycles();
+	uart_print("save + restore of thread variables: %u cycles",
+		   cycles / num_loops);
+}
+
+static void measure_spawns(UINT32 const fan_out, UINT32 const num_phases,
+			   BOOL8 const sleeps, UINT32 const num_spawns,
+			   UINT32 const empty_pass)
+{
+	uart_print("spawn %u threads per pass, %u phases each, yield by %s",
+		   fan_out, num_phases, sleeps ? "sleep()" : "run_later()");
+
+	timer_reset();
+	/* sleeping threads need a waker */
+	if (sleeps) spawn(ROLE_WAKER, FALSE, FOREVER);
+	UINT32 num_spawned = 0, num_passes = 0;
+	while (num_spawned < num_spawns) {
+		for (UINT32 i = 0; i < fan_out && num_spawned < num_spawns &&
+				   thread_can_allocate(); i++) {
+			spawn(ROLE_WORKER, sleeps, num_phases);
+			num_spawned++;
+		}
+		schedule();
+		num_passes++;
+	}
+	/* only the waker is left after the last workers end */
+	while (num_live_threads > (sleeps ? 1 : 0)) {
+		schedule();
+		num_passes++;
+	}
+	UINT32 cycles = timer_ellapsed_cycles();
+	stopping = TRUE;
+	while (num_live_threads) schedule();
+	stopping = FALSE;
+
+	UINT32 thread_cycles = cycles > num_passes * empty_pass ?
+			       cycles - num_passes * empty_pass : 0;
+	uart_print("%u threads in %u passes: %u cycles per pass, "
+		   "%u cycles per thread", num_spawned, num_passes,
+		   cycles / num_passes, thread_cycles / num_spawned);
+}
+
+/* ===========================================================================
+ *  Test
+ * =========================================================================*/
+
+void ftl_test()
+{
+	uart_print("Start scheduler microbenchmark");
+
+	registered_handler_id = thread_handler_register(get_thread_handler());
+
+	UINT32 num_passes = MAX(test_param("SCHED_PASSES", SCHED_PASSES), 1);
+	/* threads of FTL are running, e.g. PMT, GC and erase threads; one more
+	 * is left for the waker */
+	UINT32 max_threads = MAX_NUM_THREADS - thread_num_allocated() - 1;
+	uart_print("%u threads of FTL, %u passes, cycles at %uMHz",
+		   thread_num_allocated(), num_passes, CLOCK_SPEED / 1000000);
+
+	measure_save_restore(num_passes);
+
+	UINT32 empty_pass = measure_pass(MODE_IDLE, 0, num_passes);
+	uart_print("empty pass: %u cycles", empty_pass);
+	uart_print("threads | pass: idle  switch  wakeup | "
+		   "per thread: skip  switch  wakeup");
+	for (UINT32 n = 1; ; n = MIN(n * 2, max_threads)) {
+		UINT32 pass[NUM_MODES], per[NUM_MODES];
+		for (UINT32 mode = 0; mode < NUM_MODES; mode++) {
+			pass[mode] = measure_pass(mode, n, num_passes);
+			per[mode]  = pass[mode] > empty_pass ?
+				     (pass[mode] - empty_pass) / n : 0;
+		}
+		/* take out the switch of the waker */
+		UINT32 waker = empty_pass + per[MODE_SWITCH];
+		per[MODE_WAKEUP] = pass[MODE_WAKEUP] > waker ?
+				   (pass[MODE_WAKEUP] - waker) / n : 0;
+		uart_print("%7u | %10u %7u %7u | %16u %7u %7u",
+			   n, pass[MODE_IDLE], pass[MODE_SWITCH],
+			   pass[MODE_WAKEUP], per[MODE_IDLE],
+			   per[MODE_SWITCH], per[MODE_WAKEUP]);
+		if (n == max_threads) break;
+	}
+
+	measure_spawns(test_param("SCHED_FAN_OUT", SCHED_FAN_OUT),
+		       test_param("SCHED_PHASES", SCHED_PHASES),
+		       test_param("SCHED_SLEEP", SCHED_SLEEP),
+		       MAX(test_param("SCHED_SPAWNS", SCHED_SPAWNS), 1),
+		       empty_pass);
+
+	uart_print("Scheduler passed the unit test ^_^");
+}
+
+#endif
@@ -0,0 +1,149 @@
+/* ===========================================================================
+ * Replay a block trace into the FTL through eventq_put()
+ *
+ * Traces are in the format of test/util/format2block.py, i.e. lines of
+ * 'pid R/W offset size' where offset is in sectors and size in bytes. The
+ * firmware embeds the trace in test_trace_replay_data.h, which is generated by
+ * test/util/block2header.py; the host build (build_sim) streams the file given
+ * by environment variable TRACE instead.
+ *
+ * Commands are issued as fast as the queue depth allows or, if a rate is
+ * given, at that rate. Latency of a command is from its arrival to the finish
+ * of its last page, and is reported in percentiles. On the host build, flash
+ * commands of the replay are dumped for test/util/fla_trace2json.py if
+ * environment variable REPLAY_FLASH_TRACE is set to 1.
+ * =========================================================================*/
+#include "jasmine.h"
+#if OPTION_FTL_TEST
+#include "test_workload_common.h"
+
+/* max number of commands in flight */
+#define REPLAY_QUEUE_DEPTH	32
+/* commands per second; 0 - as fast as the queue depth allows */
+#define REPLAY_IOPS		0
+/* offsets of trace are wrapped into the first REPLAY_NUM_SECTORS sectors */
+#define REPLAY_NUM_SECTORS	NUM_LSECTORS
+
+/* Data of trace is not known, so there is nothing to verify */
+void ftl_verify(UINT32 const lpn, UINT8 const sect_offset,
+		UINT8 const num_sectors, UINT32 const sata_rd_buf)
+{
+}
+
+/* ===========================================================================
+ *  Trace
+ * =========================================================================*/
+
+typedef struct {
+	UINT32	offset;		/* in sectors */
+	UINT32	num_bytes;
+	UINT32	cmd_type;
+} trace_line_t;
+
+#if OPTION_SIMULATION
+
+static FILE *trace_file;
+
+static void trace_open()
+{
+	char const *name = getenv("TRACE");
+	BUG_ON("specify a trace file by TRACE", name == NULL);
+	trace_file = fopen(name, "r");
+	BUG_ON("cannot open trace file", trace_file == NULL);
+	uart_print("trace: %s", name);
+}
+
+static BOOL8 trace_next_line(trace_line_t *line)
+{
+	int pid;
+	char wr;
+	unsigned long long offset;
+	unsigned num_bytes;
+
+	if (fscanf(trace_file, "%d %c %llu %u",
+		   &pid, &wr, &offset, &num_bytes) != 4)
+		return FALSE;
+	line->offset	= (UINT32)(offset % REPLAY_NUM_SECTORS);
+	line->num_bytes = num_bytes;
+	line->cmd_type	= (wr == 'W' || wr == 'w') ? WRITE : READ;
+	return TRUE;
+}
+
+#else
+
+#define TRACE_LINE(offset, num_bytes, cmd_type)	\
+		{(offset) % REPLAY_NUM_SECTORS, (num_bytes), (cmd_type)},
+static trace_line_t const trace_lines[] = {
+#include "test_trace_replay_data.h"
+};
+#undef TRACE_LINE
+#define NUM_TRACE_LINES		(sizeof(trace_lines) / sizeof(trace_lines[0]))
+
+static UINT32 trace_line_i;
+
+static void trace_open()
+{
+	trace_line_i = 0;
+	uart_print("trace: %u embedded commands", NUM_TRACE_LINES);
+}
+
+static BOOL8 trace_next_line(trace_line_t *line)
+{
+	if (trace_line_i == NUM_TRACE_LINES) return FALSE;
+	*line = trace_lines[trace_line_i++];
+	return TRUE;
+}
+
+#endif
+
+/* Commands of zero bytes are skipped and the ones beyond the end of the
+ * replayed range are moved back into it */
+static BOOL8 trace_next(UINT32 *lba, UINT32 *num_sectors, UINT32 *cmd_type,
+			UINT32 *session_key)
+{
+	trace_line_t line;
+	do {
+		if (!trace_next_line(&line)) return FALSE;
+	} while (line.num_bytes == 0);
+
+	*num_sectors = MIN(COUNT_BUCKETS(line.num_bytes, BYTES_PER_SECTOR),
+			   REPLAY_NUM_SECTORS);
+	*lba	     = MIN(line.offset, REPLAY_NUM_SECTORS - *num_sectors);
+	*cmd_type    = line.cmd_type;
+	*session_key = 0;
+	return TRUE;
+}
+
+/* ===========================================================================
+ *  Replay
+ * =========================================================================*/
+
+static void do_replay()
+{
+	UINT32 queue_depth = test_param("REPLAY_QUEUE_DEPTH",
+					REPLAY_QUEUE_DEPTH);
+	UINT32 iops	   = test_param("REPLAY_IOPS", REPLAY_IOPS);
+	uart_print("queue depth = %u, rate = %u IOPS (0 - unlimited)",
+		   queue_depth, iops);
+
+	trace_open();
+	workload_run(trace_next, queue_depth, iops);
+
+	uart_print("Done.");
+	workload_report();
+	workload_report_result("trace_replay");
+#if OPTION_FLA_TRACE
+	if (test_param("REPLAY_FLASH_TRACE", 0)) fla_trace_dump();
+#endif
+}
+
+void ftl_test()
+{
+	uart_print("Start trace replay test");
+
+	do_replay();
+
+	uart_print("FTL passed unit test ^_^");
+}
+
+#endif
@@ -0,0 +1,514 @@
+/* Generated by test/util/block2header.py from sample.trace */
+/* TRACE_LINE(offset in sectors, size in bytes, R/W) */
+TRACE_LINE(1048576, 131072, WRITE)
+TRACE_LINE(213952, 4096, READ)
+TRACE_LINE(1048832, 131072, WRITE)
+TRACE_LINE(540880, 4096, READ)
+TRACE_LINE(756760, 4096, READ)
+TRACE_LINE(656344, 65536, READ)
+TRACE_LINE(1049088, 131072, WRITE)
+TRACE_LINE(1049344, 131072, WRITE)
+TRACE_LINE(1049600, 131072, WRITE)
+TRACE_LINE(1370504, 16384, READ)
+TRACE_LINE(1049856, 131072, WRITE)
+TRACE_LINE(333728, 8192, READ)
+TRACE_LINE(157072, 16384, WRITE)
+TRACE_LINE(417248, 16384, READ)
+TRACE_LINE(1809896, 4096, READ)
+TRACE_LINE(478216, 65536, READ)
+TRACE_LINE(1050112, 131072, WRITE)
+TRACE_LINE(995576, 4096, READ)
+TRACE_LINE(1050368, 131072, WRITE)
+TRACE_LINE(303952, 4096, READ)
+TRACE_LINE(1578152, 65536, READ)
+TRACE_LINE(739200, 8192, WRITE)
+TRACE_LINE(567928, 16384, READ)
+TRACE_LINE(1144216, 8192, READ)
+TRACE_LINE(1050624, 131072, WRITE)
+TRACE_LINE(1050880, 131072, WRITE)
+TRACE_LINE(1348288, 4096, WRITE)
+TRACE_LINE(1682232, 65536, READ)
+TRACE_LINE(1051136, 131072, WRITE)
+TRACE_LINE(1735160, 4096, WRITE)
+TRACE_LINE(1051392, 131072, WRITE)
+TRACE_LINE(1632272, 4096, READ)
+TRACE_LINE(1051648, 131072, WRITE)
+TRACE_LINE(459296, 4096, WRITE)
+TRACE_LINE(1051904, 131072, WRITE)
+TRACE_LINE(681968, 8192, WRITE)
+TRACE_LINE(1715704, 16384, READ)
+TRACE_LINE(1331824, 16384, READ)
+TRACE_LINE(1456392, 4096, READ)
+TRACE_LINE(1564736, 16384, READ)
+TRACE_LINE(1873704, 16384, READ)
+TRACE_LINE(1052160, 131072, WRITE)
+TRACE_LINE(961056, 65536, READ)
+TRACE_LINE(1052416, 131072, WRITE)
+TRACE_LINE(1589000, 4096, WRITE)
+TRACE_LINE(1052672, 131072, WRITE)
+TRACE_LINE(1052928, 131072, WRITE)
+TRACE_LINE(46864, 16384, READ)
+TRACE_LINE(1053184, 131072, WRITE)
+TRACE_LINE(65896, 4096, READ)
+TRACE_LINE(548936, 65536, WRITE)
+TRACE_LINE(1053440, 131072, WRITE)
+TRACE_LINE(1053696, 131072, WRITE)
+TRACE_LINE(1053952, 131072, WRITE)
+TRACE_LINE(1836152, 4096, READ)
+TRACE_LINE(1461056, 8192, READ)
+TRACE_LINE(1610912, 4096, READ)
+TRACE_LINE(1593168, 65536, READ)
+TRACE_LINE(157808, 8192, WRITE)
+TRACE_LINE(449632, 8192, READ)
+TRACE_LINE(1491608, 8192, READ)
+TRACE_LINE(1621272, 8192, READ)
+TRACE_LINE(1054208, 131072, WRITE)
+TRACE_LINE(1054464, 131072, WRITE)
+TRACE_LINE(162552, 4096, WRITE)
+TRACE_LINE(730840, 4096, WRITE)
+TRACE_LINE(1054720, 131072, WRITE)
+TRACE_LINE(1054976, 131072, WRITE)
+TRACE_LINE(1152360, 16384, WRITE)
+TRACE_LINE(1650744, 4096, WRITE)
+TRACE_LINE(1055232, 131072, WRITE)
+TRACE_LINE(183776, 8192, READ)
+TRACE_LINE(2075840, 65536, WRITE)
+TRACE_LINE(1499304, 8192, READ)
+TRACE_LINE(1947472, 16384, READ)
+TRACE_LINE(1784224, 4096, WRITE)
+TRACE_LINE(916040, 4096, WRITE)
+TRACE_LINE(1128840, 65536, READ)
+TRACE_LINE(1055488, 131072, WRITE)
+TRACE_LINE(1135784, 4096, READ)
+TRACE_LINE(669680, 4096, READ)
+TRACE_LINE(528784, 65536, READ)
+TRACE_LINE(520800, 4096, READ)
+TRACE_LINE(1055744, 131072, WRITE)
+TRACE_LINE(1246920, 4096, WRITE)
+TRACE_LINE(1056000, 131072, WRITE)
+TRACE_LINE(2045128, 4096, WRITE)
+TRACE_LINE(137712, 4096, READ)
+TRACE_LINE(1056256, 131072, WRITE)
+TRACE_LINE(975792, 16384, WRITE)
+TRACE_LINE(1056512, 131072, WRITE)
+TRACE_LINE(1849872, 4096, READ)
+TRACE_LINE(153512, 8192, READ)
+TRACE_LINE(586192, 65536, WRITE)
+TRACE_LINE(1056768, 131072, WRITE)
+TRACE_LINE(1057024, 131072, WRITE)
+TRACE_LINE(1057280, 131072, WRITE)
+TRACE_LINE(257016, 16384, READ)
+TRACE_LINE(1599096, 8192, WRITE)
+TRACE_LINE(1139872, 65536, READ)
+TRACE_LINE(961104, 4096, WRITE)
+TRACE_LINE(1036584, 65536, READ)
+TRACE_LINE(1057536, 131072, WRITE)
+TRACE_LINE(1255352, 16384, WRITE)
+TRACE_LINE(1734040, 65536, READ)
+TRACE_LINE(863520, 8192, READ)
+TRACE_LINE(498640, 4096, WRITE)
+TRACE_LINE(1357568, 4096, WRITE)
+TRACE_LINE(911848, 4096, WRITE)
+TRACE_LINE(313600, 65536, READ)
+TRACE_LINE(714712, 8192, READ)
+TRACE_LINE(703368, 8192, WRITE)
+TRACE_LINE(630720, 65536, WRITE)
+TRACE_LINE(1057792, 131072, WRITE)
+TRACE_LINE(1800416, 65536, READ)
+TRACE_LINE(1058048, 131072, WRITE)
+TRACE_LINE(1058304, 131072, WRITE)
+TRACE_LINE(1058560, 131072, WRITE)
+TRACE_LINE(976904, 16384, READ)
+TRACE_LINE(795224, 4096, READ)
+TRACE_LINE(1436576, 4096, READ)
+TRACE_LINE(736008, 16384, WRITE)
+TRACE_LINE(1058816, 131072, WRITE)
+TRACE_LINE(1576144, 16384, READ)
+TRACE_LINE(1059072, 131072, WRITE)
+TRACE_LINE(701864, 4096, WRITE)
+TRACE_LINE(1059328, 131072, WRITE)
+TRACE_LINE(1059584, 131072, WRITE)
+TRACE_LINE(1480296, 8192, READ)
+TRACE_LINE(1059840, 131072, WRITE)
+TRACE_LINE(506272, 65536, READ)
+TRACE_LINE(533520, 8192, READ)
+TRACE_LINE(859280, 65536, READ)
+TRACE_LINE(1281640, 65536, READ)
+TRACE_LINE(1080160, 4096, WRITE)
+TRACE_LINE(363072, 4096, READ)
+TRACE_LINE(486832, 8192, READ)
+TRACE_LINE(1515624, 4096, READ)
+TRACE_LINE(1060096, 131072, WRITE)
+TRACE_LINE(1021192, 16384, WRITE)
+TRACE_LINE(604744, 16384, WRITE)
+TRACE_LINE(1200040, 8192, READ)
+TRACE_LINE(1060352, 131072, WRITE)
+TRACE_LINE(1209280, 4096, READ)
+TRACE_LINE(1060608, 131072, WRITE)
+TRACE_LINE(1060864, 131072, WRITE)
+TRACE_LINE(818680, 65536, WRITE)
+TRACE_LINE(1061120, 131072, WRITE)
+TRACE_LINE(841464, 4096, WRITE)
+TRACE_LINE(1921744, 4096, READ)
+TRACE_LINE(405800, 8192, READ)
+TRACE_LINE(1061376, 131072, WRITE)
+TRACE_LINE(468840, 16384, READ)
+TRACE_LINE(1680984, 4096, READ)
+TRACE_LINE(1061632, 131072, WRITE)
+TRACE_LINE(1061888, 131072, WRITE)
+TRACE_LINE(1738928, 4096, WRITE)
+TRACE_LINE(716592, 16384, READ)
+TRACE_LINE(1062144, 131072, WRITE)
+TRACE_LINE(1062400, 131072, WRITE)
+TRACE_LINE(1841704, 16384, WRITE)
+TRACE_LINE(1097784, 65536, WRITE)
+TRACE_LINE(1395000, 4096, WRITE)
+TRACE_LINE(1215200, 65536, WRITE)
+TRACE_LINE(1062656, 131072, WRITE)
+TRACE_LINE(1062912, 131072, WRITE)
+TRACE_LINE(1063168, 131072, WRITE)
+TRACE_LINE(1784856, 16384, READ)
+TRACE_LINE(960824, 65536, READ)
+TRACE_LINE(1757520, 65536, READ)
+TRACE_LINE(813112, 4096, WRITE)
+TRACE_LINE(1557504, 8192, READ)
+TRACE_LINE(1348416, 8192, READ)
+TRACE_LINE(2045096, 8192, READ)
+TRACE_LINE(1790400, 65536, READ)
+TRACE_LINE(2043328, 65536, READ)
+TRACE_LINE(999520, 16384, WRITE)
+TRACE_LINE(620368, 4096, READ)
+TRACE_LINE(534184, 65536, WRITE)
+TRACE_LINE(2029888, 4096, WRITE)
+TRACE_LINE(49728, 8192, READ)
+TRACE_LINE(1707792, 16384, WRITE)
+TRACE_LINE(1063424, 131072, WRITE)
+TRACE_LINE(1063680, 131072, WRITE)
+TRACE_LINE(1610864, 8192, READ)
+TRACE_LINE(2005344, 16384, READ)
+TRACE_LINE(1063936, 131072, WRITE)
+TRACE_LINE(1064192, 131072, WRITE)
+TRACE_LINE(1561256, 4096, WRITE)
+TRACE_LINE(447728, 65536, READ)
+TRACE_LINE(1166912, 65536, READ)
+TRACE_LINE(1064448, 131072, WRITE)
+TRACE_LINE(698624, 8192, READ)
+TRACE_LINE(1064704, 131072, WRITE)
+TRACE_LINE(1064960, 131072, WRITE)
+TRACE_LINE(1941072, 8192, WRITE)
+TRACE_LINE(1157360, 65536, READ)
+TRACE_LINE(1065216, 131072, WRITE)
+TRACE_LINE(1065472, 131072, WRITE)
+TRACE_LINE(1330152, 4096, READ)
+TRACE_LINE(1063240, 16384, WRITE)
+TRACE_LINE(2053904, 16384, READ)
+TRACE_LINE(1952, 16384, READ)
+TRACE_LINE(1065728, 131072, WRITE)
+TRACE_LINE(1561304, 16384, READ)
+TRACE_LINE(1661080, 4096, WRITE)
+TRACE_LINE(1386432, 16384, READ)
+TRACE_LINE(379304, 16384, READ)
+TRACE_LINE(837768, 8192, WRITE)
+TRACE_LINE(1637360, 4096, READ)
+TRACE_LINE(1065984, 131072, WRITE)
+TRACE_LINE(2091776, 4096, READ)
+TRACE_LINE(1819112, 4096, WRITE)
+TRACE_LINE(660408, 4096, READ)
+TRACE_LINE(165736, 4096, READ)
+TRACE_LINE(1644520, 4096, WRITE)
+TRACE_LINE(136336, 4096, READ)
+TRACE_LINE(1066240, 131072, WRITE)
+TRACE_LINE(1491144, 4096, WRITE)
+TRACE_LINE(1489864, 4096, WRITE)
+TRACE_LINE(1727072, 4096, READ)
+TRACE_LINE(225624, 4096, READ)
+TRACE_LINE(1050088, 8192, WRITE)
+TRACE_LINE(1066496, 131072, WRITE)
+TRACE_LINE(1066752, 131072, WRITE)
+TRACE_LINE(925328, 65536, READ)
+TRACE_LINE(474872, 4096, WRITE)
+TRACE_LINE(1067008, 131072, WRITE)
+TRACE_LINE(1380816, 65536, WRITE)
+TRACE_LINE(96792, 8192, READ)
+TRACE_LINE(1067264, 131072, WRITE)
+TRACE_LINE(1703280, 16384, WRITE)
+TRACE_LINE(1067520, 131072, WRITE)
+TRACE_LINE(916456, 4096, READ)
+TRACE_LINE(1566976, 4096, WRITE)
+TRACE_LINE(1590568, 16384, WRITE)
+TRACE_LINE(2043520, 4096, WRITE)
+TRACE_LINE(1067776, 131072, WRITE)
+TRACE_LINE(1068032, 131072, WRITE)
+TRACE_LINE(268088, 4096, WRITE)
+TRACE_LINE(1525440, 4096, READ)
+TRACE_LINE(1469072, 8192, READ)
+TRACE_LINE(504632, 65536, WRITE)
+TRACE_LINE(1049000, 8192, WRITE)
+TRACE_LINE(1559392, 65536, READ)
+TRACE_LINE(1068288, 131072, WRITE)
+TRACE_LINE(1261192, 8192, READ)
+TRACE_LINE(1025240, 4096, READ)
+TRACE_LINE(1309800, 4096, READ)
+TRACE_LINE(1068544, 131072, WRITE)
+TRACE_LINE(1068800, 131072, WRITE)
+TRACE_LINE(684736, 65536, WRITE)
+TRACE_LINE(612312, 8192, WRITE)
+TRACE_LINE(1792936, 16384, READ)
+TRACE_LINE(1484344, 65536, WRITE)
+TRACE_LINE(1855600, 4096, WRITE)
+TRACE_LINE(1069056, 131072, WRITE)
+TRACE_LINE(1036952, 16384, READ)
+TRACE_LINE(1069312, 131072, WRITE)
+TRACE_LINE(1547176, 65536, WRITE)
+TRACE_LINE(330704, 4096, WRITE)
+TRACE_LINE(1346704, 8192, WRITE)
+TRACE_LINE(1776568, 16384, READ)
+TRACE_LINE(662488, 4096, WRITE)
+TRACE_LINE(1069568, 131072, WRITE)
+TRACE_LINE(1069824, 131072, WRITE)
+TRACE_LINE(428968, 65536, READ)
+TRACE_LINE(1614056, 4096, WRITE)
+TRACE_LINE(1070080, 131072, WRITE)
+TRACE_LINE(1070336, 131072, WRITE)
+TRACE_LINE(760888, 4096, READ)
+TRACE_LINE(685704, 65536, WRITE)
+TRACE_LINE(421104, 4096, READ)
+TRACE_LINE(1070592, 131072, WRITE)
+TRACE_LINE(515968, 16384, READ)
+TRACE_LINE(1283712, 16384, READ)
+TRACE_LINE(499232, 4096, READ)
+TRACE_LINE(488800, 65536, READ)
+TRACE_LINE(943152, 8192, READ)
+TRACE_LINE(1070848, 131072, WRITE)
+TRACE_LINE(156776, 4096, READ)
+TRACE_LINE(1398776, 16384, READ)
+TRACE_LINE(653720, 4096, READ)
+TRACE_LINE(1926584, 4096, WRITE)
+TRACE_LINE(431904, 4096, READ)
+TRACE_LINE(1071104, 131072, WRITE)
+TRACE_LINE(1309184, 65536, WRITE)
+TRACE_LINE(1071360, 131072, WRITE)
+TRACE_LINE(1201376, 4096, READ)
+TRACE_LINE(1071616, 131072, WRITE)
+TRACE_LINE(1464256, 16384, READ)
+TRACE_LINE(1071872, 131072, WRITE)
+TRACE_LINE(1072128, 131072, WRITE)
+TRACE_LINE(1294112, 8192, WRITE)
+TRACE_LINE(1902680, 65536, READ)
+TRACE_LINE(1072384, 131072, WRITE)
+TRACE_LINE(1211192, 65536, READ)
+TRACE_LINE(559072, 4096, READ)
+TRACE_LINE(1663632, 4096, READ)
+TRACE_LINE(1072640, 131072, WRITE)
+TRACE_LINE(445264, 16384, READ)
+TRACE_LINE(501600, 8192, READ)
+TRACE_LINE(756536, 65536, WRITE)
+TRACE_LINE(1072896, 131072, WRITE)
+TRACE_LINE(290272, 4096, READ)
+TRACE_LINE(2007872, 16384, WRITE)
+TRACE_LINE(1685048, 16384, READ)
+TRACE_LINE(1073152, 131072, WRITE)
+TRACE_LINE(1358400, 16384, READ)
+TRACE_LINE(1073408, 131072, WRITE)
+TRACE_LINE(878576, 4096, WRITE)
+TRACE_LINE(2060408, 4096, READ)
+TRACE_LINE(989736, 65536, READ)
+TRACE_LINE(153528, 4096, WRITE)
+TRACE_LINE(836392, 65536, READ)
+TRACE_LINE(1073664, 131072, WRITE)
+TRACE_LINE(1073920, 131072, WRITE)
+TRACE_LINE(1317640, 16384, READ)
+TRACE_LINE(1074176, 131072, WRITE)
+TRACE_LINE(934144, 65536, WRITE)
+TRACE_LINE(1408440, 65536, READ)
+TRACE_LINE(1521920, 65536, WRITE)
+TRACE_LINE(637392, 16384, WRITE)
+TRACE_LINE(1074432, 131072, WRITE)
+TRACE_LINE(1124200, 4096, READ)
+TRACE_LINE(1887504, 4096, WRITE)
+TRACE_LINE(1775016, 16384, WRITE)
+TRACE_LINE(58864, 4096, WRITE)
+TRACE_LINE(1074688, 131072, WRITE)
+TRACE_LINE(1074944, 131072, WRITE)
+TRACE_LINE(1075200, 131072, WRITE)
+TRACE_LINE(1075456, 131072, WRITE)
+TRACE_LINE(183680, 65536, READ)
+TRACE_LINE(92280, 16384, READ)
+TRACE_LINE(1612040, 4096, WRITE)
+TRACE_LINE(1193472, 65536, READ)
+TRACE_LINE(894864, 4096, WRITE)
+TRACE_LINE(1075712, 131072, WRITE)
+TRACE_LINE(1075968, 131072, WRITE)
+TRACE_LINE(1076224, 131072, WRITE)
+TRACE_LINE(1134784, 4096, WRITE)
+TRACE_LINE(1326144, 4096, READ)
+TRACE_LINE(1076480, 131072, WRITE)
+TRACE_LINE(1076736, 131072, WRITE)
+TRACE_LINE(1466944, 16384, READ)
+TRACE_LINE(1664696, 4096, READ)
+TRACE_LINE(1049096, 8192, READ)
+TRACE_LINE(1017416, 4096, WRITE)
+TRACE_LINE(1076992, 131072, WRITE)
+TRACE_LINE(1077248, 131072, WRITE)
+TRACE_LINE(60976, 65536, READ)
+TRACE_LINE(2086768, 4096, READ)
+TRACE_LINE(1077504, 131072, WRITE)
+TRACE_LINE(1356280, 4096, READ)
+TRACE_LINE(1077760, 131072, WRITE)
+TRACE_LINE(1612952, 4096, WRITE)
+TRACE_LINE(92960, 4096, READ)
+TRACE_LINE(1291608, 8192, WRITE)
+TRACE_LINE(1557304, 65536, WRITE)
+TRACE_LINE(555984, 16384, WRITE)
+TRACE_LINE(1332168, 65536, WRITE)
+TRACE_LINE(56536, 16384, READ)
+TRACE_LINE(1875144, 4096, WRITE)
+TRACE_LINE(1078016, 131072, WRITE)
+TRACE_LINE(166192, 8192, READ)
+TRACE_LINE(1078272, 131072, WRITE)
+TRACE_LINE(1192056, 16384, READ)
+TRACE_LINE(1078528, 131072, WRITE)
+TRACE_LINE(1795768, 65536, READ)
+TRACE_LINE(1078784, 131072, WRITE)
+TRACE_LINE(1838600, 8192, READ)
+TRACE_LINE(1206808, 4096, READ)
+TRACE_LINE(610832, 8192, READ)
+TRACE_LINE(413128, 8192, READ)
+TRACE_LINE(264424, 8192, WRITE)
+TRACE_LINE(958416, 8192, READ)
+TRACE_LINE(1002696, 16384, READ)
+TRACE_LINE(1522616, 8192, WRITE)
+TRACE_LINE(443552, 65536, WRITE)
+TRACE_LINE(1079040, 131072, WRITE)
+TRACE_LINE(1079296, 131072, WRITE)
+TRACE_LINE(1313832, 4096, READ)
+TRACE_LINE(1079552, 131072, WRITE)
+TRACE_LINE(1207360, 4096, READ)
+TRACE_LINE(1079808, 131072, WRITE)
+TRACE_LINE(2012056, 16384, READ)
+TRACE_LINE(1421744, 4096, READ)
+TRACE_LINE(1167848, 8192, WRITE)
+TRACE_LINE(1080064, 131072, WRITE)
+TRACE_LINE(1076120, 4096, WRITE)
+TRACE_LINE(1080320, 131072, WRITE)
+TRACE_LINE(530304, 8192, WRITE)
+TRACE_LINE(325672, 16384, READ)
+TRACE_LINE(1916640, 4096, READ)
+TRACE_LINE(1080576, 131072, WRITE)
+TRACE_LINE(1630328, 16384, WRITE)
+TRACE_LINE(1080832, 131072, WRITE)
+TRACE_LINE(1081088, 131072, WRITE)
+TRACE_LINE(1081344, 131072, WRITE)
+TRACE_LINE(147224, 65536, READ)
+TRACE_LINE(1081600, 131072, WRITE)
+TRACE_LINE(755600, 4096, WRITE)
+TRACE_LINE(844704, 4096, WRITE)
+TRACE_LINE(1081856, 131072, WRITE)
+TRACE_LINE(1059832, 8192, WRITE)
+TRACE_LINE(1082112, 131072, WRITE)
+TRACE_LINE(676704, 4096, WRITE)
+TRACE_LINE(219328, 65536, WRITE)
+TRACE_LINE(1082368, 131072, WRITE)
+TRACE_LINE(1082624, 131072, WRITE)
+TRACE_LINE(889304, 16384, READ)
+TRACE_LINE(1082880, 131072, WRITE)
+TRACE_LINE(1160712, 4096, READ)
+TRACE_LINE(1083136, 131072, WRITE)
+TRACE_LINE(1620872, 8192, READ)
+TRACE_LINE(1083392, 131072, WRITE)
+TRACE_LINE(1083648, 131072, WRITE)
+TRACE_LINE(739120, 4096, READ)
+TRACE_LINE(1083904, 131072, WRITE)
+TRACE_LINE(358456, 4096, READ)
+TRACE_LINE(1225696, 4096, WRITE)
+TRACE_LINE(1084160, 131072, WRITE)
+TRACE_LINE(1659808, 65536, READ)
+TRACE_LINE(88360, 16384, WRITE)
+TRACE_LINE(1301280, 8192, READ)
+TRACE_LINE(974368, 4096, WRITE)
+TRACE_LINE(1870872, 8192, WRITE)
+TRACE_LINE(1084416, 131072, WRITE)
+TRACE_LINE(57840, 4096, WRITE)
+TRACE_LINE(1064720, 16384, WRITE)
+TRACE_LINE(1257032, 4096, READ)
+TRACE_LINE(1526184, 4096, READ)
+TRACE_LINE(937344, 4096, WRITE)
+TRACE_LINE(386144, 4096, READ)
+TRACE_LINE(1598424, 16384, WRITE)
+TRACE_LINE(1639792, 8192, READ)
+TRACE_LINE(827696, 16384, READ)
+TRACE_LINE(1084672, 131072, WRITE)
+TRACE_LINE(876848, 4096, READ)
+TRACE_LINE(1961344, 65536, READ)
+TRACE_LINE(1084928, 131072, WRITE)
+TRACE_LINE(931488, 65536, WRITE)
+TRACE_LINE(313192, 4096, READ)
+TRACE_LINE(1972648, 65536, READ)
+TRACE_LINE(1085184, 131072, WRITE)
+TRACE_LINE(723064, 4096, WRITE)
+TRACE_LINE(1085440, 131072, WRITE)
+TRACE_LINE(1085696, 131072, WRITE)
+TRACE_LINE(1668648, 4096, READ)
+TRACE_LINE(44544, 8192, READ)
+TRACE_LINE(1462656, 65536, WRITE)
+TRACE_LINE(1556456, 65536, READ)
+TRACE_LINE(1085952, 131072, WRITE)
+TRACE_LINE(1824624, 4096, READ)
+TRACE_LINE(2002464, 4096, WRITE)
+TRACE_LINE(1373360, 4096, READ)
+TRACE_LINE(270384, 8192, WRITE)
+TRACE_LINE(1086208, 131072, WRITE)
+TRACE_LINE(1239936, 4096, READ)
+TRACE_LINE(424112, 8192, READ)
+TRACE_LINE(612272, 16384, READ)
+TRACE_LINE(1086464, 131072, WRITE)
+TRACE_LINE(1086720, 131072, WRITE)
+TRACE_LINE(1086976, 131072, WRITE)
+TRACE_LINE(47728, 8192, READ)
+TRACE_LINE(531136, 65536, WRITE)
+TRACE_LINE(791312, 4096, WRITE)
+TRACE_LINE(1603120, 4096, READ)
+TRACE_LINE(1087232, 131072, WRITE)
+TRACE_LINE(1347984, 8192, READ)
+TRACE_LINE(1245888, 4096, READ)
+TRACE_LINE(1087488, 131072, WRITE)
+TRACE_LINE(917768, 4096, READ)
+TRACE_LINE(862056, 16384, READ)
+TRACE_LINE(367000, 65536, READ)
+TRACE_LINE(694024, 65536, WRITE)
+TRACE_LINE(1594032, 4096, WRITE)
+TRACE_LINE(892848, 65536, READ)
+TRACE_LINE(2067200, 65536, READ)
+TRACE_LINE(1044288, 65536, READ)
+TRACE_LINE(1087744, 131072, WRITE)
+TRACE_LINE(478504, 4096, WRITE)
+TRACE_LINE(1585728, 8192, WRITE)
+TRACE_LINE(1262992, 8192, WRITE)
+TRACE_LINE(1421712, 4096, READ)
+TRACE_LINE(945792, 65536, READ)
+TRACE_LINE(1506368, 4096, WRITE)
+TRACE_LINE(946960, 16384, READ)
+TRACE_LINE(1088000, 131072, WRITE)
+TRACE_LINE(1088256, 131072, WRITE)
+TRACE_LINE(963944, 8192, WRITE)
+TRACE_LINE(502352, 4096, READ)
+TRACE_LINE(1099456, 65536, READ)
+TRACE_LINE(281816, 65536, READ)
+TRACE_LINE(379104, 16384, WRITE)
+TRACE_LINE(2025960, 16384, WRITE)
+TRACE_LINE(1345264, 4096, WRITE)
+TRACE_LINE(1088512, 131072, WRITE)
+TRACE_LINE(1455720, 8192, READ)
+TRACE_LINE(1302848, 4096, READ)
+TRACE_LINE(151856, 4096, READ)
+TRACE_LINE(1088768, 131072, WRITE)
+TRACE_LINE(1089024, 131072, WRITE)
+TRACE_LINE(1089280, 131072, WRITE)
+TRACE_LINE(1089536, 131072, WRITE)
+TRACE_LINE(393336, 4096, WRITE)
+TRACE_LINE(1429408, 16384, READ)
+TRACE_LINE(1592704, 4096, READ)
+TRACE_LINE(1089792, 131072, WRITE)
+TRACE_LINE(1090048, 131072, WRITE)
+TRACE_LINE(1236840, 65536, WRITE)
+TRACE_LINE(927448, 65536, WRITE)
@@ -3,6 +3,10 @@
 #if OPTION_FTL_TEST
 #include <stdlib.h>
 
+#include "counters.h"
+#if OPTION_FDE
+#include "fde.h"
+#endif
 #if OPTION_PROFILING
 #include <profiler.h>
 #endif
@@ -26,6 +30,13 @@ UINT32 timer_ellapsed_us()
     return rtime;
 }
 
+UINT32 timer_ellapsed_cycles()
+{
+    /* the timer counts at half of the CPU clock */
+    return (0xFFFFFFFF - GET_TIMER_VALUE(TIMER_CH2)) * 2 *
+	   PRESCALE_TO_DIV(TIMER_PRESCALE_0);
+}
+
 /* ===========================================================================
  * Performance report
  * =========================================================================*/
@@ -36,18 +47,41 @@ static UINT32 _pm_output_threshold = PM_DEFAULT_OUTPUT_THRESHOLD;
 static UINT32 _pm_total_bytes;
 
 #if OPTION_PERF_TUNING
-extern UINT32 g_flash_read_count, g_flash_write_count;
-extern UINT32 g_pmt_cache_flush_count;
-extern UINT32 g_pmt_cache_load_count;
+/* counters are never reset; report the difference from this snapshot */
+static counters_t _pm_base_counters;
+
+#define counter_since(base, id)	(counter_get(id) - (base)->counters[id])
+
+static void report_waf(counters_t const *base)
+{
+	UINT32 waf = counters_waf_percent(base);
+	uart_printf("> Write amplification %u.%02u, PMT overhead %u%%\r\n",
+		    waf / 100, waf % 100, counters_pmt_overhead_percent(base));
+	uart_printf("> Sub-pages programmed: user %u, PMT %u, metadata %u, "
+		    "GC %u\r\n",
+		    counter_since(base, COUNTER_USER_PROGRAM_SUB_PAGES),
+		    counter_since(base, COUNTER_PMT_PROGRAM_SUB_PAGES),
+		    counter_since(base, COUNTER_META_PROGRAM_SUB_PAGES),
+		    counter_since(base, COUNTER_GC_PROGRAM_SUB_PAGES));
+}
+
+#define pm_counter(id)	counter_since(&_pm_base_counters, id)
+
+static UINT32 pm_bank_counter(bank_counter_id_t const id)
+{
+	UINT32 sum = 0;
+	for (UINT8 bank = 0; bank < NUM_BANKS; bank++)
+		sum += bank_counter_get(id, bank) -
+		       _pm_base_counters.bank_counters[id][bank];
+	return sum;
+}
 #endif
 
 void perf_monitor_reset()
 {
 	_pm_total_bytes = 0;
 #if OPTION_PERF_TUNING
-	g_flash_read_count = g_flash_write_count = 0;
-	g_pmt_cache_flush_count = 0;
-	g_pmt_cache_load_count = 0;
+	_pm_base_counters = g_counters;
 #endif
 
 #if OPTION_PROFILING
@@ -74,19 +108,32 @@ void perf_monitor_report()
 		    throughput);
 
 #if OPTION_PERF_TUNING
-	if (g_flash_read_count || g_flash_write_count) {
+	UINT32 flash_reads  = pm_bank_counter(BANK_COUNTER_FLASH_READS);
+	UINT32 flash_writes = pm_bank_counter(BANK_COUNTER_FLASH_PROGRAMS);
+	if (flash_reads || flash_writes) {
 		uart_printf("> Total of %u flash reads and %u flash writes\r\n",
-			    g_flash_read_count, g_flash_write_count);
+			    flash_reads, flash_writes);
 		uart_printf("> Total of %u PMT cache flush\r\n",
-			    g_pmt_cache_flush_count);
+			    pm_counter(COUNTER_PMT_FLUSHES));
 		uart_printf("> Total of %u PMT cache load\r\n",
-			    g_pmt_cache_load_count);
+			    pm_counter(COUNTER_PMT_MISSES));
+	}
+	UINT32 wb_flushes = pm_counter(COUNTER_WRITE_BUFFER_FLUSHES);
+	if (wb_flushes) {
+		uart_printf("> Total of %u write buffer flush, "
+			    "avg. program utilization %u%%\r\n",
+			    wb_flushes,
+			    pm_counter(COUNTER_WRITE_BUFFER_FLUSH_SECTORS) * 100 /
+			    (wb_flushes * SECTORS_PER_PAGE));
 	}
+	if (pm_counter(COUNTER_HOST_WRITE_SECTORS))
+		report_waf(&_pm_base_counters);
 #endif
 
 #if OPTION_PROFILING
 	uart_printf("> flash_finish() time = %ums\r\n",
 	    profiler_get_total_time(PROFILER_FLASH_FINISH) / 1000);
+	profiler_report_phases();
 #endif
 }
 
@@ -100,6 +147,24 @@ void perf_monitor_update(UINT32 const num_sectors)
 	}
 }
 
+#if OPTION_PERF_TUNING
+static counters_t _waf_base_counters;
+#endif
+
+void waf_monitor_reset()
+{
+#if OPTION_PERF_TUNING
+	_waf_base_counters = g_counters;
+#endif
+}
+
+void waf_monitor_report()
+{
+#if OPTION_PERF_TUNING
+	report_waf(&_waf_base_counters);
+#endif
+}
+
 /* ===========================================================================
  *  Buffer Utility
  * =========================================================================*/
@@ -137,6 +202,24 @@ UINT32 random(UINT32 const min, UINT32 const max)
 	return min + (rand() % (max-min+1));
 }
 
+#if OPTION_SIMULATION
+UINT32 test_param(char const *name, UINT32 const default_val)
+{
+	char const *val = getenv(name);
+	return val ? (UINT32)strtoul(val, NULL, 0) : default_val;
+}
+#endif
+
+#if OPTION_FDE
+void set_fde_key()
+{
+	fde_key_t master_key;
+	for (UINT32 i = 0; i < sizeof(master_key.key); i++)
+		master_key.key[i] = (UINT8)(i * 0x9E + 0x37);
+	BUG_ON("failed to set FDE key", !fde_set_master_key(&master_key));
+}
+#endif
+
 void  dump_buffer(UINT32 const buff_addr,
 		  UINT8 const offset,
 		  UINT8 const num_sectors)
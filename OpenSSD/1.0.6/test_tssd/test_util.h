@@ -28,6 +28,8 @@
  * =========================================================================*/
 void timer_reset();
 UINT32 timer_ellapsed_us();
+/* CPU cycles since reset, for measuring short runs of code */
+UINT32 timer_ellapsed_cycles();
 
 /* ===========================================================================
  * Performance Utility
@@ -36,6 +38,9 @@ void perf_monitor_reset();
 void perf_monitor_set_output_threshold(UINT32 const num_bytes);
 void perf_monitor_report();
 void perf_monitor_update(UINT32 const num_sectors);
+/* Write amplification since the last reset (see counters.h) */
+void waf_monitor_reset();
+void waf_monitor_report();
 
 /* ===========================================================================
  * Buffer Utility
@@ -51,6 +56,19 @@ void fill_buffer(UINT32 const buf, UINT8  const offset,
  * =========================================================================*/
 UINT32 random(UINT32 const min, UINT32 const max);
 
+/* Parameter of a test, which can be changed on the host build by an
+ * environment variable of the same name */
+#if OPTION_SIMULATION
+UINT32 test_param(char const *name, UINT32 const default_val);
+#else
+#define test_param(name, default_val)	(default_val)
+#endif
+
+#if OPTION_FDE
+/* Turn FDE on with a fixed master key, before any data is written */
+void set_fde_key();
+#endif
+
 BOOL8 is_buff_wrong(UINT32 buff_addr, UINT32 val,
 		    UINT8 offset, UINT8 num_sectors);
 
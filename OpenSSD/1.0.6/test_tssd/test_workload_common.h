@@ -0,0 +1,304 @@
+#ifndef __TEST_WORKLOAD_COMMON_H
+#define __TEST_WORKLOAD_COMMON_H
+
+/* ===========================================================================
+ * Drive the FTL with a workload through eventq_put()
+ *
+ * A workload is a function that gives the next command. Commands are issued
+ * as fast as the queue depth allows or, if a rate is given, at that rate.
+ * Latency of a command is from its arrival to the finish of its last page,
+ * and is reported in percentiles.
+ *
+ * Besides the report for humans, workload_report_result() prints a line of
+ * 'result name=... key=value ...' for scripts (see test/util/bench.py).
+ * =========================================================================*/
+
+#include "test_ftl_rw_common.h"
+#include "sata_manager.h"
+#include "counters.h"
+#include "fla.h"
+#if OPTION_SIMULATION
+#include <stdio.h>
+#endif
+#if OPTION_PROFILING
+#include "profiler.h"
+#endif
+
+#define MAX_QUEUE_DEPTH		64
+
+/* Give the next command of workload; return FALSE if there is no more */
+typedef BOOL8 (*workload_next_t)(UINT32 *lba, UINT32 *num_sectors,
+				 UINT32 *cmd_type, UINT32 *session_key);
+
+/* ===========================================================================
+ *  Clock
+ *
+ *  Timer of test_util wraps around every 49 seconds, which is shorter than
+ *  long workloads; ticks are accumulated as long as the clock is read more
+ *  often than that.
+ * =========================================================================*/
+
+static UINT64 clock_ticks;
+static UINT32 clock_last_val;
+
+static void clock_start()
+{
+	timer_reset();
+	clock_ticks    = 0;
+	clock_last_val = GET_TIMER_VALUE(TIMER_CH2);
+}
+
+static UINT32 clock_us()
+{
+	UINT32 val = GET_TIMER_VALUE(TIMER_CH2);
+	clock_ticks += clock_last_val - val;
+	clock_last_val = val;
+	return (UINT32)(clock_ticks * 2 * 1000000 *
+			PRESCALE_TO_DIV(TIMER_PRESCALE_0) / CLOCK_SPEED);
+}
+
+/* ===========================================================================
+ *  Latency Histogram
+ *
+ *  Each power of two is divided into 8 buckets, so a percentile is within
+ *  12.5% of the real latency.
+ * =========================================================================*/
+
+#define LAT_SUB_BITS		3
+#define LAT_NUM_SUBS		(1 << LAT_SUB_BITS)
+#define LAT_NUM_BUCKETS		((32 - LAT_SUB_BITS + 1) * LAT_NUM_SUBS)
+
+typedef struct {
+	UINT32	buckets[LAT_NUM_BUCKETS];
+	UINT32	num_cmds;
+	UINT32	max_us;
+	UINT64	num_sectors;
+} lat_hist_t;
+
+static UINT32 lat_bucket(UINT32 const us)
+{
+	if (us < LAT_NUM_SUBS) return us;
+	UINT32 e = 31 - __builtin_clz(us);
+	return ((e - LAT_SUB_BITS + 1) << LAT_SUB_BITS) +
+		((us >> (e - LAT_SUB_BITS)) & (LAT_NUM_SUBS - 1));
+}
+
+/* the largest latency that falls into the bucket */
+static UINT32 lat_bucket_max(UINT32 const b)
+{
+	if (b < LAT_NUM_SUBS) return b;
+	UINT32 e = (b >> LAT_SUB_BITS) + LAT_SUB_BITS - 1;
+	UINT32 lower = (LAT_NUM_SUBS + (b & (LAT_NUM_SUBS - 1))) <<
+			(e - LAT_SUB_BITS);
+	return lower + (1 << (e - LAT_SUB_BITS)) - 1;
+}
+
+static void lat_record(lat_hist_t *h, UINT32 const us,
+		       UINT32 const num_sectors)
+{
+	h->buckets[lat_bucket(us)]++;
+	h->num_cmds++;
+	h->num_sectors += num_sectors;
+	if (us > h->max_us) h->max_us = us;
+}
+
+/* latency under which *per_mille* of commands finish */
+static UINT32 lat_percentile(lat_hist_t const *h, UINT32 const per_mille)
+{
+	UINT32 target = (UINT32)COUNT_BUCKETS((UINT64)h->num_cmds * per_mille,
+						1000);
+	UINT32 count  = 0;
+	for (UINT32 b = 0; b < LAT_NUM_BUCKETS; b++) {
+		count += h->buckets[b];
+		if (count >= target) return MIN(lat_bucket_max(b), h->max_us);
+	}
+	return h->max_us;
+}
+
+static void lat_report(char const *name, lat_hist_t const *h)
+{
+	if (h->num_cmds == 0) return;
+	uart_print("%s: %u cmds, %uMB, latency(us) p50 = %u, p90 = %u, "
+		   "p99 = %u, p99.9 = %u, max = %u",
+		   name, h->num_cmds, (UINT32)(h->num_sectors / 2048),
+		   lat_percentile(h, 500), lat_percentile(h, 900),
+		   lat_percentile(h, 990), lat_percentile(h, 999),
+		   h->max_us);
+}
+
+/* ===========================================================================
+ *  Run
+ * =========================================================================*/
+
+typedef struct {
+	UINT32	cmd_type;
+	UINT32	num_sectors;
+	/* the command is finished when so many tasks of its type finish */
+	UINT32	end_task;
+	UINT32	arrival_us;
+} inflight_cmd_t;
+
+static inflight_cmd_t	inflight_cmds[MAX_QUEUE_DEPTH];
+static UINT32		num_inflight_cmds;
+/* numbers of tasks accepted for READ and WRITE */
+static UINT32		num_tasks[2];
+
+/* results of the last run */
+static lat_hist_t	hists[2];	/* for READ and WRITE */
+static UINT32		num_issued, total_us;
+/* counters at the beginning and the end of the last run */
+static counters_t	base_counters, end_counters;
+
+static void issue(UINT32 const lba, UINT32 const num_sectors,
+		  UINT32 const cmd_type, UINT32 const session_key,
+		  UINT32 const arrival_us)
+{
+#if OPTION_ACL
+	while(eventq_put(lba, num_sectors, session_key, cmd_type))
+#else
+	while(eventq_put(lba, num_sectors, cmd_type))
+#endif
+		ftl_main();
+
+	/* ftl_main() accepts one task for every page of the command */
+	UINT32 lpn_begin = lba / SECTORS_PER_PAGE;
+	UINT32 lpn_end	 = (lba + num_sectors - 1) / SECTORS_PER_PAGE;
+	num_tasks[cmd_type] += lpn_end - lpn_begin + 1;
+
+	inflight_cmd_t *cmd = &inflight_cmds[num_inflight_cmds++];
+	cmd->cmd_type	 = cmd_type;
+	cmd->num_sectors = num_sectors;
+	cmd->end_task	 = num_tasks[cmd_type];
+	cmd->arrival_us	 = arrival_us;
+}
+
+static void reap(UINT32 const now_us)
+{
+	UINT32 num_finished_tasks[2] = {
+		sata_manager_num_finished_read_tasks(),
+		sata_manager_num_finished_write_tasks()
+	};
+
+	UINT32 i = 0;
+	while (i < num_inflight_cmds) {
+		inflight_cmd_t *cmd = &inflight_cmds[i];
+		if (num_finished_tasks[cmd->cmd_type] < cmd->end_task) {
+			i++;
+			continue;
+		}
+
+		lat_record(&hists[cmd->cmd_type], now_us - cmd->arrival_us,
+			   cmd->num_sectors);
+		*cmd = inflight_cmds[--num_inflight_cmds];
+	}
+}
+
+/* Run a workload to its end and leave the FTL idle */
+static void workload_run(workload_next_t next, UINT32 queue_depth,
+			 UINT32 const iops)
+{
+	queue_depth = MIN(MAX(queue_depth, 1), MAX_QUEUE_DEPTH);
+
+	mem_set_sram(hists, 0, sizeof(hists));
+	num_tasks[READ]	 = sata_manager_num_finished_read_tasks();
+	num_tasks[WRITE] = sata_manager_num_finished_write_tasks();
+	num_inflight_cmds = 0;
+
+	base_counters = g_counters;
+	waf_monitor_reset();
+#if OPTION_FLA_TRACE
+	/* trace only the commands of the workload */
+	fla_trace_init();
+#endif
+#if OPTION_PROFILING
+	profiler_init();
+#endif
+	clock_start();
+
+	UINT32	lba, num_sectors, cmd_type, session_key;
+	BOOL8	has_next = next(&lba, &num_sectors, &cmd_type, &session_key);
+	UINT32	now_us = 0;
+	num_issued = 0;
+	while (has_next || num_inflight_cmds) {
+		now_us = clock_us();
+		UINT32 arrival_us = iops ?
+			(UINT32)((UINT64)num_issued * 1000000 / iops) : now_us;
+		if (has_next && num_inflight_cmds < queue_depth &&
+		    arrival_us <= now_us) {
+			issue(lba, num_sectors, cmd_type, session_key,
+			      arrival_us);
+			num_issued++;
+			has_next = next(&lba, &num_sectors, &cmd_type,
+					&session_key);
+			continue;
+		}
+
+		ftl_main();
+		reap(clock_us());
+	}
+	total_us = MAX(now_us, 1);
+	end_counters = g_counters;
+
+	finish_all();
+}
+
+/* flash commands of the last run */
+static UINT32 workload_flash_cmds(bank_counter_id_t const id)
+{
+	UINT32 sum = 0;
+	for (UINT8 bank = 0; bank < NUM_BANKS; bank++)
+		sum += end_counters.bank_counters[id][bank] -
+		       base_counters.bank_counters[id][bank];
+	return sum;
+}
+
+static UINT32 workload_iops()
+{
+	return (UINT32)((UINT64)num_issued * 1000000 / total_us);
+}
+
+/* MB/s, which is also bytes per us */
+static UINT32 workload_throughput()
+{
+	return (UINT32)((hists[READ].num_sectors + hists[WRITE].num_sectors) *
+			BYTES_PER_SECTOR / total_us);
+}
+
+static void workload_report()
+{
+	UINT32 num_copybacks = end_counters.counters[COUNTER_FLASH_COPYBACKS] -
+			       base_counters.counters[COUNTER_FLASH_COPYBACKS];
+	uart_print("Summary: %u cmds in %ums, %u IOPS, %uMB/s",
+		   num_issued, total_us / 1000, workload_iops(),
+		   workload_throughput());
+	lat_report("read", &hists[READ]);
+	lat_report("write", &hists[WRITE]);
+	uart_print("flash: %u reads, %u programs, %u erases "
+		   "(including %u copybacks)",
+		   workload_flash_cmds(BANK_COUNTER_FLASH_READS),
+		   workload_flash_cmds(BANK_COUNTER_FLASH_PROGRAMS),
+		   workload_flash_cmds(BANK_COUNTER_FLASH_ERASES),
+		   num_copybacks);
+	waf_monitor_report();
+#if OPTION_PROFILING
+	profiler_report_phases();
+#endif
+}
+
+/* One line of the results of the last run for scripts; latencies are in us */
+static void workload_report_result(char const *name)
+{
+	uart_print("result name=%s cmds=%u us=%u iops=%u mbps=%u "
+		   "read_p50=%u read_p99=%u read_max=%u "
+		   "write_p50=%u write_p99=%u write_max=%u "
+		   "waf_percent=%u",
+		   name, num_issued, total_us, workload_iops(),
+		   workload_throughput(),
+		   lat_percentile(&hists[READ], 500),
+		   lat_percentile(&hists[READ], 990), hists[READ].max_us,
+		   lat_percentile(&hists[WRITE], 500),
+		   lat_percentile(&hists[WRITE], 990), hists[WRITE].max_us,
+		   counters_waf_percent(&base_counters));
+}
+
+#endif
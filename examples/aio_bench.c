@@ -0,0 +1,538 @@
+/*
+ * Benchmark TrustedSSD with concurrent sessions through Linux AIO
+ *
+ * Every session is a thread that opens the file on its own, sets its own
+ * session key and keeps a queue of direct I/Os in flight, each of a fixed
+ * size at a random offset of the session's slice of the file. Reads and
+ * writes are mixed by the read percentage. IOPS and latency percentiles are
+ * reported for every session and in total.
+ *
+ * Session keys reach the device only through direct I/O of a file on the
+ * modified ext4 (see kernel-patch), so the file must be on a TrustedSSD, or
+ * on the ramdisk of driver/tssd.c, mounted as ext4. Before the run, every
+ * session is opened on the device (see tssd_session()) to map its key to a
+ * user of its own, and it is closed after the run; otherwise the device
+ * serves all keys as the default user. Every slice is written with its key
+ * before it is measured, so that reads are of the session's own sectors.
+ * With -c, the same workload is run again with no keys, i.e. by the default
+ * user, and the difference is the overhead of ACL.
+ *
+ * AIO is used through system calls, as the kernel (3.2) has no io_uring and
+ * libaio is not needed for so little of it.
+ * */
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/aio_abi.h>
+
+#include "tssd.h"
+
+#define MAX_SESSIONS		64
+#define MAX_QUEUE_DEPTH		256
+#define PREFILL_BYTES		(1024 * 1024)
+
+typedef struct {
+	int		num_sessions;
+	int		queue_depth;
+	size_t		block_size;
+	int		read_percent;
+	int		seconds;
+	uint64_t	slice_bytes;
+	unsigned long	key_base;
+	unsigned int	uid_base;
+	int		use_keys;
+	const char*	device;
+	const char*	path;
+} options_t;
+
+static options_t opts = {
+	.num_sessions	= 4,
+	.queue_depth	= 32,
+	.block_size	= 4096,
+	.read_percent	= 70,
+	.seconds	= 10,
+	.slice_bytes	= 64ULL * 1024 * 1024,
+	.key_base	= 1,
+	.uid_base	= 1,
+	.use_keys	= 1,
+};
+
+/* ===========================================================================
+ *  Latency Histogram
+ *
+ *  Same as test_workload_common.h of the firmware: each power of two of us
+ *  is divided into 8 buckets, so a percentile is within 12.5%.
+ * =========================================================================*/
+
+#define LAT_SUB_BITS		3
+#define LAT_NUM_SUBS		(1 << LAT_SUB_BITS)
+#define LAT_NUM_BUCKETS		((32 - LAT_SUB_BITS + 1) * LAT_NUM_SUBS)
+
+typedef struct {
+	unsigned long	buckets[LAT_NUM_BUCKETS];
+	unsigned long	num_ios;
+	uint32_t	max_us;
+} lat_hist_t;
+
+static uint32_t lat_bucket(uint32_t us) {
+	if(us < LAT_NUM_SUBS)
+		return us;
+	uint32_t e = 31 - __builtin_clz(us);
+	return ((e - LAT_SUB_BITS + 1) << LAT_SUB_BITS) +
+		((us >> (e - LAT_SUB_BITS)) & (LAT_NUM_SUBS - 1));
+}
+
+/* the largest latency that falls into the bucket */
+static uint32_t lat_bucket_max(uint32_t b) {
+	if(b < LAT_NUM_SUBS)
+		return b;
+	uint32_t e = (b >> LAT_SUB_BITS) + LAT_SUB_BITS - 1;
+	uint32_t lower = (LAT_NUM_SUBS + (b & (LAT_NUM_SUBS - 1))) <<
+			 (e - LAT_SUB_BITS);
+	return lower + (1 << (e - LAT_SUB_BITS)) - 1;
+}
+
+static void lat_record(lat_hist_t* h, uint32_t us) {
+	h->buckets[lat_bucket(us)]++;
+	h->num_ios++;
+	if(us > h->max_us)
+		h->max_us = us;
+}
+
+static void lat_merge(lat_hist_t* h, const lat_hist_t* other) {
+	int b;
+	for(b = 0; b < LAT_NUM_BUCKETS; b++)
+		h->buckets[b] += other->buckets[b];
+	h->num_ios += other->num_ios;
+	if(other->max_us > h->max_us)
+		h->max_us = other->max_us;
+}
+
+/* latency under which *per_mille* of I/Os finish */
+static uint32_t lat_percentile(const lat_hist_t* h, unsigned per_mille) {
+	unsigned long target = (h->num_ios * per_mille + 999) / 1000;
+	unsigned long count = 0;
+	int b;
+	for(b = 0; b < LAT_NUM_BUCKETS; b++) {
+		count += h->buckets[b];
+		if(count >= target && count > 0) {
+			uint32_t us = lat_bucket_max(b);
+			return us < h->max_us ? us : h->max_us;
+		}
+	}
+	return h->max_us;
+}
+
+/* ===========================================================================
+ *  AIO
+ * =========================================================================*/
+
+static int io_setup(unsigned nr, aio_context_t* ctx) {
+	return syscall(__NR_io_setup, nr, ctx);
+}
+
+static int io_destroy(aio_context_t ctx) {
+	return syscall(__NR_io_destroy, ctx);
+}
+
+static int io_submit(aio_context_t ctx, long n, struct iocb** iocbs) {
+	return syscall(__NR_io_submit, ctx, n, iocbs);
+}
+
+static int io_getevents(aio_context_t ctx, long min_nr, long nr,
+			struct io_event* events) {
+	return syscall(__NR_io_getevents, ctx, min_nr, nr, events, NULL);
+}
+
+static uint64_t now_us(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/* ===========================================================================
+ *  Session
+ * =========================================================================*/
+
+typedef struct {
+	struct iocb	iocb;
+	void*		buf;
+	uint64_t	start_us;
+} slot_t;
+
+typedef struct {
+	int		index;
+	unsigned long	skey;
+	pthread_t	thread;
+	/* results */
+	lat_hist_t	hist;
+	unsigned long	num_errors;
+	uint64_t	num_bytes;
+	uint64_t	elapsed_us;
+	const char*	failure;
+	int		error;
+} session_t;
+
+static session_t sessions[MAX_SESSIONS];
+static pthread_barrier_t start_barrier;
+static int device_fd = -1;
+
+static void fail(session_t* s, const char* failure) {
+	s->failure = failure;
+	s->error = errno;
+}
+
+static int prefill(int fd, uint64_t base) {
+	void* buf = tssd_malloc(PREFILL_BYTES);
+	if(!buf)
+		return -1;
+	memset(buf, 0xA5, PREFILL_BYTES);
+
+	uint64_t off;
+	for(off = 0; off < opts.slice_bytes; off += PREFILL_BYTES) {
+		size_t n = opts.slice_bytes - off < PREFILL_BYTES ?
+			   opts.slice_bytes - off : PREFILL_BYTES;
+		if(pwrite(fd, buf, n, base + off) != (ssize_t)n) {
+			free(buf);
+			return -1;
+		}
+	}
+	free(buf);
+	return 0;
+}
+
+static void prepare(slot_t* slot, int fd, uint64_t base, unsigned* seed) {
+	uint64_t num_blocks = opts.slice_bytes / opts.block_size;
+	uint64_t block = (((uint64_t)rand_r(seed) << 31) | rand_r(seed)) %
+			 num_blocks;
+	int is_read = rand_r(seed) % 100 < opts.read_percent;
+
+	memset(&slot->iocb, 0, sizeof(slot->iocb));
+	slot->iocb.aio_data	  = (uint64_t)(uintptr_t)slot;
+	slot->iocb.aio_lio_opcode = is_read ? IOCB_CMD_PREAD : IOCB_CMD_PWRITE;
+	slot->iocb.aio_fildes	  = fd;
+	slot->iocb.aio_buf	  = (uint64_t)(uintptr_t)slot->buf;
+	slot->iocb.aio_nbytes	  = opts.block_size;
+	slot->iocb.aio_offset	  = base + block * opts.block_size;
+	slot->start_us		  = now_us();
+}
+
+static int submit_all(aio_context_t ctx, struct iocb** iocbs, int n) {
+	while(n > 0) {
+		int ret = io_submit(ctx, n, iocbs);
+		if(ret < 0 && errno == EAGAIN)
+			continue;
+		if(ret <= 0)
+			return -1;
+		iocbs += ret;
+		n -= ret;
+	}
+	return 0;
+}
+
+static void* session_run(void* arg) {
+	session_t* s = (session_t*) arg;
+	int qd = opts.queue_depth;
+	uint64_t base = (uint64_t)s->index * opts.slice_bytes;
+	unsigned seed = s->index + 1;
+	aio_context_t ctx = 0;
+	slot_t slots[MAX_QUEUE_DEPTH];
+	struct iocb* iocbs[MAX_QUEUE_DEPTH];
+	struct io_event events[MAX_QUEUE_DEPTH];
+	int i, num_slots = 0;
+
+	int fd = tssd_open(opts.path, O_RDWR | O_CREAT,
+			   S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
+	if(fd < 0)
+		fail(s, "failed to open file");
+	else if(opts.use_keys && tssd_use_session_key(fd, s->skey))
+		fail(s, "failed to set session key");
+	else if(prefill(fd, base))
+		fail(s, "failed to prefill");
+	else if(io_setup(qd, &ctx))
+		fail(s, "failed to set up AIO");
+	for(; !s->failure && num_slots < qd; num_slots++) {
+		slots[num_slots].buf = tssd_malloc(opts.block_size);
+		if(!slots[num_slots].buf)
+			fail(s, "failed to allocate buffer");
+		else
+			memset(slots[num_slots].buf, 0x5A, opts.block_size);
+	}
+
+	/* all sessions are measured over the same time */
+	pthread_barrier_wait(&start_barrier);
+	if(s->failure)
+		goto out;
+
+	uint64_t begin = now_us();
+	uint64_t deadline = begin + (uint64_t)opts.seconds * 1000000;
+	for(i = 0; i < qd; i++) {
+		prepare(&slots[i], fd, base, &seed);
+		iocbs[i] = &slots[i].iocb;
+	}
+	if(submit_all(ctx, iocbs, qd)) {
+		fail(s, "failed to submit");
+		goto out;
+	}
+
+	int num_inflight = qd;
+	while(num_inflight > 0) {
+		int n = io_getevents(ctx, 1, num_inflight, events);
+		if(n < 0 && errno == EINTR)
+			continue;
+		if(n < 0) {
+			fail(s, "failed to get events");
+			break;
+		}
+		uint64_t now = now_us();
+		int num_resubmits = 0;
+		for(i = 0; i < n; i++) {
+			slot_t* slot = (slot_t*)(uintptr_t)events[i].data;
+			lat_record(&s->hist, now - slot->start_us);
+			/* e.g. a read of a sector of another user */
+			if(events[i].res != (int64_t)opts.block_size)
+				s->num_errors++;
+			else
+				s->num_bytes += opts.block_size;
+			num_inflight--;
+
+			if(now >= deadline)
+				continue;
+			prepare(slot, fd, base, &seed);
+			iocbs[num_resubmits++] = &slot->iocb;
+		}
+		if(submit_all(ctx, iocbs, num_resubmits)) {
+			fail(s, "failed to submit");
+			break;
+		}
+		num_inflight += num_resubmits;
+	}
+	s->elapsed_us = now_us() - begin;
+
+out:
+	if(ctx)
+		io_destroy(ctx);
+	for(i = 0; i < num_slots; i++)
+		free(slots[i].buf);
+	if(fd >= 0)
+		close(fd);
+	return NULL;
+}
+
+/* map the key of every session to a user of its own, or unmap them */
+static int set_sessions(unsigned int op) {
+	struct tssd_session_entry entries[MAX_SESSIONS];
+	int i;
+	for(i = 0; i < opts.num_sessions; i++) {
+		entries[i].skey = opts.key_base + i;
+		entries[i].uid	= opts.uid_base + i;
+	}
+	return tssd_session(device_fd, op, entries, opts.num_sessions);
+}
+
+/* ===========================================================================
+ *  Report
+ * =========================================================================*/
+
+typedef struct {
+	double		iops;
+	uint32_t	p50, p99, p999;
+} summary_t;
+
+static double iops_of(uint64_t num_ios, uint64_t elapsed_us) {
+	return elapsed_us ? num_ios * 1000000.0 / elapsed_us : 0;
+}
+
+static void print_row(const char* name, unsigned long skey, int has_key,
+		      double iops, double mbps, const lat_hist_t* h,
+		      unsigned long num_errors) {
+	char key[16] = "-";
+	if(has_key)
+		snprintf(key, sizeof(key), "%lu", skey);
+	printf("%-8s %10s %10.0f %8.1f %8u %8u %9u %8u %7lu\n",
+	       name, key, iops, mbps, lat_percentile(h, 500),
+	       lat_percentile(h, 990), lat_percentile(h, 999), h->max_us,
+	       num_errors);
+}
+
+static int run(summary_t* summary) {
+	int i;
+	printf("%s: %d sessions, queue depth %d, %zu bytes, read %d%%, "
+	       "%lluMB each, %ds\n",
+	       opts.use_keys ? "with session keys" : "without session keys",
+	       opts.num_sessions, opts.queue_depth, opts.block_size,
+	       opts.read_percent,
+	       (unsigned long long)(opts.slice_bytes / (1024 * 1024)),
+	       opts.seconds);
+
+	if(opts.use_keys && set_sessions(TSSD_SESSION_OPEN)) {
+		printf("Error: failed to open sessions on device\n");
+		return -1;
+	}
+
+	memset(sessions, 0, sizeof(sessions));
+	pthread_barrier_init(&start_barrier, NULL, opts.num_sessions);
+	for(i = 0; i < opts.num_sessions; i++) {
+		sessions[i].index = i;
+		sessions[i].skey = opts.key_base + i;
+		if(pthread_create(&sessions[i].thread, NULL, session_run,
+				  &sessions[i])) {
+			printf("Error: failed to create thread\n");
+			exit(-1);
+		}
+	}
+	for(i = 0; i < opts.num_sessions; i++)
+		pthread_join(sessions[i].thread, NULL);
+	pthread_barrier_destroy(&start_barrier);
+
+	if(opts.use_keys && set_sessions(TSSD_SESSION_CLOSE)) {
+		printf("Error: failed to close sessions on device\n");
+		return -1;
+	}
+
+	int failed = 0;
+	for(i = 0; i < opts.num_sessions; i++) {
+		if(!sessions[i].failure)
+			continue;
+		printf("Error: session %d: %s: %s\n", i, sessions[i].failure,
+		       strerror(sessions[i].error));
+		failed = 1;
+	}
+	if(failed)
+		return -1;
+
+	printf("%-8s %10s %10s %8s %8s %8s %9s %8s %7s\n", "session", "key",
+	       "IOPS", "MB/s", "p50(us)", "p99(us)", "p99.9(us)", "max(us)",
+	       "errors");
+	lat_hist_t total;
+	memset(&total, 0, sizeof(total));
+	double total_iops = 0, total_mbps = 0;
+	unsigned long total_errors = 0;
+	for(i = 0; i < opts.num_sessions; i++) {
+		session_t* s = &sessions[i];
+		double iops = iops_of(s->hist.num_ios, s->elapsed_us);
+		double mbps = s->elapsed_us ?
+			      (double)s->num_bytes / s->elapsed_us : 0;
+		char name[16];
+		snprintf(name, sizeof(name), "%d", i);
+		print_row(name, s->skey, opts.use_keys, iops, mbps, &s->hist,
+			  s->num_errors);
+		lat_merge(&total, &s->hist);
+		total_iops += iops;
+		total_mbps += mbps;
+		total_errors += s->num_errors;
+	}
+	print_row("total", 0, 0, total_iops, total_mbps, &total,
+		  total_errors);
+
+	summary->iops = total_iops;
+	summary->p50  = lat_percentile(&total, 500);
+	summary->p99  = lat_percentile(&total, 990);
+	summary->p999 = lat_percentile(&total, 999);
+	return 0;
+}
+
+static double change(double with, double without) {
+	return without ? 100.0 * (with - without) / without : 0;
+}
+
+static void usage(void) {
+	printf("Usage: aio_bench [options] -d <device> <file on the device>\n"
+	       "  -d <dev>   device to open sessions on, e.g. /dev/sdb; not\n"
+	       "             needed with -n\n"
+	       "  -s <n>     sessions, each with its own key (default %d)\n"
+	       "  -q <n>     queue depth of each session (default %d)\n"
+	       "  -b <n>     bytes of an I/O, a multiple of %d (default %zu)\n"
+	       "  -r <n>     percentage of reads (default %d)\n"
+	       "  -t <n>     seconds to run (default %d)\n"
+	       "  -S <n>     MB of the file for each session (default %llu)\n"
+	       "  -k <n>     key of the first session (default %lu)\n"
+	       "  -u <n>     user id of the first session (default %u)\n"
+	       "  -n         use no keys\n"
+	       "  -c         run with keys, then with none, and compare\n",
+	       opts.num_sessions, opts.queue_depth, TSSD_MEM_ALIGNMENT,
+	       opts.block_size, opts.read_percent, opts.seconds,
+	       (unsigned long long)(opts.slice_bytes / (1024 * 1024)),
+	       opts.key_base, opts.uid_base);
+}
+
+int main(int argc, char** argv) {
+	int c, compare = 0;
+	while((c = getopt(argc, argv, "d:s:q:b:r:t:S:k:u:nch")) != -1) {
+		switch(c) {
+		case 'd': opts.device = optarg; break;
+		case 's': opts.num_sessions = atoi(optarg); break;
+		case 'q': opts.queue_depth = atoi(optarg); break;
+		case 'b': opts.block_size = strtoul(optarg, NULL, 0); break;
+		case 'r': opts.read_percent = atoi(optarg); break;
+		case 't': opts.seconds = atoi(optarg); break;
+		case 'S': opts.slice_bytes = strtoull(optarg, NULL, 0) *
+					     1024 * 1024; break;
+		case 'k': opts.key_base = strtoul(optarg, NULL, 0); break;
+		case 'u': opts.uid_base = strtoul(optarg, NULL, 0); break;
+		case 'n': opts.use_keys = 0; break;
+		case 'c': compare = 1; break;
+		default: usage(); return -1;
+		}
+	}
+	if(optind >= argc) {
+		usage();
+		return -1;
+	}
+	opts.path = argv[optind];
+
+	if(opts.num_sessions < 1 || opts.num_sessions > MAX_SESSIONS ||
+	   opts.queue_depth < 1 || opts.queue_depth > MAX_QUEUE_DEPTH ||
+	   opts.block_size == 0 || opts.block_size % TSSD_MEM_ALIGNMENT ||
+	   opts.read_percent < 0 || opts.read_percent > 100 ||
+	   opts.seconds < 1 || opts.slice_bytes < opts.block_size ||
+	   ((opts.use_keys || compare) && !opts.device)) {
+		printf("Error: invalid options\n");
+		usage();
+		return -1;
+	}
+
+	if(opts.device) {
+		device_fd = open(opts.device, O_RDWR | O_NONBLOCK);
+		if(device_fd < 0) {
+			printf("Error: failed to open device\n");
+			return -1;
+		}
+	}
+
+	summary_t with_keys, without_keys;
+	int ret = 0;
+	if(!compare) {
+		ret = run(opts.use_keys ? &with_keys : &without_keys);
+		goto out;
+	}
+
+	opts.use_keys = 1;
+	if((ret = run(&with_keys)))
+		goto out;
+	printf("\n");
+	opts.use_keys = 0;
+	if((ret = run(&without_keys)))
+		goto out;
+	printf("\nACL overhead: IOPS %+.1f%%, p50 %+.1f%%, p99 %+.1f%%, "
+	       "p99.9 %+.1f%%\n",
+	       change(with_keys.iops, without_keys.iops),
+	       change(with_keys.p50, without_keys.p50),
+	       change(with_keys.p99, without_keys.p99),
+	       change(with_keys.p999, without_keys.p999));
+out:
+	if(device_fd >= 0)
+		close(device_fd);
+	return ret;
+}
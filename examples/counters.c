@@ -0,0 +1,79 @@
+/*
+ * Read performance counters of TrustedSSD
+ *
+ * Counters are exported by the firmware as the vendor specific SMART log 0xA0
+ * (see counters.h of the firmware). Counters wrap around; take the difference
+ * of two readings.
+ * */
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "tssd.h"
+
+#define TSSD_LOG_COUNTERS	0xA0
+#define COUNTERS_MAGIC		0x43505354
+
+/* in the order of counter_id_t and bank_counter_id_t of the firmware */
+static const char* counter_names[] = {
+	"host_read_sectors", "host_write_sectors",
+	"flash_read_sectors", "flash_write_sectors", "flash_copybacks",
+	"pmt_lookups", "pmt_misses", "pmt_flushes",
+	"write_buffer_hit_sectors", "write_buffer_flushes",
+	"write_buffer_flush_sectors",
+	"lock_waits",
+	"thread_samples", "thread_occupancy", "thread_peak",
+	"user_program_sub_pages", "pmt_program_sub_pages",
+	"meta_program_sub_pages", "gc_program_sub_pages",
+	"waf_percent", "pmt_overhead_percent"
+};
+static const char* bank_counter_names[] = {
+	"flash_reads", "flash_programs", "flash_erases"
+};
+#define NUM_NAMES(names)	(sizeof(names) / sizeof(names[0]))
+
+int main(int argc, char** argv) {
+	if(argc < 2) {
+		printf("Usage: counters <device, e.g. /dev/sdb>\n");
+		return -1;
+	}
+
+	int fd = open(argv[1], O_RDONLY | O_NONBLOCK);
+	if(fd < 0) {
+		printf("Error: failed to open device\n");
+		return -1;
+	}
+
+	uint32_t log[TSSD_LOG_BYTES / sizeof(uint32_t)];
+	if(tssd_read_log(fd, TSSD_LOG_COUNTERS, log) || log[0] != COUNTERS_MAGIC) {
+		printf("Error: failed to read counters from device\n");
+		close(fd);
+		return -1;
+	}
+	close(fd);
+
+	/* header: magic, version, num_counters, num_banks */
+	uint32_t num_counters = log[2], num_banks = log[3];
+	uint32_t *counters = &log[4];
+	uint32_t *bank_counters = counters + num_counters;
+	if(4 + num_counters + NUM_NAMES(bank_counter_names) * num_banks
+	   > NUM_NAMES(log)) {
+		printf("Error: malformed counters log\n");
+		return -1;
+	}
+
+	printf("version %u\n", log[1]);
+	uint32_t i, b;
+	for(i = 0; i < num_counters; i++) {
+		if(i < NUM_NAMES(counter_names))
+			printf("%s %u\n", counter_names[i], counters[i]);
+		else
+			printf("counter_%u %u\n", i, counters[i]);
+	}
+	for(i = 0; i < NUM_NAMES(bank_counter_names); i++)
+		for(b = 0; b < num_banks; b++)
+			printf("%s{bank=%u} %u\n", bank_counter_names[i], b,
+			       bank_counters[i * num_banks + b]);
+	return 0;
+}
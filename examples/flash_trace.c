@@ -0,0 +1,56 @@
+/*
+ * Drain the flash trace of TrustedSSD
+ *
+ * Flash commands are traced by the firmware into a ring buffer, which is read
+ * one sector at a time as the vendor specific SMART log 0xA1 (see fla.h of
+ * the firmware). The sectors are saved as they are, to be converted into a
+ * timeline by test/util/fla_trace2json.py.
+ * */
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "tssd.h"
+
+#define TSSD_LOG_FLASH_TRACE	0xA1
+#define FLA_TRACE_MAGIC		0x54465354
+
+int main(int argc, char** argv) {
+	if(argc < 3) {
+		printf("Usage: flash_trace <device, e.g. /dev/sdb> <output>\n");
+		return -1;
+	}
+
+	int fd = open(argv[1], O_RDONLY | O_NONBLOCK);
+	if(fd < 0) {
+		printf("Error: failed to open device\n");
+		return -1;
+	}
+	FILE* out = fopen(argv[2], "wb");
+	if(!out) {
+		printf("Error: failed to open output\n");
+		close(fd);
+		return -1;
+	}
+
+	/* header: magic, version, num_events, num_dropped, ticks_per_sec */
+	uint32_t log[TSSD_LOG_BYTES / sizeof(uint32_t)];
+	unsigned long num_events = 0, num_dropped = 0;
+	do {
+		if(tssd_read_log(fd, TSSD_LOG_FLASH_TRACE, log) ||
+		   log[0] != FLA_TRACE_MAGIC) {
+			printf("Error: failed to read flash trace from device\n");
+			break;
+		}
+		num_events += log[2];
+		num_dropped += log[3];
+		if(log[2])
+			fwrite(log, sizeof(log), 1, out);
+	} while(log[2]);
+
+	printf("%lu events saved, %lu dropped\n", num_events, num_dropped);
+	fclose(out);
+	close(fd);
+	return 0;
+}
@@ -0,0 +1,62 @@
+/*
+ * Manage sessions of TrustedSSD
+ *
+ * Sessions map session keys to user ids on the device (see acl.h of the
+ * firmware). A session must be opened before a process uses its key (see
+ * tssd_use_session_key()), or the device serves the process as the default
+ * user.
+ * */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+
+#include "tssd.h"
+
+static void usage() {
+	printf("Usage: session <device, e.g. /dev/sdb> open <session_key> <uid>\n"
+	       "       session <device> close <session_key>\n"
+	       "       session <device> revoke <uid>\n");
+}
+
+int main(int argc, char** argv) {
+	if(argc < 4) {
+		usage();
+		return -1;
+	}
+
+	struct tssd_session_entry entry = {0, 0};
+	unsigned int op;
+	if(strcmp(argv[2], "open") == 0 && argc >= 5) {
+		op = TSSD_SESSION_OPEN;
+		entry.skey = strtoul(argv[3], NULL, 0);
+		entry.uid = strtoul(argv[4], NULL, 0);
+	}
+	else if(strcmp(argv[2], "close") == 0) {
+		op = TSSD_SESSION_CLOSE;
+		entry.skey = strtoul(argv[3], NULL, 0);
+	}
+	else if(strcmp(argv[2], "revoke") == 0) {
+		op = TSSD_SESSION_REVOKE;
+		entry.uid = strtoul(argv[3], NULL, 0);
+	}
+	else {
+		usage();
+		return -1;
+	}
+
+	int fd = open(argv[1], O_RDWR | O_NONBLOCK);
+	if(fd < 0) {
+		printf("Error: failed to open device\n");
+		return -1;
+	}
+
+	if(tssd_session(fd, op, &entry, 1)) {
+		printf("Error: failed to send session command to device\n");
+		close(fd);
+		return -1;
+	}
+	close(fd);
+	return 0;
+}
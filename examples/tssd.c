@@ -8,6 +8,9 @@
 #include <stdio.h>
 #include <sys/ioctl.h>
 #include <sys/stat.h>
+#include <string.h>
+#include <stdint.h>
+#include <scsi/sg.h>
 #include "tssd.h"
 
 #define TSSD_CMD_SET_SESSION_KEY	_IOW('f', 20, unsigned long)
@@ -32,7 +35,113 @@ void* tssd_malloc(size_t size) {
 	return res;
 }
 
-void tssd_use_session_key(int fd, unsigned long skey) {
-    ioctl(fd, TSSD_CMD_SET_SESSION_KEY, skey);
+int tssd_use_session_key(int fd, unsigned long skey) {
+    return ioctl(fd, TSSD_CMD_SET_SESSION_KEY, skey);
 }
 
+#define ATA_PASS_THROUGH_12	0xA1
+#define ATA_PROTOCOL_PIO_IN	(4 << 1)
+#define ATA_PROTOCOL_PIO_OUT	(5 << 1)
+#define ATA_SMART		0xB0
+#define SMART_READ_LOG		0xD5
+#define ATA_TSSD_SESSION	0xFA
+
+/* SMART READ LOG through SCSI ATA PASS-THROUGH, as smartctl does */
+int tssd_read_log(int fd, unsigned char log_addr, void* buf) {
+	unsigned char cdb[12] = {
+		ATA_PASS_THROUGH_12,
+		ATA_PROTOCOL_PIO_IN,
+		/* T_DIR = from device, BYT_BLOK = 1, T_LENGTH = sector count */
+		0x0E,
+		SMART_READ_LOG,		/* features */
+		1,			/* sector count */
+		log_addr,		/* LBA low */
+		0x4F, 0xC2,		/* LBA mid and high */
+		0,			/* device */
+		ATA_SMART,
+		0, 0
+	};
+	unsigned char sense[32];
+	sg_io_hdr_t io;
+
+	memset(&io, 0, sizeof(io));
+	io.interface_id		= 'S';
+	io.dxfer_direction	= SG_DXFER_FROM_DEV;
+	io.cmd_len		= sizeof(cdb);
+	io.cmdp			= cdb;
+	io.dxfer_len		= TSSD_LOG_BYTES;
+	io.dxferp		= buf;
+	io.mx_sb_len		= sizeof(sense);
+	io.sbp			= sense;
+	io.timeout		= 5000;
+
+	if(ioctl(fd, SG_IO, &io) < 0)
+		return -1;
+	if(io.status || io.host_status || io.driver_status)
+		return -1;
+	return 0;
+}
+
+/* one sector of: op, num_entries, skey_0, uid_0, skey_1, uid_1, ... */
+#define SESSION_MAX_ENTRIES	(TSSD_LOG_BYTES / (2 * sizeof(uint32_t)) - 1)
+
+static int send_session_sector(int fd, const uint32_t* sector) {
+	unsigned char cdb[12] = {
+		ATA_PASS_THROUGH_12,
+		ATA_PROTOCOL_PIO_OUT,
+		/* T_DIR = to device, BYT_BLOK = 1, T_LENGTH = sector count */
+		0x06,
+		0,			/* features */
+		1,			/* sector count */
+		0, 0, 0,		/* LBA */
+		0,			/* device */
+		ATA_TSSD_SESSION,
+		0, 0
+	};
+	unsigned char sense[32];
+	sg_io_hdr_t io;
+
+	memset(&io, 0, sizeof(io));
+	io.interface_id		= 'S';
+	io.dxfer_direction	= SG_DXFER_TO_DEV;
+	io.cmd_len		= sizeof(cdb);
+	io.cmdp			= cdb;
+	io.dxfer_len		= TSSD_LOG_BYTES;
+	io.dxferp		= (void*)sector;
+	io.mx_sb_len		= sizeof(sense);
+	io.sbp			= sense;
+	io.timeout		= 5000;
+
+	if(ioctl(fd, SG_IO, &io) < 0)
+		return -1;
+	if(io.status || io.host_status || io.driver_status)
+		return -1;
+	return 0;
+}
+
+int tssd_session(int fd, unsigned int op,
+		 const struct tssd_session_entry* entries,
+		 unsigned int num_entries) {
+	uint32_t sector[TSSD_LOG_BYTES / sizeof(uint32_t)];
+
+	/* the firmware takes up to SESSION_MAX_ENTRIES entries per command */
+	while(num_entries > 0) {
+		unsigned int n = num_entries < SESSION_MAX_ENTRIES ?
+					num_entries : SESSION_MAX_ENTRIES;
+		unsigned int i;
+
+		memset(sector, 0, sizeof(sector));
+		sector[0] = op;
+		sector[1] = n;
+		for(i = 0; i < n; i++) {
+			sector[2 + 2 * i]	= entries[i].skey;
+			sector[2 + 2 * i + 1]	= entries[i].uid;
+		}
+		if(send_session_sector(fd, sector))
+			return -1;
+
+		entries += n;
+		num_entries -= n;
+	}
+	return 0;
+}
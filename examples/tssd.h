@@ -8,6 +8,30 @@
 
 int tssd_open(const char* pathname, int flags, ...);
 void* tssd_malloc(size_t size);
-void tssd_use_session_key(int fd, unsigned long skey); 
+/* Return 0, or -1 if the file is not on a file system that takes keys */
+int tssd_use_session_key(int fd, unsigned long skey);
+
+/* Read one sector of a vendor specific SMART log of the device */
+#define TSSD_LOG_BYTES			512
+int tssd_read_log(int fd, unsigned char log_addr, void* buf);
+
+/* Sub-commands of the TrustedSSD session vendor command (see sata_cmd.h of
+ * the firmware) */
+#define TSSD_SESSION_OPEN		0x01
+#define TSSD_SESSION_CLOSE		0x02
+#define TSSD_SESSION_REVOKE		0x04
+
+struct tssd_session_entry {
+	unsigned int skey;
+	unsigned int uid;
+};
+
+/* Open or close sessions (skey -> uid) or revoke users on the device.
+ * Sessions must be opened before I/O with their keys, or the device serves it
+ * as the default user. uid is ignored by close, skey by revoke.
+ * Return 0, or -1 on failure */
+int tssd_session(int fd, unsigned int op,
+		 const struct tssd_session_entry* entries,
+		 unsigned int num_entries);
 
 #endif
@@ -0,0 +1,152 @@
+#!/usr/bin/python
+
+# Run the benchmark suite of the firmware (test_tssd/test_bench.c) and compare
+# its results against the stored baselines.
+#
+# By default the suite is built and run on the host build (build_sim), whose
+# numbers are in the virtual time of the hardware model and are thus
+# repeatable. The UART output of a run on the board can be given by --log
+# instead. Results are the 'result name=... key=value ...' lines of the output.
+# Workloads over the whole disk are run on a second build of a reduced disk,
+# which can be filled up in a few minutes.
+#
+# A metric regresses if it is worse than the baseline by more than its
+# tolerance in percent; throughput is better when higher, latency and write
+# amplification when lower. The script exits with 1 on any regression, so it
+# can gate changes of the FTL. Baselines are rewritten by --update.
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+
+ROOT = os.path.normpath(os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                                    '..', '..'))
+BUILD_SIM = os.path.join(ROOT, 'OpenSSD', '1.0.6', 'build_sim')
+BASELINE = os.path.join(ROOT, 'data', 'bench_baseline.json')
+
+HIGHER_IS_BETTER = ['iops', 'mbps']
+LOWER_IS_BETTER = ['read_p50', 'read_p99', 'read_max',
+                   'write_p50', 'write_p99', 'write_max', 'waf_percent']
+# workloads of footprint 0 in test_bench.c, run on a disk of about 1GB
+WHOLE_DISK_WORKLOADS = ['steady_write_4k']
+REDUCED_DISK_DEFINES = 'BANK_BMP=0x0001 _PBLKS_PER_BANK=512'
+# max latency of a run on the board is noisy
+DEFAULT_TOLERANCE = {'default': 5, 'read_max': 25, 'write_max': 25}
+
+def parse_results(output):
+  results = {}
+  for line in output.splitlines():
+    words = line.split()
+    if not words or words[0] != 'result':
+      continue
+    fields = dict(w.split('=', 1) for w in words[1:] if '=' in w)
+    name = fields.pop('name')
+    results[name] = dict((k, int(v)) for k, v in fields.items())
+  return results
+
+def run_build(env, make_args=None):
+  if make_args is not None:
+    subprocess.check_call(['make', 'clean'], cwd=BUILD_SIM)
+    subprocess.check_call(['make', 'TEST=bench'] + make_args, cwd=BUILD_SIM,
+                          stdout=subprocess.DEVNULL)
+  output = subprocess.check_output(['./sim'], cwd=BUILD_SIM, env=env,
+                                   stderr=subprocess.STDOUT)
+  output = output.decode('ascii', 'replace')
+  if 'FTL passed unit test' not in output:
+    sys.stdout.write(output)
+    raise SystemExit('benchmark did not finish')
+  return output
+
+def run_sim(args):
+  env = dict(os.environ)
+  if args.bench:
+    env['BENCH'] = args.bench
+  for override in args.set:
+    key, val = override.split('=', 1)
+    env['BENCH_' + key.upper()] = val
+  if args.no_build:
+    return run_build(env)
+
+  outputs = []
+  if args.bench not in WHOLE_DISK_WORKLOADS:
+    outputs.append(run_build(env, []))
+  for name in WHOLE_DISK_WORKLOADS:
+    if args.bench in (None, name):
+      env['BENCH'] = name
+      outputs.append(run_build(env, ['DEFINES=' + REDUCED_DISK_DEFINES]))
+  return '\n'.join(outputs)
+
+def compare(results, baseline):
+  tolerance = baseline.get('tolerance_percent', DEFAULT_TOLERANCE)
+  regressions = 0
+  print('%-16s %-12s %12s %12s %8s' %
+        ('workload', 'metric', 'baseline', 'result', 'change'))
+  for name in sorted(results):
+    base = baseline['results'].get(name)
+    if base is None:
+      print('%-16s (no baseline)' % name)
+      continue
+    for metric in HIGHER_IS_BETTER + LOWER_IS_BETTER:
+      old, new = base.get(metric, 0), results[name].get(metric, 0)
+      # 0 means not applicable, e.g. read latency of a write-only workload
+      if old == 0 or new == 0:
+        continue
+      change = 100.0 * (new - old) / old
+      worse = -change if metric in HIGHER_IS_BETTER else change
+      limit = tolerance.get(metric, tolerance['default'])
+      mark = ''
+      if worse > limit:
+        mark = ' REGRESSION (> %d%%)' % limit
+        regressions += 1
+      print('%-16s %-12s %12d %12d %+7.1f%%%s' %
+            (name, metric, old, new, change, mark))
+  return regressions
+
+def bench():
+  parser = argparse.ArgumentParser(
+      description='Run the FTL benchmark and compare against baselines')
+  parser.add_argument('--log', help='UART output of a run on the board')
+  parser.add_argument('--bench', help='run only this workload')
+  parser.add_argument('--set', action='append', default=[],
+                      metavar='FIELD=VALUE',
+                      help='override a field of workloads, e.g. queue_depth=8')
+  parser.add_argument('--no-build', action='store_true',
+                      help='run the sim that is already built, without '
+                      'the second build for whole-disk workloads')
+  parser.add_argument('--baseline', default=BASELINE)
+  parser.add_argument('--json', help='save results into this file')
+  parser.add_argument('--update', action='store_true',
+                      help='save results as the new baselines')
+  args = parser.parse_args()
+
+  if args.log:
+    output = open(args.log, 'rb').read().decode('ascii', 'replace')
+  else:
+    output = run_sim(args)
+  results = parse_results(output)
+  if not results:
+    raise SystemExit('no results found')
+
+  if args.json:
+    json.dump(results, open(args.json, 'w'), indent=2, sort_keys=True)
+
+  if args.update:
+    baseline = {'tolerance_percent': DEFAULT_TOLERANCE, 'results': {}}
+    if os.path.exists(args.baseline):
+      baseline = json.load(open(args.baseline))
+    baseline['results'].update(results)
+    json.dump(baseline, open(args.baseline, 'w'), indent=2, sort_keys=True)
+    print('%d baselines saved to %s' % (len(results), args.baseline))
+    return 0
+
+  if not os.path.exists(args.baseline):
+    raise SystemExit('no baselines in %s; create them by --update'
+                     % args.baseline)
+  regressions = compare(results, json.load(open(args.baseline)))
+  print('%d regressions' % regressions)
+  return 1 if regressions else 0
+
+if __name__ == '__main__' :
+  sys.exit(bench())
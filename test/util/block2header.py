@@ -0,0 +1,48 @@
+#!/usr/bin/python
+
+# Convert a block trace of lines 'pid R/W offset size', as produced by
+# format2block.py, into a C header that test_trace_replay.c compiles into the
+# firmware. Offsets are in sectors and sizes in bytes.
+#
+# The firmware image has to fit into SRAM, so only short traces can be
+# embedded; the host build (build_sim) reads long traces from a file instead.
+
+import sys
+
+MAX_ENTRIES = 2048
+
+def block2header():
+  if len(sys.argv) < 3 :
+    print('\n\t Usage : block2header.py <trace> <header> [max_entries]\n')
+    return
+
+  max_entries = MAX_ENTRIES
+  if len(sys.argv) > 3 :
+    max_entries = int(sys.argv[3])
+
+  pf2r = open(sys.argv[1], 'r')
+  pf2w = open(sys.argv[2], 'w')
+
+  pf2w.write('/* Generated by test/util/block2header.py from %s */\n'
+             % sys.argv[1].split('/')[-1])
+  pf2w.write('/* TRACE_LINE(offset in sectors, size in bytes, R/W) */\n')
+
+  cnt = 0
+  for line in pf2r :
+    words = line.split()
+    if len(words) < 4 :
+      continue
+    if words[1] in ('W', 'w') :
+      cmd_type = 'WRITE'
+    else :
+      cmd_type = 'READ'
+    pf2w.write('TRACE_LINE(%s, %s, %s)\n' % (words[2], words[3], cmd_type))
+    cnt += 1
+    if cnt == max_entries :
+      break
+
+  pf2r.close()
+  pf2w.close()
+
+if __name__ == '__main__' :
+  block2header()
@@ -0,0 +1,130 @@
+#!/usr/bin/python
+
+# Convert a flash trace of the firmware (see fla.h) into a timeline in Chrome
+# trace format, which can be opened by chrome://tracing or Perfetto.
+#
+# The trace is either the UART output of fla_trace_dump(), i.e. lines of
+# 'fla_trace ...' mixed with other messages, or the binary sectors of vendor
+# SMART log TSSD_LOG_FLASH_TRACE as read by examples/flash_trace.
+#
+# The timeline has a track per bank, where a flash command lasts from its
+# issue to its completion and is named by its op and source, and the gaps
+# between commands are shown as idle. Occupancy of each bank is printed.
+
+import json
+import struct
+import sys
+
+FLA_TRACE_MAGIC = 0x54465354
+HEADER_WORDS = 8
+EVENT_WORDS = 4
+SECTOR_BYTES = 512
+
+OPS = ['read', 'program', 'erase', 'copyback', 'complete']
+OP_COMPLETE = 4
+SOURCES = ['none', 'user', 'pmt', 'meta', 'gc']
+NO_THREAD = 0xFF
+NULL_LPN = 0xFFFFFFFF
+
+def parse_text(data):
+  ticks_per_sec = None
+  events = []
+  for line in data.decode('ascii', 'replace').splitlines():
+    words = line.split()
+    if len(words) < 2 or words[0] != 'fla_trace':
+      continue
+    if words[1] == 'ticks_per_sec':
+      ticks_per_sec = int(words[2])
+      continue
+    events.append(tuple(int(w, 16) for w in words[1:5]))
+  return ticks_per_sec, events
+
+def parse_binary(data):
+  ticks_per_sec = None
+  events = []
+  for offset in range(0, len(data) - SECTOR_BYTES + 1, SECTOR_BYTES):
+    words = struct.unpack_from('<128I', data, offset)
+    if words[0] != FLA_TRACE_MAGIC:
+      continue
+    num_events, ticks_per_sec = words[2], words[4]
+    for i in range(num_events):
+      begin = HEADER_WORDS + i * EVENT_WORDS
+      events.append(words[begin:begin + EVENT_WORDS])
+  return ticks_per_sec, events
+
+def unwrap(events):
+  """Timestamps of a free-running 32-bit timer to monotonic ticks"""
+  last, base = None, 0
+  for ev in events:
+    if last is not None and ev[0] < last:
+      base += 1 << 32
+    last = ev[0]
+    yield (base + ev[0],) + tuple(ev[1:])
+
+def fla_trace2json():
+  if len(sys.argv) < 3 :
+    print('\n\t Usage : fla_trace2json.py <trace> <json>\n')
+    return
+
+  data = open(sys.argv[1], 'rb').read()
+  if data.startswith(struct.pack('<I', FLA_TRACE_MAGIC)):
+    ticks_per_sec, events = parse_binary(data)
+  else:
+    ticks_per_sec, events = parse_text(data)
+  if not events or not ticks_per_sec:
+    print('no flash trace in %s' % sys.argv[1])
+    return
+
+  def us(ticks):
+    return ticks * 1000000.0 / ticks_per_sec
+
+  events = list(unwrap(events))
+  t0 = events[0][0]
+  out = []
+  issued = {}                         # bank -> (ticks, event)
+  last_complete = {}                  # bank -> ticks
+  busy = {}                           # bank -> ticks
+  for ev in events:
+    ticks, info, lpn, vpn = ev
+    bank, op = info & 0xFF, (info >> 8) & 0xFF
+    tid, source = (info >> 16) & 0xFF, (info >> 24) & 0xFF
+    if op != OP_COMPLETE:
+      if bank in last_complete and ticks > last_complete[bank]:
+        out.append({'name': 'idle', 'ph': 'X', 'pid': 0, 'tid': bank,
+                    'ts': us(last_complete[bank] - t0),
+                    'dur': us(ticks - last_complete[bank]),
+                    'cat': 'idle'})
+      issued[bank] = (ticks, op)
+      continue
+
+    if bank not in issued:
+      continue
+    begin, op = issued.pop(bank)
+    last_complete[bank] = ticks
+    busy[bank] = busy.get(bank, 0) + ticks - begin
+    source_name = SOURCES[source] if source < len(SOURCES) else str(source)
+    args = {'vpn': vpn & 0xFFFFFF, 'sectors': vpn >> 24}
+    if tid != NO_THREAD:
+      args['thread'] = tid
+    if lpn != NULL_LPN:
+      args['lpn'] = lpn
+    out.append({'name': '%s %s' % (OPS[op], source_name), 'ph': 'X',
+                'pid': 0, 'tid': bank, 'ts': us(begin - t0),
+                'dur': us(ticks - begin), 'cat': source_name,
+                'args': args})
+
+  for bank in sorted(set(busy) | set(issued)):
+    out.append({'name': 'thread_name', 'ph': 'M', 'pid': 0, 'tid': bank,
+                'args': {'name': 'bank %d' % bank}})
+  out.append({'name': 'process_name', 'ph': 'M', 'pid': 0,
+              'args': {'name': 'flash'}})
+  json.dump({'traceEvents': out, 'displayTimeUnit': 'ms'},
+            open(sys.argv[2], 'w'))
+
+  total = events[-1][0] - t0
+  print('%d events in %.1fms' % (len(events), us(total) / 1000))
+  for bank in sorted(busy):
+    print('bank %2d: busy %5.1f%%' % (bank, 100.0 * busy[bank] / max(total, 1)))
+
+if __name__ == '__main__' :
+  fla_trace2json()
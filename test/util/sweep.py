@@ -0,0 +1,142 @@
+#!/usr/bin/python
+
+# Sweep the benchmark of the firmware (see bench.py) over configurations that
+# the board does not have, on the host build (build_sim).
+#
+# A configuration is a flash module layout (BANK_BMP of bank.h), the number
+# of threads (MAX_NUM_THREADS of jasmine.h), the numbers of page cache and
+# write buffers (dram.h) and a NAND timing profile of the model (sim.h). The
+# firmware is built for every combination of the values given, and every
+# workload of test_bench.c is run on it. Throughput and latency are
+# tabulated, together with the SATA buffers that are left in DRAM.
+#
+# Not all combinations work: bank.h has layouts of up to 32 banks, but the
+# FTL signals banks in 16 bits, and more than 16 threads do not fit in a page
+# lock. Such configurations fail to build, which is reported in the table, as
+# are halts and timeouts.
+
+import argparse
+import itertools
+import json
+import os
+import re
+import subprocess
+import sys
+
+from bench import BUILD_SIM, parse_results
+
+# NAND timings in ns: tR, tPROG, tBERS
+PROFILES = {
+  'slc': (25000, 250000, 1500000),
+  'mlc': (60000, 1300000, 3500000),
+  'tlc': (80000, 2300000, 5000000),
+}
+BOARD_BANK_BMP = '0x00FF00FF'
+
+COLUMNS = [('banks', 5), ('threads', 7), ('pc', 4), ('wbuf', 4),
+           ('profile', 7), ('sata_wr', 7), ('workload', 16), ('iops', 7),
+           ('mbps', 5), ('read_p99', 8), ('write_p99', 9),
+           ('waf_percent', 11)]
+
+def split(values):
+  return [v for v in values.split(',') if v]
+
+def build(defines):
+  subprocess.check_call(['make', 'clean'], cwd=BUILD_SIM)
+  make = subprocess.Popen(['make', 'TEST=bench', 'DEFINES=' + ' '.join(
+                           '%s=%s' % d for d in sorted(defines.items()))],
+                          cwd=BUILD_SIM, stdout=subprocess.PIPE,
+                          stderr=subprocess.STDOUT)
+  output = make.communicate()[0].decode('ascii', 'replace')
+  if make.returncode == 0:
+    return None
+  errors = re.findall(r'error: (.*)', output)
+  return 'build: ' + (errors[0] if errors else 'failed')
+
+def run(workload, timeout):
+  env = dict(os.environ, BENCH=workload)
+  sim = subprocess.Popen(['./sim'], cwd=BUILD_SIM, env=env,
+                         stdout=subprocess.PIPE, stderr=subprocess.STDOUT)
+  try:
+    output = sim.communicate(timeout=timeout)[0]
+  except subprocess.TimeoutExpired:
+    sim.kill()
+    sim.communicate()
+    return None, 'timeout'
+  output = output.decode('ascii', 'replace')
+  if 'FTL passed unit test' not in output:
+    halt = re.findall(r'^error: (.*)$', output, re.M)
+    return output, 'halt: ' + (halt[0] if halt else 'unknown')
+  return output, None
+
+def dram_layout(output):
+  m = re.search(r'# of SATA write buffers == (\d+)', output or '')
+  return int(m.group(1)) if m else 0
+
+def sweep():
+  parser = argparse.ArgumentParser(
+      description='Benchmark the FTL over simulated configurations')
+  parser.add_argument('--banks', default=BOARD_BANK_BMP +
+                      ',0x00333333,0x00330033',
+                      help='BANK_BMP values of bank.h')
+  parser.add_argument('--threads', default='16', help='MAX_NUM_THREADS')
+  parser.add_argument('--pc-buffers', default='',
+                      help='NUM_PC_BUFFERS (default of dram.h if empty)')
+  parser.add_argument('--write-buffers', default='',
+                      help='NUM_WRITE_BUFFERS (default of dram.h if empty)')
+  parser.add_argument('--profiles', default='mlc,slc',
+                      help='timing profiles: ' + ', '.join(sorted(PROFILES)))
+  parser.add_argument('--workloads',
+                      default='seq_write_128k,rand_write_4k,rand_read_4k,'
+                              'mixed_70r_4k',
+                      help='workloads of test_bench.c')
+  parser.add_argument('--timeout', type=int, default=600,
+                      help='seconds a workload may run')
+  parser.add_argument('--json', help='save the table into this file')
+  args = parser.parse_args()
+
+  rows = []
+  print(' '.join('%*s' % (w, c) for c, w in COLUMNS))
+  for bmp, threads, pc, wbuf, profile in itertools.product(
+      split(args.banks), split(args.threads),
+      split(args.pc_buffers) or [''], split(args.write_buffers) or [''],
+      split(args.profiles)):
+    t_r, t_prog, t_bers = PROFILES[profile]
+    defines = {'BANK_BMP': bmp, 'MAX_NUM_THREADS': threads,
+               'SIM_NAND_T_R_NS': t_r, 'SIM_NAND_T_PROG_NS': t_prog,
+               'SIM_NAND_T_BERS_NS': t_bers}
+    if pc:
+      defines['NUM_PC_BUFFERS'] = pc
+    if wbuf:
+      defines['NUM_WRITE_BUFFERS'] = wbuf
+    config = {'banks': bin(int(bmp, 16)).count('1'), 'bank_bmp': bmp,
+              'threads': int(threads), 'pc': pc or '-', 'wbuf': wbuf or '-',
+              'profile': profile}
+
+    error = build(defines)
+    for workload in split(args.workloads):
+      row = dict(config, workload=workload)
+      output = None
+      if not error:
+        output, failure = run(workload, args.timeout)
+      row['sata_wr'] = dram_layout(output)
+      result = parse_results(output or '').get(workload)
+      if error or failure or not result:
+        row['error'] = error or failure or 'no result'
+      else:
+        row.update(result)
+      rows.append(row)
+
+      line = ' '.join('%*s' % (w, row.get(c, '')) for c, w in COLUMNS[:7])
+      if 'error' in row:
+        print('%s %s' % (line, row['error']))
+      else:
+        print(' '.join([line] + ['%*s' % (w, row[c]) for c, w in COLUMNS[7:]]))
+      sys.stdout.flush()
+
+  subprocess.check_call(['make', 'clean'], cwd=BUILD_SIM)
+  if args.json:
+    json.dump(rows, open(args.json, 'w'), indent=2, sort_keys=True)
+
+if __name__ == '__main__' :
+  sweep()